@@ -24,6 +24,7 @@
 #define PLUTOVG_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -72,6 +73,125 @@ PLUTOVG_API int plutovg_version(void);
  */
 PLUTOVG_API const char* plutovg_version_string(void);
 
+/**
+ * @brief Defines the instruction set levels used by the blending kernels.
+ */
+typedef enum {
+    PLUTOVG_CPU_LEVEL_AUTO, ///< Use the best level supported by the running CPU.
+    PLUTOVG_CPU_LEVEL_SCALAR, ///< Portable C kernels only.
+    PLUTOVG_CPU_LEVEL_SSE2, ///< SSE2 kernels.
+    PLUTOVG_CPU_LEVEL_AVX2, ///< AVX2 kernels.
+    PLUTOVG_CPU_LEVEL_AVX512 ///< AVX-512 kernels.
+} plutovg_cpu_level_t;
+
+/**
+ * @brief Selects the instruction set level used by the blending kernels.
+ *
+ * The level is detected on first use. With `PLUTOVG_CPU_LEVEL_AUTO`, the
+ * `PLUTOVG_CPU_LEVEL` environment variable (`scalar`, `sse2`, `avx2` or `avx512`)
+ * is honored before falling back to detection. Levels above what the CPU
+ * supports are lowered to the best supported level.
+ *
+ * The kernel set is published atomically, so this function may be called while other
+ * threads render; drawing already in progress may finish with either set. Levels agree
+ * to within one unit per 8-bit channel.
+ *
+ * @param level The requested instruction set level.
+ */
+PLUTOVG_API void plutovg_set_cpu_level(plutovg_cpu_level_t level);
+
+/**
+ * @brief Gets the instruction set level used by the blending kernels.
+ * @return The effective instruction set level.
+ */
+PLUTOVG_API plutovg_cpu_level_t plutovg_get_cpu_level(void);
+
+/**
+ * @brief Sets the size above which opaque fills bypass the cache.
+ *
+ * Surface clears and full-coverage source fills whose destination rows span at least
+ * `threshold` bytes are written with non-temporal streaming stores, so that large
+ * backgrounds do not evict data that is about to be reused. Streaming stores are only
+ * used at the SSE2 level and above.
+ *
+ * Passing `0` restores the default, which is the size of the last-level cache reported
+ * by the CPU, capped at 32 MB. Passing `SIZE_MAX` disables streaming stores.
+ *
+ * The threshold is stored atomically, so this function may be called while other
+ * threads render.
+ *
+ * @param threshold The threshold in bytes, or `0` for the default.
+ */
+PLUTOVG_API void plutovg_set_nontemporal_threshold(size_t threshold);
+
+/**
+ * @brief Gets the size above which opaque fills bypass the cache.
+ * @return The effective threshold in bytes, or `SIZE_MAX` if streaming stores are unavailable.
+ */
+PLUTOVG_API size_t plutovg_get_nontemporal_threshold(void);
+
+/**
+ * @brief Defines the backends used to composite paints onto surfaces.
+ */
+typedef enum {
+    PLUTOVG_BLEND_BACKEND_INTEGER, ///< 8-bit fixed-point span compositors (default).
+    PLUTOVG_BLEND_BACKEND_PIPELINE ///< Staged float raster pipeline.
+} plutovg_blend_backend_t;
+
+/**
+ * @brief Selects the backend used to composite paints onto surfaces.
+ *
+ * The pipeline backend chains float stages (coordinate seeding, transform, paint
+ * sampling, blending, coverage and store) for every paint and operator combination.
+ * It evaluates gradients directly from their stops and trades speed for precision:
+ * its stages are scalar and several times slower than the integer backend, so it is
+ * never used unless selected here.
+ *
+ * This function is not thread-safe and should be called before any rendering takes place.
+ *
+ * @param backend The backend to use.
+ */
+PLUTOVG_API void plutovg_set_blend_backend(plutovg_blend_backend_t backend);
+
+/**
+ * @brief Gets the backend used to composite paints onto surfaces.
+ * @return The current blend backend.
+ */
+PLUTOVG_API plutovg_blend_backend_t plutovg_get_blend_backend(void);
+
+/**
+ * @brief Defines the functions plutovg allocates memory with.
+ *
+ * The functions follow the contracts of `malloc`, `realloc` and `free`, and receive `user_data`
+ * as their last argument. `free_func` is never called with `NULL`.
+ */
+typedef struct plutovg_allocator {
+    void* (*malloc_func)(size_t size, void* user_data); ///< Allocates `size` bytes.
+    void* (*realloc_func)(void* ptr, size_t size, void* user_data); ///< Resizes a block, or allocates one when `ptr` is `NULL`.
+    void (*free_func)(void* ptr, void* user_data); ///< Releases a block.
+    void* user_data; ///< Passed to every function.
+} plutovg_allocator_t;
+
+/**
+ * @brief Routes every allocation made by plutovg through the given functions.
+ *
+ * This covers surfaces, paths, paints, font faces, canvases and the scratch memory each canvas
+ * keeps for rasterization, as well as images and fonts decoded by the library.
+ * Memory supplied by the caller, such as data passed to `plutovg_surface_create_for_data`, is not affected.
+ *
+ * This function is not thread-safe. Call it before any plutovg object is created, and do not switch
+ * allocators while objects allocated with the previous one are still alive.
+ *
+ * @param allocator The allocator to use, or `NULL` to restore the C library allocator.
+ */
+PLUTOVG_API void plutovg_set_allocator(const plutovg_allocator_t* allocator);
+
+/**
+ * @brief Gets the functions plutovg allocates memory with.
+ * @param allocator A pointer to a `plutovg_allocator_t` structure that receives the current allocator.
+ */
+PLUTOVG_API void plutovg_get_allocator(plutovg_allocator_t* allocator);
+
 /**
  * @brief A function pointer type for a cleanup callback.
  * @param closure A pointer to the resource to be cleaned up.
@@ -1132,12 +1252,22 @@ PLUTOVG_API int plutovg_color_parse(plutovg_color_t* color, const char* data, in
 /**
  * @brief Represents an image surface for drawing operations.
  *
- * Stores pixel data in a 32-bit premultiplied ARGB format (0xAARRGGBB),
+ * By default, stores pixel data in a 32-bit premultiplied ARGB format (0xAARRGGBB),
  * where red, green, and blue channels are multiplied by the alpha channel
- * and divided by 255.
+ * and divided by 255. See `plutovg_format_t` for the other formats.
  */
 typedef struct plutovg_surface plutovg_surface_t;
 
+/**
+ * @brief Defines the pixel formats of a surface.
+ */
+typedef enum {
+    PLUTOVG_FORMAT_ARGB32, ///< 32-bit premultiplied ARGB (0xAARRGGBB) in native byte order.
+    PLUTOVG_FORMAT_A8, ///< 8-bit alpha only; colors are dropped when drawing, and the surface reads as black when used as a texture.
+    PLUTOVG_FORMAT_XRGB32, ///< Opaque 32-bit RGB (0xXXRRGGBB); the top byte is ignored when read and unspecified after drawing.
+    PLUTOVG_FORMAT_RGB565 ///< Opaque 16-bit RGB with 5, 6 and 5 bits per channel, written with ordered dithering.
+} plutovg_format_t;
+
 /**
  * @brief Creates a new image surface with the specified dimensions.
  *
@@ -1150,6 +1280,9 @@ PLUTOVG_API plutovg_surface_t* plutovg_surface_create(int width, int height);
 /**
  * @brief Creates an image surface using existing pixel data.
  *
+ * The caller keeps ownership of `data` and may write to it at any time, so plutovg never
+ * caches anything derived from the pixels of such a surface, and never assumes it is opaque.
+ *
  * @param data Pointer to the pixel data.
  * @param width The width of the surface in pixels.
  * @param height The height of the surface in pixels.
@@ -1158,6 +1291,73 @@ PLUTOVG_API plutovg_surface_t* plutovg_surface_create(int width, int height);
  */
 PLUTOVG_API plutovg_surface_t* plutovg_surface_create_for_data(unsigned char* data, int width, int height, int stride);
 
+/**
+ * @brief Creates a new image surface with the specified dimensions and pixel format.
+ *
+ * Rows are padded to a multiple of 64 bytes.
+ *
+ * @param width The width of the surface in pixels.
+ * @param height The height of the surface in pixels.
+ * @param format The pixel format of the surface.
+ * @return A pointer to the newly created `plutovg_surface_t` object.
+ */
+PLUTOVG_API plutovg_surface_t* plutovg_surface_create_with_format(int width, int height, plutovg_format_t format);
+
+/**
+ * @brief Creates an image surface of the specified pixel format using existing pixel data.
+ *
+ * As with `plutovg_surface_create_for_data()`, nothing derived from the pixels is cached.
+ *
+ * @param data Pointer to the pixel data.
+ * @param width The width of the surface in pixels.
+ * @param height The height of the surface in pixels.
+ * @param stride The number of bytes per row in the pixel data.
+ * @param format The pixel format of the data.
+ * @return A pointer to the newly created `plutovg_surface_t` object.
+ */
+PLUTOVG_API plutovg_surface_t* plutovg_surface_create_for_data_with_format(unsigned char* data, int width, int height, int stride, plutovg_format_t format);
+
+/**
+ * @brief Creates a virtual image surface whose memory is committed on first touch.
+ *
+ * The pixel buffer only reserves address space up front; the system provides zeroed
+ * memory page by page as pixels are first written, so a very large, mostly empty surface
+ * only uses memory where something has been drawn. Clearing the surface to transparent
+ * returns its memory to the system.
+ *
+ * Virtual surfaces need a system that commits memory lazily. They are not supported on
+ * Windows, which charges committed memory up front, nor where anonymous memory mappings
+ * are not available; this function returns `NULL` there, and callers can fall back to
+ * `plutovg_surface_create_with_format()` if the full buffer is affordable.
+ *
+ * @param width The width of the surface in pixels.
+ * @param height The height of the surface in pixels.
+ * @param format The pixel format of the surface.
+ * @return A pointer to the newly created `plutovg_surface_t` object, or `NULL` on failure or if virtual surfaces are not supported.
+ */
+PLUTOVG_API plutovg_surface_t* plutovg_surface_create_virtual(int width, int height, plutovg_format_t format);
+
+/**
+ * @brief Creates a surface that views a rectangular region of another surface.
+ *
+ * The view shares the pixel memory and format of `parent` and holds a reference to it,
+ * so the parent stays alive as long as the view does. Pixel (0, 0) of the view is pixel
+ * (`x`, `y`) of the parent.
+ *
+ * Views of non-overlapping regions can be drawn into concurrently from different threads,
+ * since drawing only touches a view's own pixels and bookkeeping. For the same reason, the
+ * parent is not notified of those changes: call `plutovg_surface_mark_dirty()` on it once
+ * drawing is done and before using it as a source again.
+ *
+ * @param parent Pointer to the surface to view.
+ * @param x The x-coordinate of the region within the parent.
+ * @param y The y-coordinate of the region within the parent.
+ * @param width The width of the region in pixels.
+ * @param height The height of the region in pixels.
+ * @return A pointer to the newly created `plutovg_surface_t` object, or `NULL` if the region is empty or not contained in the parent.
+ */
+PLUTOVG_API plutovg_surface_t* plutovg_surface_create_sub(plutovg_surface_t* parent, int x, int y, int width, int height);
+
 /**
  * @brief Loads an image surface from a file.
  *
@@ -1210,6 +1410,10 @@ PLUTOVG_API int plutovg_surface_get_reference_count(const plutovg_surface_t* sur
 /**
  * @brief Gets the pixel data of the surface.
  *
+ * The pixels may be written through the returned pointer. From then on the surface stops
+ * relying on cached data derived from them, such as the tile cache, the mip chain and its
+ * opaque flag, until `plutovg_surface_mark_dirty()` is called to declare them up to date.
+ *
  * @param surface Pointer to the `plutovg_surface_t` object.
  * @return Pointer to the pixel data.
  */
@@ -1234,22 +1438,71 @@ PLUTOVG_API int plutovg_surface_get_height(const plutovg_surface_t* surface);
 /**
  * @brief Gets the stride of the surface.
  *
+ * Surfaces allocated by plutovg pad each row to a multiple of 64 bytes, so the stride
+ * may be larger than the width times the bytes per pixel.
+ *
  * @param surface Pointer to the `plutovg_surface_t` object.
  * @return Number of bytes per row.
  */
 PLUTOVG_API int plutovg_surface_get_stride(const plutovg_surface_t* surface);
 
+/**
+ * @brief Gets the pixel format of the surface.
+ *
+ * @param surface Pointer to the `plutovg_surface_t` object.
+ * @return The pixel format of the surface.
+ */
+PLUTOVG_API plutovg_format_t plutovg_surface_get_format(const plutovg_surface_t* surface);
+
 /**
  * @brief Clears the entire surface with the specified color.
  *
+ * `PLUTOVG_FORMAT_A8` surfaces keep only the alpha of the color.
+ *
  * @param surface Pointer to the target surface.
  * @param color Pointer to the color used for clearing.
  */
 PLUTOVG_API void plutovg_surface_clear(plutovg_surface_t* surface, const plutovg_color_t* color);
 
+/**
+ * @brief Enables or disables the mip chain of a surface.
+ *
+ * When enabled, drawing the surface as a texture at less than half its size samples
+ * from a chain of box-filtered half-size copies instead of the full image. The chain is
+ * built lazily on first use and rebuilt after the surface content changes.
+ * Disabling it releases the chain.
+ *
+ * @param surface Pointer to the `plutovg_surface_t` object.
+ * @param enabled `true` to enable the mip chain, `false` to disable it.
+ */
+PLUTOVG_API void plutovg_surface_set_mipmap_enabled(plutovg_surface_t* surface, bool enabled);
+
+/**
+ * @brief Checks whether the mip chain of a surface is enabled.
+ *
+ * @param surface Pointer to the `plutovg_surface_t` object.
+ * @return `true` if the mip chain is enabled, `false` otherwise.
+ */
+PLUTOVG_API bool plutovg_surface_get_mipmap_enabled(const plutovg_surface_t* surface);
+
+/**
+ * @brief Notifies the surface that its pixel data was modified directly.
+ *
+ * Drawing through a canvas and `plutovg_surface_clear` track changes automatically.
+ * After writing to the buffer returned by `plutovg_surface_get_data`, call this once the
+ * writes are done: cached data derived from the pixels, such as the mip chain, is rebuilt
+ * on next use and kept until the pointer is requested again. Surfaces that wrap caller
+ * data never cache, so calling this is optional for them.
+ *
+ * @param surface Pointer to the `plutovg_surface_t` object.
+ */
+PLUTOVG_API void plutovg_surface_mark_dirty(plutovg_surface_t* surface);
+
 /**
  * @brief Writes the surface to a PNG file.
  *
+ * `PLUTOVG_FORMAT_A8` surfaces are written as grayscale images, here and in the other writers.
+ *
  * @param surface Pointer to the `plutovg_surface_t` object.
  * @param filename Path to the output PNG file.
  * @return `true` if successful, `false` otherwise.
@@ -1287,6 +1540,111 @@ PLUTOVG_API bool plutovg_surface_write_to_png_stream(const plutovg_surface_t* su
  */
 PLUTOVG_API bool plutovg_surface_write_to_jpg_stream(const plutovg_surface_t* surface, plutovg_write_func_t write_func, void* closure, int quality);
 
+/**
+ * @brief Represents a pool of reusable surfaces.
+ *
+ * A pool keeps released surfaces around so that later requests for the same size and
+ * format reuse their pixel memory instead of allocating it again. Idle surfaces are kept
+ * up to a byte limit; when that limit is exceeded, the least recently released ones are
+ * destroyed first. A pool may be shared between threads.
+ */
+typedef struct plutovg_surface_pool plutovg_surface_pool_t;
+
+/**
+ * @brief Creates a surface pool.
+ *
+ * @param limit Maximum number of bytes of pixel memory the pool keeps in idle surfaces.
+ * @return Pointer to the newly created `plutovg_surface_pool_t` object.
+ */
+PLUTOVG_API plutovg_surface_pool_t* plutovg_surface_pool_create(size_t limit);
+
+/**
+ * @brief Increments the reference count of a surface pool.
+ *
+ * @param pool Pointer to the `plutovg_surface_pool_t` object.
+ * @return Pointer to the same `plutovg_surface_pool_t` object.
+ */
+PLUTOVG_API plutovg_surface_pool_t* plutovg_surface_pool_reference(plutovg_surface_pool_t* pool);
+
+/**
+ * @brief Decrements the reference count of a surface pool and destroys it, along with
+ * its idle surfaces, when the count reaches zero.
+ *
+ * @param pool Pointer to the `plutovg_surface_pool_t` object.
+ */
+PLUTOVG_API void plutovg_surface_pool_destroy(plutovg_surface_pool_t* pool);
+
+/**
+ * @brief Gets the current reference count of a surface pool.
+ *
+ * @param pool Pointer to the `plutovg_surface_pool_t` object.
+ * @return The current reference count.
+ */
+PLUTOVG_API int plutovg_surface_pool_get_reference_count(const plutovg_surface_pool_t* pool);
+
+/**
+ * @brief Acquires a surface of the given size and format from the pool.
+ *
+ * An idle surface with the same width, height and format is reused when one is available;
+ * otherwise a new surface is created. Unless `clear` is `true`, the contents of the
+ * returned surface are undefined.
+ *
+ * @param pool Pointer to the `plutovg_surface_pool_t` object.
+ * @param width Width of the surface in pixels.
+ * @param height Height of the surface in pixels.
+ * @param format Pixel format of the surface.
+ * @param clear Whether the surface must be cleared to transparent black.
+ * @return Pointer to the surface, or `NULL` on failure. Return it with `plutovg_surface_pool_release()`, or destroy it with `plutovg_surface_destroy()`.
+ */
+PLUTOVG_API plutovg_surface_t* plutovg_surface_pool_acquire(plutovg_surface_pool_t* pool, int width, int height, plutovg_format_t format, bool clear);
+
+/**
+ * @brief Returns a surface to the pool.
+ *
+ * The pool takes over the caller's reference. Surfaces that are still referenced elsewhere,
+ * or that do not own their pixel memory, are not kept and are simply released.
+ *
+ * @param pool Pointer to the `plutovg_surface_pool_t` object.
+ * @param surface Pointer to the surface to release.
+ */
+PLUTOVG_API void plutovg_surface_pool_release(plutovg_surface_pool_t* pool, plutovg_surface_t* surface);
+
+/**
+ * @brief Destroys idle surfaces until the pool holds at most `size` bytes.
+ *
+ * Call this with `0` to drop every idle surface, for example under memory pressure.
+ *
+ * @param pool Pointer to the `plutovg_surface_pool_t` object.
+ * @param size Number of bytes of idle pixel memory to keep at most.
+ */
+PLUTOVG_API void plutovg_surface_pool_trim(plutovg_surface_pool_t* pool, size_t size);
+
+/**
+ * @brief Sets the maximum number of bytes the pool keeps in idle surfaces.
+ *
+ * Lowering the limit trims the pool immediately.
+ *
+ * @param pool Pointer to the `plutovg_surface_pool_t` object.
+ * @param limit Maximum number of bytes of idle pixel memory.
+ */
+PLUTOVG_API void plutovg_surface_pool_set_limit(plutovg_surface_pool_t* pool, size_t limit);
+
+/**
+ * @brief Gets the maximum number of bytes the pool keeps in idle surfaces.
+ *
+ * @param pool Pointer to the `plutovg_surface_pool_t` object.
+ * @return The byte limit.
+ */
+PLUTOVG_API size_t plutovg_surface_pool_get_limit(const plutovg_surface_pool_t* pool);
+
+/**
+ * @brief Gets the number of bytes of pixel memory currently held in idle surfaces.
+ *
+ * @param pool Pointer to the `plutovg_surface_pool_t` object.
+ * @return The number of idle bytes.
+ */
+PLUTOVG_API size_t plutovg_surface_pool_get_size(const plutovg_surface_pool_t* pool);
+
 /**
  * @brief Converts pixel data from premultiplied ARGB to RGBA format.
  *
@@ -1499,6 +1857,20 @@ typedef struct plutovg_canvas plutovg_canvas_t;
  */
 PLUTOVG_API plutovg_canvas_t* plutovg_canvas_create(plutovg_surface_t* surface);
 
+/**
+ * @brief Creates a drawing context that records drawing operations instead of rendering them.
+ *
+ * The canvas behaves like one created on a `width` x `height` surface, except that fills,
+ * strokes, clips, paints, masks and groups are appended to a display list.
+ * Use `plutovg_canvas_finish_recording` to retrieve the list.
+ *
+ * @note Clip queries on a recording canvas only see its bounds, and `plutovg_canvas_get_surface` returns `NULL`.
+ * @param width The width of the recording bounds.
+ * @param height The height of the recording bounds.
+ * @return A pointer to the newly created `plutovg_canvas_t` object.
+ */
+PLUTOVG_API plutovg_canvas_t* plutovg_canvas_create_recording(int width, int height);
+
 /**
  * @brief Increases the reference count of the canvas.
  *
@@ -1522,9 +1894,26 @@ PLUTOVG_API void plutovg_canvas_destroy(plutovg_canvas_t* canvas);
  */
 PLUTOVG_API int plutovg_canvas_get_reference_count(const plutovg_canvas_t* canvas);
 
+/**
+ * @brief Resets the canvas to its initial state, optionally binding it to another surface.
+ *
+ * Active groups are discarded without being composited, the state stack is restored to the defaults
+ * of a new canvas, and the current path and damage are cleared. Saved states, group layers, paths
+ * and span buffers keep their memory, so a canvas reset once per frame stops allocating once
+ * it has drawn a frame.
+ *
+ * A recording canvas keeps its bounds and discards the operations recorded so far.
+ *
+ * @param canvas A pointer to a `plutovg_canvas_t` object.
+ * @param surface A pointer to the `plutovg_surface_t` object to draw on, or `NULL` to keep the current one.
+ */
+PLUTOVG_API void plutovg_canvas_reset(plutovg_canvas_t* canvas, plutovg_surface_t* surface);
+
 /**
  * @brief Gets the surface associated with the canvas.
  *
+ * While a group is active, this is still the surface the canvas was created for.
+ *
  * @param canvas A pointer to a `plutovg_canvas_t` object.
  * @return A pointer to the `plutovg_surface_t` object.
  */
@@ -1540,10 +1929,36 @@ PLUTOVG_API void plutovg_canvas_save(plutovg_canvas_t* canvas);
 /**
  * @brief Restores the canvas to the most recently saved state.
  *
+ * @note States saved before the current group are only restored by `plutovg_canvas_pop_group`.
+ *
  * @param canvas A pointer to a `plutovg_canvas_t` object.
  */
 PLUTOVG_API void plutovg_canvas_restore(plutovg_canvas_t* canvas);
 
+/**
+ * @brief Redirects drawing to an offscreen group until the matching `plutovg_canvas_pop_group`.
+ *
+ * The canvas state is saved, and subsequent drawing goes into a transparent ARGB32 layer.
+ * The layer only covers the clip extents at the time of the call, so clip before pushing
+ * to keep it small. Layer buffers are kept by the canvas and reused by later groups.
+ *
+ * @param canvas A pointer to a `plutovg_canvas_t` object.
+ */
+PLUTOVG_API void plutovg_canvas_push_group(plutovg_canvas_t* canvas);
+
+/**
+ * @brief Ends the current group and composites it onto the previous target.
+ *
+ * The state saved by `plutovg_canvas_push_group` is restored together with any states
+ * saved inside the group. The layer is then blended at its original position using
+ * `opacity` and `op`, and limited by the restored clip.
+ *
+ * @param canvas A pointer to a `plutovg_canvas_t` object.
+ * @param opacity The group opacity, clamped to the range 0 to 1.
+ * @param op The operator used to composite the group.
+ */
+PLUTOVG_API void plutovg_canvas_pop_group(plutovg_canvas_t* canvas, float opacity, plutovg_operator_t op);
+
 /**
  * @brief Sets the current paint to a solid color.
  *
@@ -2316,6 +2731,44 @@ PLUTOVG_API void plutovg_canvas_stroke_extents(plutovg_canvas_t* canvas, plutovg
  */
 PLUTOVG_API void plutovg_canvas_clip_extents(plutovg_canvas_t* canvas, plutovg_rect_t* extents);
 
+/**
+ * @brief The maximum number of rectangles used to describe the damage of a canvas.
+ */
+#define PLUTOVG_MAX_DAMAGE_RECTS 8
+
+/**
+ * @brief Gets the regions of the surface changed by the canvas.
+ *
+ * Every drawing operation adds the device-space bounding box of the pixels it writes to the damage
+ * of the canvas. Overlapping boxes are merged, and once `PLUTOVG_MAX_DAMAGE_RECTS` boxes are in use,
+ * new ones are merged into the box that grows the least. The rectangles never overlap and are
+ * aligned to whole pixels.
+ *
+ * Drawing inside a group only counts once the group is composited onto the surface.
+ *
+ * @param canvas A pointer to a `plutovg_canvas_t` object.
+ * @param rects An array that receives up to `max_rects` rectangles, or `NULL`.
+ * @param max_rects The number of rectangles `rects` can hold.
+ * @return The number of damage rectangles.
+ */
+PLUTOVG_API int plutovg_canvas_get_damage(const plutovg_canvas_t* canvas, plutovg_rect_t* rects, int max_rects);
+
+/**
+ * @brief Gets the bounding box of the damage of a canvas.
+ *
+ * @param canvas A pointer to a `plutovg_canvas_t` object.
+ * @param extents A pointer to a `plutovg_rect_t` structure that receives the bounding box,
+ * which is empty when nothing has been drawn since the last reset.
+ */
+PLUTOVG_API void plutovg_canvas_get_damage_extents(const plutovg_canvas_t* canvas, plutovg_rect_t* extents);
+
+/**
+ * @brief Clears the damage of a canvas.
+ *
+ * @param canvas A pointer to a `plutovg_canvas_t` object.
+ */
+PLUTOVG_API void plutovg_canvas_reset_damage(plutovg_canvas_t* canvas);
+
 /**
  * @brief A drawing operator that fills the current path according to the current fill rule.
  *
@@ -2351,6 +2804,21 @@ PLUTOVG_API void plutovg_canvas_clip(plutovg_canvas_t* canvas);
  */
 PLUTOVG_API void plutovg_canvas_paint(plutovg_canvas_t* canvas);
 
+/**
+ * @brief A drawing operator that paints the current paint using the alpha channel of a surface as a mask.
+ *
+ * The mask is placed at (`x`, `y`) in user space and transformed by the current matrix.
+ * It is sampled at the nearest pixel and intersected with the current clipping region.
+ * Surfaces of any format can be used as masks; the opaque formats cover every pixel they span.
+ *
+ * @note The current path will not be affected by this operation.
+ * @param canvas A pointer to a `plutovg_canvas_t` object.
+ * @param mask The mask surface.
+ * @param x The x-coordinate of the top-left corner of the mask.
+ * @param y The y-coordinate of the top-left corner of the mask.
+ */
+PLUTOVG_API void plutovg_canvas_mask_surface(plutovg_canvas_t* canvas, const plutovg_surface_t* mask, float x, float y);
+
 /**
  * @brief A drawing operator that fills the current path according to the current fill rule.
  *
@@ -2541,6 +3009,84 @@ PLUTOVG_API void plutovg_canvas_glyph_metrics(plutovg_canvas_t* canvas, plutovg_
  */
 PLUTOVG_API float plutovg_canvas_text_extents(plutovg_canvas_t* canvas, const void* text, int length, plutovg_text_encoding_t encoding, plutovg_rect_t* extents);
 
+/**
+ * @brief Represents an immutable list of recorded drawing operations.
+ */
+typedef struct plutovg_display_list plutovg_display_list_t;
+
+/**
+ * @brief Ends the current recording of a recording canvas.
+ *
+ * Groups and saved states that are still open are closed, and the recorded operations are
+ * returned as a display list. The canvas then starts recording a new, empty list.
+ *
+ * Paths are copied, while paints and mask surfaces are referenced by the list.
+ *
+ * @param canvas A pointer to a recording `plutovg_canvas_t` object.
+ * @return A pointer to the recorded `plutovg_display_list_t` object, or `NULL` if the canvas is not recording.
+ */
+PLUTOVG_API plutovg_display_list_t* plutovg_canvas_finish_recording(plutovg_canvas_t* canvas);
+
+/**
+ * @brief Replays a display list onto a canvas.
+ *
+ * Each operation is drawn with its recorded state, transformed by `matrix` and then by the
+ * current matrix of the canvas, and clipped by the current clip. The canvas state is left unchanged.
+ * Replaying onto a recording canvas appends the operations to its recording.
+ *
+ * @param canvas A pointer to a `plutovg_canvas_t` object.
+ * @param display_list A pointer to a `plutovg_display_list_t` object.
+ * @param matrix An optional transformation matrix applied to the recorded operations, or `NULL` for identity.
+ */
+PLUTOVG_API void plutovg_canvas_draw_display_list(plutovg_canvas_t* canvas, const plutovg_display_list_t* display_list, const plutovg_matrix_t* matrix);
+
+/**
+ * @brief Renders a display list onto a surface using several threads.
+ *
+ * The surface is split into horizontal tiles of up to 256 rows that the threads claim until none
+ * are left, and each tile only replays the operations whose bounds reach it. The result is identical
+ * to replaying the list with `plutovg_canvas_draw_display_list` on a new canvas for `surface`.
+ * Without thread support in the build, the whole surface is rendered on the calling thread.
+ *
+ * @param surface A pointer to a `plutovg_surface_t` object.
+ * @param display_list A pointer to a `plutovg_display_list_t` object.
+ * @param matrix An optional transformation matrix applied to the recorded operations, or `NULL` for identity.
+ * @param num_threads The number of threads to render with, including the calling one, or a value less than 1 to use one per processor.
+ */
+PLUTOVG_API void plutovg_surface_draw_display_list(plutovg_surface_t* surface, const plutovg_display_list_t* display_list, const plutovg_matrix_t* matrix, int num_threads);
+
+/**
+ * @brief Increments the reference count of a display list.
+ *
+ * @param display_list A pointer to a `plutovg_display_list_t` object.
+ * @return A pointer to the same `plutovg_display_list_t` object.
+ */
+PLUTOVG_API plutovg_display_list_t* plutovg_display_list_reference(plutovg_display_list_t* display_list);
+
+/**
+ * @brief Decrements the reference count and destroys the display list if the count reaches zero.
+ *
+ * @param display_list A pointer to a `plutovg_display_list_t` object.
+ */
+PLUTOVG_API void plutovg_display_list_destroy(plutovg_display_list_t* display_list);
+
+/**
+ * @brief Retrieves the reference count of a display list.
+ *
+ * @param display_list A pointer to a `plutovg_display_list_t` object.
+ * @return The current reference count.
+ */
+PLUTOVG_API int plutovg_display_list_get_reference_count(const plutovg_display_list_t* display_list);
+
+/**
+ * @brief Gets the bounds of the recording canvas a display list was recorded on.
+ *
+ * @param display_list A pointer to a `plutovg_display_list_t` object.
+ * @param width Receives the width of the recording bounds.
+ * @param height Receives the height of the recording bounds.
+ */
+PLUTOVG_API void plutovg_display_list_get_size(const plutovg_display_list_t* display_list, int* width, int* height);
+
 #ifdef __cplusplus
 }
 #endif
@@ -8,7 +8,7 @@
 typedef struct {
     plutovg_matrix_t matrix;
     plutovg_spread_method_t spread;
-    uint32_t colortable[COLOR_TABLE_SIZE];
+    const uint32_t* colortable;
     union {
         struct {
             float x1, y1;
@@ -21,13 +21,21 @@ typedef struct {
     } values;
 } gradient_data_t;
 
+struct plutovg_color_table {
+    plutovg_ref_count_t ref_count;
+    float opacity;
+    uint32_t data[COLOR_TABLE_SIZE];
+};
+
 typedef struct {
     plutovg_matrix_t matrix;
     uint8_t* data;
     int width;
     int height;
     int stride;
+    int row_width;
     int const_alpha;
+    bool opaque;
 } texture_data_t;
 
 typedef struct {
@@ -80,6 +88,15 @@ static inline uint32_t INTERPOLATE_PIXEL_256(uint32_t x, uint32_t a, uint32_t y,
     return x;
 }
 
+static inline uint32_t interpolate_4_pixels(uint32_t tl, uint32_t tr, uint32_t bl, uint32_t br, uint32_t distx, uint32_t disty)
+{
+    uint32_t idistx = 256 - distx;
+    uint32_t idisty = 256 - disty;
+    uint32_t xtop = INTERPOLATE_PIXEL_256(tl, idistx, tr, distx);
+    uint32_t xbot = INTERPOLATE_PIXEL_256(bl, idistx, br, distx);
+    return INTERPOLATE_PIXEL_256(xtop, idisty, xbot, disty);
+}
+
 static inline uint32_t BYTE_MUL(uint32_t x, uint32_t a)
 {
     uint32_t t = (x & 0xff00ff) * a;
@@ -93,74 +110,13 @@ static inline uint32_t BYTE_MUL(uint32_t x, uint32_t a)
     return x;
 }
 
-#ifdef __SSE2__
-
-#include <emmintrin.h>
-
-void plutovg_memfill32(unsigned int* dest, int length, unsigned int value)
-{
-    __m128i vector_data = _mm_set_epi32(value, value, value, value);
-    while(length && ((uintptr_t)dest & 0xf)) {
-        *dest++ = value;
-        length--;
-    }
-
-    while(length >= 32) {
-        _mm_store_si128((__m128i*)(dest), vector_data);
-        _mm_store_si128((__m128i*)(dest + 4), vector_data);
-        _mm_store_si128((__m128i*)(dest + 8), vector_data);
-        _mm_store_si128((__m128i*)(dest + 12), vector_data);
-        _mm_store_si128((__m128i*)(dest + 16), vector_data);
-        _mm_store_si128((__m128i*)(dest + 20), vector_data);
-        _mm_store_si128((__m128i*)(dest + 24), vector_data);
-        _mm_store_si128((__m128i*)(dest + 28), vector_data);
-
-        dest += 32;
-        length -= 32;
-    }
-
-    if(length >= 16) {
-        _mm_store_si128((__m128i*)(dest), vector_data);
-        _mm_store_si128((__m128i*)(dest + 4), vector_data);
-        _mm_store_si128((__m128i*)(dest + 8), vector_data);
-        _mm_store_si128((__m128i*)(dest + 12), vector_data);
-
-        dest += 16;
-        length -= 16;
-    }
-
-    if(length >= 8) {
-        _mm_store_si128((__m128i*)(dest), vector_data);
-        _mm_store_si128((__m128i*)(dest + 4), vector_data);
-
-        dest += 8;
-        length -= 8;
-    }
-
-    if(length >= 4) {
-        _mm_store_si128((__m128i*)(dest), vector_data);
-
-        dest += 4;
-        length -= 4;
-    }
-
-    while(length) {
-        *dest++ = value;
-        length--;
-    }
-}
-
-#else
-
-void plutovg_memfill32(unsigned int* dest, int length, unsigned int value)
+static void memfill32(uint32_t* dest, int length, uint32_t value)
 {
     while(length--) {
         *dest++ = value;
     }
 }
 
-#endif // __SSE2__
-
 static inline int gradient_clamp(const gradient_data_t* gradient, int ipos)
 {
     if(gradient->spread == PLUTOVG_SPREAD_METHOD_REPEAT) {
@@ -196,27 +152,38 @@ static inline uint32_t gradient_pixel(const gradient_data_t* gradient, float pos
     return gradient->colortable[gradient_clamp(gradient, ipos)];
 }
 
-static void fetch_linear_gradient(uint32_t* buffer, const linear_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length)
+static inline void linear_gradient_position(const linear_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, float* t, float* inc)
 {
-    float t, inc;
-    float rx = 0, ry = 0;
-
     if(v->l == 0.f) {
-        t = inc = 0;
+        *t = *inc = 0;
     } else {
-        rx = gradient->matrix.c * (y + 0.5f) + gradient->matrix.a * (x + 0.5f) + gradient->matrix.e;
-        ry = gradient->matrix.d * (y + 0.5f) + gradient->matrix.b * (x + 0.5f) + gradient->matrix.f;
-        t = v->dx * rx + v->dy * ry + v->off;
-        inc = v->dx * gradient->matrix.a + v->dy * gradient->matrix.b;
-        t *= (COLOR_TABLE_SIZE - 1);
-        inc *= (COLOR_TABLE_SIZE - 1);
+        float rx = gradient->matrix.c * (y + 0.5f) + gradient->matrix.a * (x + 0.5f) + gradient->matrix.e;
+        float ry = gradient->matrix.d * (y + 0.5f) + gradient->matrix.b * (x + 0.5f) + gradient->matrix.f;
+        *t = (v->dx * rx + v->dy * ry + v->off) * (COLOR_TABLE_SIZE - 1);
+        *inc = (v->dx * gradient->matrix.a + v->dy * gradient->matrix.b) * (COLOR_TABLE_SIZE - 1);
     }
+}
+
+static inline bool linear_gradient_is_constant(float inc)
+{
+    return inc > -1e-5f && inc < 1e-5f;
+}
+
+static inline bool linear_gradient_fits_fixed(float t, float inc, int length)
+{
+    return t + inc * length < (float)(INT_MAX >> (FIXPT_BITS + 1)) && t + inc * length > (float)(INT_MIN >> (FIXPT_BITS + 1));
+}
+
+static void fetch_linear_gradient(uint32_t* buffer, const linear_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length)
+{
+    float t, inc;
+    linear_gradient_position(v, gradient, y, x, &t, &inc);
 
     const uint32_t* end = buffer + length;
-    if(inc > -1e-5f && inc < 1e-5f) {
+    if(linear_gradient_is_constant(inc)) {
         plutovg_memfill32(buffer, length, gradient_pixel_fixed(gradient, (int)(t * FIXPT_SIZE)));
     } else {
-        if(t + inc * length < (float)(INT_MAX >> (FIXPT_BITS + 1)) && t + inc * length > (float)(INT_MIN >> (FIXPT_BITS + 1))) {
+        if(linear_gradient_fits_fixed(t, inc, length)) {
             int t_fixed = (int)(t * FIXPT_SIZE);
             int inc_fixed = (int)(inc * FIXPT_SIZE);
             while(buffer < end) {
@@ -234,13 +201,16 @@ static void fetch_linear_gradient(uint32_t* buffer, const linear_gradient_values
     }
 }
 
-static void fetch_radial_gradient(uint32_t* buffer, const radial_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length)
+typedef struct {
+    float b;
+    float delta_b;
+    float det;
+    float delta_det;
+    float delta_delta_det;
+} radial_gradient_step_t;
+
+static inline void radial_gradient_step_init(radial_gradient_step_t* step, const radial_gradient_values_t* v, const gradient_data_t* gradient, int y, int x)
 {
-    if(v->a == 0.f) {
-        plutovg_memfill32(buffer, length, 0);
-        return;
-    }
-
     float rx = gradient->matrix.c * (y + 0.5f) + gradient->matrix.e + gradient->matrix.a * (x + 0.5f);
     float ry = gradient->matrix.d * (y + 0.5f) + gradient->matrix.f + gradient->matrix.b * (x + 0.5f);
 
@@ -273,6 +243,29 @@ static void fetch_radial_gradient(uint32_t* buffer, const radial_gradient_values
     float delta_det = (b_delta_b + delta_bb + 4 * v->a * (rx_plus_ry + delta_rxrxryry)) * inv_a;
     float delta_delta_det = (delta_b_delta_b + 4 * v->a * delta_rx_plus_ry) * inv_a;
 
+    step->b = b;
+    step->delta_b = delta_b;
+    step->det = det;
+    step->delta_det = delta_det;
+    step->delta_delta_det = delta_delta_det;
+}
+
+static void fetch_radial_gradient(uint32_t* buffer, const radial_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length)
+{
+    if(v->a == 0.f) {
+        plutovg_memfill32(buffer, length, 0);
+        return;
+    }
+
+    radial_gradient_step_t step;
+    radial_gradient_step_init(&step, v, gradient, y, x);
+
+    float b = step.b;
+    float delta_b = step.delta_b;
+    float det = step.det;
+    float delta_det = step.delta_det;
+    float delta_delta_det = step.delta_delta_det;
+
     const uint32_t* end = buffer + length;
     if(v->extended) {
         while(buffer < end) {
@@ -300,6 +293,58 @@ static void fetch_radial_gradient(uint32_t* buffer, const radial_gradient_values
     }
 }
 
+/* Nearest texel at 16.16 coordinates that the caller has clipped to the texture. */
+static inline uint32_t fetch_nearest_pixel(const texture_data_t* texture, int* x, int* y, int fdx, int fdy)
+{
+    int px = *x >> 16;
+    int py = *y >> 16;
+    *x += fdx;
+    *y += fdy;
+    return ((const uint32_t*)(texture->data + (ptrdiff_t)py * texture->stride))[px];
+}
+
+/* Bilinear sample whose four texels the caller has clipped to the texture. */
+static inline uint32_t fetch_bilinear_pixel(const texture_data_t* texture, int* fx, int* fy, int fdx, int fdy)
+{
+    int x1 = *fx >> 16;
+    int y1 = *fy >> 16;
+
+    const uint32_t* s1 = (const uint32_t*)(texture->data + (ptrdiff_t)y1 * texture->stride);
+    const uint32_t* s2 = (const uint32_t*)(texture->data + (ptrdiff_t)(y1 + 1) * texture->stride);
+
+    int distx = (*fx & 0x0000ffff) >> 8;
+    int disty = (*fy & 0x0000ffff) >> 8;
+    *fx += fdx;
+    *fy += fdy;
+    return interpolate_4_pixels(s1[x1], s1[x1 + 1], s2[x1], s2[x1 + 1], distx, disty);
+}
+
+static void fetch_nearest(uint32_t* buffer, const texture_data_t* texture, int x, int y, int fdx, int fdy, int length)
+{
+    for(int i = 0; i < length; i++) {
+        buffer[i] = fetch_nearest_pixel(texture, &x, &y, fdx, fdy);
+    }
+}
+
+static void fetch_bilinear(uint32_t* buffer, const texture_data_t* texture, int fx, int fy, int fdx, int fdy, int length)
+{
+    for(int i = 0; i < length; i++) {
+        buffer[i] = fetch_bilinear_pixel(texture, &fx, &fy, fdx, fdy);
+    }
+}
+
+/* Averages 2x2 blocks of the two source rows into `width` destination pixels. */
+static void downsample(uint32_t* dest, const uint32_t* row0, const uint32_t* row1, int width)
+{
+    for(int i = 0; i < width; i++) {
+        uint32_t a = row0[2 * i], b = row0[2 * i + 1];
+        uint32_t c = row1[2 * i], d = row1[2 * i + 1];
+        uint32_t lo = (a & 0xff00ff) + (b & 0xff00ff) + (c & 0xff00ff) + (d & 0xff00ff) + 0x20002;
+        uint32_t hi = ((a >> 8) & 0xff00ff) + ((b >> 8) & 0xff00ff) + ((c >> 8) & 0xff00ff) + ((d >> 8) & 0xff00ff) + 0x20002;
+        dest[i] = ((lo >> 2) & 0xff00ff) | (((hi >> 2) & 0xff00ff) << 8);
+    }
+}
+
 static void composition_solid_clear(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha)
 {
     if(const_alpha == 255) {
@@ -439,7 +484,7 @@ static void composition_solid_xor(uint32_t* dest, int length, uint32_t color, ui
 
 typedef void(*composition_solid_function_t)(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha);
 
-static const composition_solid_function_t composition_solid_table[] = {
+static const composition_solid_function_t composition_solid_table_scalar[] = {
     composition_solid_clear,
     composition_solid_source,
     composition_solid_destination,
@@ -454,6 +499,165 @@ static const composition_solid_function_t composition_solid_table[] = {
     composition_solid_xor
 };
 
+/*
+ * Alpha-only kernels mirror the solid ARGB kernels on the alpha channel, so an A8
+ * surface holds exactly the alpha an ARGB surface would get from the same drawing.
+ * BYTE_MUL and INTERPOLATE_PIXEL_255 act on the low byte lane alone for such values.
+ */
+static void composition_solid_a8_clear(uint8_t* dest, int length, uint32_t alpha, uint32_t const_alpha)
+{
+    if(const_alpha == 255) {
+        memset(dest, 0, length);
+    } else {
+        uint32_t ialpha = 255 - const_alpha;
+        for(int i = 0; i < length; i++) {
+            dest[i] = BYTE_MUL(dest[i], ialpha);
+        }
+    }
+}
+
+static void composition_solid_a8_source(uint8_t* dest, int length, uint32_t alpha, uint32_t const_alpha)
+{
+    if(const_alpha == 255) {
+        memset(dest, alpha, length);
+    } else {
+        uint32_t ialpha = 255 - const_alpha;
+        alpha = BYTE_MUL(alpha, const_alpha);
+        for(int i = 0; i < length; i++) {
+            dest[i] = alpha + BYTE_MUL(dest[i], ialpha);
+        }
+    }
+}
+
+static void composition_solid_a8_destination(uint8_t* dest, int length, uint32_t alpha, uint32_t const_alpha)
+{
+}
+
+static void composition_solid_a8_source_over(uint8_t* dest, int length, uint32_t alpha, uint32_t const_alpha)
+{
+    if(const_alpha != 255)
+        alpha = BYTE_MUL(alpha, const_alpha);
+    uint32_t ialpha = 255 - alpha;
+    for(int i = 0; i < length; i++) {
+        dest[i] = alpha + BYTE_MUL(dest[i], ialpha);
+    }
+}
+
+static void composition_solid_a8_destination_over(uint8_t* dest, int length, uint32_t alpha, uint32_t const_alpha)
+{
+    if(const_alpha != 255)
+        alpha = BYTE_MUL(alpha, const_alpha);
+    for(int i = 0; i < length; i++) {
+        uint32_t d = dest[i];
+        dest[i] = d + BYTE_MUL(alpha, 255 - d);
+    }
+}
+
+static void composition_solid_a8_source_in(uint8_t* dest, int length, uint32_t alpha, uint32_t const_alpha)
+{
+    if(const_alpha == 255) {
+        for(int i = 0; i < length; i++) {
+            dest[i] = BYTE_MUL(alpha, dest[i]);
+        }
+    } else {
+        alpha = BYTE_MUL(alpha, const_alpha);
+        uint32_t cia = 255 - const_alpha;
+        for(int i = 0; i < length; i++) {
+            uint32_t d = dest[i];
+            dest[i] = INTERPOLATE_PIXEL_255(alpha, d, d, cia);
+        }
+    }
+}
+
+static void composition_solid_a8_destination_in(uint8_t* dest, int length, uint32_t alpha, uint32_t const_alpha)
+{
+    uint32_t a = alpha;
+    if(const_alpha != 255)
+        a = BYTE_MUL(a, const_alpha) + 255 - const_alpha;
+    for(int i = 0; i < length; i++) {
+        dest[i] = BYTE_MUL(dest[i], a);
+    }
+}
+
+static void composition_solid_a8_source_out(uint8_t* dest, int length, uint32_t alpha, uint32_t const_alpha)
+{
+    if(const_alpha == 255) {
+        for(int i = 0; i < length; i++) {
+            dest[i] = BYTE_MUL(alpha, 255 - dest[i]);
+        }
+    } else {
+        alpha = BYTE_MUL(alpha, const_alpha);
+        uint32_t cia = 255 - const_alpha;
+        for(int i = 0; i < length; i++) {
+            uint32_t d = dest[i];
+            dest[i] = INTERPOLATE_PIXEL_255(alpha, 255 - d, d, cia);
+        }
+    }
+}
+
+static void composition_solid_a8_destination_out(uint8_t* dest, int length, uint32_t alpha, uint32_t const_alpha)
+{
+    uint32_t a = 255 - alpha;
+    if(const_alpha != 255)
+        a = BYTE_MUL(a, const_alpha) + 255 - const_alpha;
+    for(int i = 0; i < length; i++) {
+        dest[i] = BYTE_MUL(dest[i], a);
+    }
+}
+
+static void composition_solid_a8_source_atop(uint8_t* dest, int length, uint32_t alpha, uint32_t const_alpha)
+{
+    if(const_alpha != 255)
+        alpha = BYTE_MUL(alpha, const_alpha);
+    uint32_t sia = 255 - alpha;
+    for(int i = 0; i < length; i++) {
+        uint32_t d = dest[i];
+        dest[i] = INTERPOLATE_PIXEL_255(alpha, d, d, sia);
+    }
+}
+
+static void composition_solid_a8_destination_atop(uint8_t* dest, int length, uint32_t alpha, uint32_t const_alpha)
+{
+    uint32_t a = alpha;
+    if(const_alpha != 255) {
+        alpha = BYTE_MUL(alpha, const_alpha);
+        a = alpha + 255 - const_alpha;
+    }
+
+    for(int i = 0; i < length; i++) {
+        uint32_t d = dest[i];
+        dest[i] = INTERPOLATE_PIXEL_255(d, a, alpha, 255 - d);
+    }
+}
+
+static void composition_solid_a8_xor(uint8_t* dest, int length, uint32_t alpha, uint32_t const_alpha)
+{
+    if(const_alpha != 255)
+        alpha = BYTE_MUL(alpha, const_alpha);
+    uint32_t sia = 255 - alpha;
+    for(int i = 0; i < length; i++) {
+        uint32_t d = dest[i];
+        dest[i] = INTERPOLATE_PIXEL_255(alpha, 255 - d, d, sia);
+    }
+}
+
+typedef void(*composition_solid_a8_function_t)(uint8_t* dest, int length, uint32_t alpha, uint32_t const_alpha);
+
+static const composition_solid_a8_function_t composition_solid_a8_table_scalar[] = {
+    composition_solid_a8_clear,
+    composition_solid_a8_source,
+    composition_solid_a8_destination,
+    composition_solid_a8_source_over,
+    composition_solid_a8_destination_over,
+    composition_solid_a8_source_in,
+    composition_solid_a8_destination_in,
+    composition_solid_a8_source_out,
+    composition_solid_a8_destination_out,
+    composition_solid_a8_source_atop,
+    composition_solid_a8_destination_atop,
+    composition_solid_a8_xor
+};
+
 static void composition_clear(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha)
 {
     if(const_alpha == 255) {
@@ -634,7 +838,7 @@ static void composition_xor(uint32_t* dest, int length, const uint32_t* src, uin
 
 typedef void(*composition_function_t)(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha);
 
-static const composition_function_t composition_table[] = {
+static const composition_function_t composition_table_scalar[] = {
     composition_clear,
     composition_source,
     composition_destination,
@@ -649,44 +853,1482 @@ static const composition_function_t composition_table[] = {
     composition_xor
 };
 
-static void blend_solid(plutovg_surface_t* surface, plutovg_operator_t op, uint32_t solid, const plutovg_span_buffer_t* span_buffer)
-{
-    composition_solid_function_t func = composition_solid_table[op];
-    int count = span_buffer->spans.size;
-    const plutovg_span_t* spans = span_buffer->spans.data;
-    while(count--) {
-        uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + spans->x;
-        func(target, spans->len, solid, spans->coverage);
-        ++spans;
-    }
-}
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
 
-#define BUFFER_SIZE 1024
-static void blend_linear_gradient(plutovg_surface_t* surface, plutovg_operator_t op, const gradient_data_t* gradient, const plutovg_span_buffer_t* span_buffer)
-{
-    composition_function_t func = composition_table[op];
-    unsigned int buffer[BUFFER_SIZE];
+#define PLUTOVG_HAS_X86_SIMD
+#include <immintrin.h>
 
-    linear_gradient_values_t v;
-    v.dx = gradient->values.linear.x2 - gradient->values.linear.x1;
-    v.dy = gradient->values.linear.y2 - gradient->values.linear.y1;
-    v.l = v.dx * v.dx + v.dy * v.dy;
-    v.off = 0.f;
-    if(v.l != 0.f) {
-        v.dx /= v.l;
-        v.dy /= v.l;
-        v.off = -v.dx * gradient->values.linear.x1 - v.dy * gradient->values.linear.y1;
+#if defined(__GNUC__) || defined(__clang__)
+#define PLUTOVG_TARGET_SSE2 __attribute__((target("sse2")))
+#define PLUTOVG_TARGET_AVX2 __attribute__((target("avx2")))
+#define PLUTOVG_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#include <intrin.h>
+#define PLUTOVG_TARGET_SSE2
+#define PLUTOVG_TARGET_AVX2
+#define PLUTOVG_TARGET_AVX512
+#endif
+
+PLUTOVG_TARGET_SSE2 static void memfill32_sse2(uint32_t* dest, int length, uint32_t value)
+{
+    __m128i vector_data = _mm_set1_epi32(value);
+    while(length && ((uintptr_t)dest & 0xf)) {
+        *dest++ = value;
+        length--;
     }
 
-    int count = span_buffer->spans.size;
-    const plutovg_span_t* spans = span_buffer->spans.data;
-    while(count--) {
-        int length = spans->len;
-        int x = spans->x;
-        while(length) {
+    while(length >= 32) {
+        _mm_store_si128((__m128i*)(dest), vector_data);
+        _mm_store_si128((__m128i*)(dest + 4), vector_data);
+        _mm_store_si128((__m128i*)(dest + 8), vector_data);
+        _mm_store_si128((__m128i*)(dest + 12), vector_data);
+        _mm_store_si128((__m128i*)(dest + 16), vector_data);
+        _mm_store_si128((__m128i*)(dest + 20), vector_data);
+        _mm_store_si128((__m128i*)(dest + 24), vector_data);
+        _mm_store_si128((__m128i*)(dest + 28), vector_data);
+
+        dest += 32;
+        length -= 32;
+    }
+
+    if(length >= 16) {
+        _mm_store_si128((__m128i*)(dest), vector_data);
+        _mm_store_si128((__m128i*)(dest + 4), vector_data);
+        _mm_store_si128((__m128i*)(dest + 8), vector_data);
+        _mm_store_si128((__m128i*)(dest + 12), vector_data);
+
+        dest += 16;
+        length -= 16;
+    }
+
+    if(length >= 8) {
+        _mm_store_si128((__m128i*)(dest), vector_data);
+        _mm_store_si128((__m128i*)(dest + 4), vector_data);
+
+        dest += 8;
+        length -= 8;
+    }
+
+    if(length >= 4) {
+        _mm_store_si128((__m128i*)(dest), vector_data);
+
+        dest += 4;
+        length -= 4;
+    }
+
+    while(length) {
+        *dest++ = value;
+        length--;
+    }
+}
+
+PLUTOVG_TARGET_SSE2 static void memfill32_stream_sse2(uint32_t* dest, int length, uint32_t value)
+{
+    __m128i vector_data = _mm_set1_epi32(value);
+    while(length && ((uintptr_t)dest & 0xf)) {
+        *dest++ = value;
+        length--;
+    }
+
+    while(length >= 16) {
+        _mm_stream_si128((__m128i*)(dest), vector_data);
+        _mm_stream_si128((__m128i*)(dest + 4), vector_data);
+        _mm_stream_si128((__m128i*)(dest + 8), vector_data);
+        _mm_stream_si128((__m128i*)(dest + 12), vector_data);
+
+        dest += 16;
+        length -= 16;
+    }
+
+    _mm_sfence();
+    while(length) {
+        *dest++ = value;
+        length--;
+    }
+}
+
+PLUTOVG_TARGET_SSE2 static inline __m128i byte_mul_sse2(__m128i x, __m128i a)
+{
+    x = _mm_mullo_epi16(x, a);
+    x = _mm_add_epi16(x, _mm_srli_epi16(x, 8));
+    x = _mm_add_epi16(x, _mm_set1_epi16(0x80));
+    return _mm_srli_epi16(x, 8);
+}
+
+PLUTOVG_TARGET_SSE2 static inline __m128i alpha_sse2(__m128i x)
+{
+    x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3));
+    return _mm_shufflehi_epi16(x, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+/* Computes BYTE_MUL(src, const_alpha) for four pixels. */
+PLUTOVG_TARGET_SSE2 static inline __m128i byte_mul_4_sse2(__m128i src, __m128i const_alpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = byte_mul_sse2(_mm_unpacklo_epi8(src, zero), const_alpha);
+    __m128i hi = byte_mul_sse2(_mm_unpackhi_epi8(src, zero), const_alpha);
+    return _mm_packus_epi16(lo, hi);
+}
+
+/* Computes src + BYTE_MUL(dest, 255 - alpha(src)) for four pixels. */
+PLUTOVG_TARGET_SSE2 static inline __m128i source_over_4_sse2(__m128i src, __m128i dest)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(0xff);
+    __m128i src_lo = _mm_unpacklo_epi8(src, zero);
+    __m128i src_hi = _mm_unpackhi_epi8(src, zero);
+    __m128i lo = byte_mul_sse2(_mm_unpacklo_epi8(dest, zero), _mm_sub_epi16(one, alpha_sse2(src_lo)));
+    __m128i hi = byte_mul_sse2(_mm_unpackhi_epi8(dest, zero), _mm_sub_epi16(one, alpha_sse2(src_hi)));
+    return _mm_add_epi8(src, _mm_packus_epi16(lo, hi));
+}
+
+/* Computes INTERPOLATE_PIXEL_255(src, a, dest, 255 - a) for four pixels. */
+PLUTOVG_TARGET_SSE2 static inline __m128i interpolate_4_sse2(__m128i src, __m128i dest, __m128i a)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i half = _mm_set1_epi16(0x80);
+    __m128i ia = _mm_sub_epi16(_mm_set1_epi16(0xff), a);
+    __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(src, zero), a), _mm_mullo_epi16(_mm_unpacklo_epi8(dest, zero), ia));
+    __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(src, zero), a), _mm_mullo_epi16(_mm_unpackhi_epi8(dest, zero), ia));
+    lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), half), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), half), 8);
+    return _mm_packus_epi16(lo, hi);
+}
+
+PLUTOVG_TARGET_SSE2 static void solid_source_over_sse2(uint32_t* dest, int length, uint32_t color, uint32_t ialpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i vcolor = _mm_set1_epi32(color);
+    const __m128i vialpha = _mm_set1_epi16(ialpha);
+    int i = 0;
+    for(; i + 4 <= length; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+        __m128i lo = byte_mul_sse2(_mm_unpacklo_epi8(d, zero), vialpha);
+        __m128i hi = byte_mul_sse2(_mm_unpackhi_epi8(d, zero), vialpha);
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_add_epi8(vcolor, _mm_packus_epi16(lo, hi)));
+    }
+
+    for(; i < length; i++) {
+        dest[i] = color + BYTE_MUL(dest[i], ialpha);
+    }
+}
+
+PLUTOVG_TARGET_SSE2 static void composition_solid_source_sse2(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha)
+{
+    if(const_alpha == 255) {
+        memfill32_sse2(dest, length, color);
+    } else {
+        solid_source_over_sse2(dest, length, BYTE_MUL(color, const_alpha), 255 - const_alpha);
+    }
+}
+
+PLUTOVG_TARGET_SSE2 static void composition_solid_source_over_sse2(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha)
+{
+    if(const_alpha != 255)
+        color = BYTE_MUL(color, const_alpha);
+    solid_source_over_sse2(dest, length, color, 255 - plutovg_alpha(color));
+}
+
+PLUTOVG_TARGET_SSE2 static void composition_solid_a8_source_over_sse2(uint8_t* dest, int length, uint32_t alpha, uint32_t const_alpha)
+{
+    if(const_alpha != 255)
+        alpha = BYTE_MUL(alpha, const_alpha);
+    uint32_t ialpha = 255 - alpha;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i valpha = _mm_set1_epi8((char)alpha);
+    const __m128i vialpha = _mm_set1_epi16(ialpha);
+    int i = 0;
+    for(; i + 16 <= length; i += 16) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+        __m128i lo = byte_mul_sse2(_mm_unpacklo_epi8(d, zero), vialpha);
+        __m128i hi = byte_mul_sse2(_mm_unpackhi_epi8(d, zero), vialpha);
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_add_epi8(valpha, _mm_packus_epi16(lo, hi)));
+    }
+
+    for(; i < length; i++) {
+        dest[i] = alpha + BYTE_MUL(dest[i], ialpha);
+    }
+}
+
+PLUTOVG_TARGET_SSE2 static void composition_source_sse2(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha)
+{
+    if(const_alpha == 255) {
+        memcpy(dest, src, length * sizeof(uint32_t));
+        return;
+    }
+
+    uint32_t ialpha = 255 - const_alpha;
+    const __m128i vconst_alpha = _mm_set1_epi16(const_alpha);
+    int i = 0;
+    for(; i + 4 <= length; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+        _mm_storeu_si128((__m128i*)(dest + i), interpolate_4_sse2(s, d, vconst_alpha));
+    }
+
+    for(; i < length; i++) {
+        dest[i] = INTERPOLATE_PIXEL_255(src[i], const_alpha, dest[i], ialpha);
+    }
+}
+
+PLUTOVG_TARGET_SSE2 static void composition_source_over_sse2(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha)
+{
+    const __m128i vconst_alpha = _mm_set1_epi16(const_alpha);
+    const __m128i opaque = _mm_set1_epi32(0xff000000);
+    int i = 0;
+    for(; i + 4 <= length; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        if(const_alpha == 255) {
+            int mask = _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, opaque), opaque));
+            if(mask == 0xffff) {
+                _mm_storeu_si128((__m128i*)(dest + i), s);
+                continue;
+            }
+
+            if(_mm_movemask_epi8(_mm_cmpeq_epi32(s, _mm_setzero_si128())) == 0xffff) {
+                continue;
+            }
+        } else {
+            s = byte_mul_4_sse2(s, vconst_alpha);
+        }
+
+        __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+        _mm_storeu_si128((__m128i*)(dest + i), source_over_4_sse2(s, d));
+    }
+
+    for(; i < length; i++) {
+        uint32_t s = src[i];
+        if(const_alpha != 255)
+            s = BYTE_MUL(s, const_alpha);
+        dest[i] = s + BYTE_MUL(dest[i], plutovg_alpha(~s));
+    }
+}
+
+PLUTOVG_TARGET_AVX2 static void memfill32_avx2(uint32_t* dest, int length, uint32_t value)
+{
+    __m256i vector_data = _mm256_set1_epi32(value);
+    while(length && ((uintptr_t)dest & 0x1f)) {
+        *dest++ = value;
+        length--;
+    }
+
+    while(length >= 32) {
+        _mm256_store_si256((__m256i*)(dest), vector_data);
+        _mm256_store_si256((__m256i*)(dest + 8), vector_data);
+        _mm256_store_si256((__m256i*)(dest + 16), vector_data);
+        _mm256_store_si256((__m256i*)(dest + 24), vector_data);
+
+        dest += 32;
+        length -= 32;
+    }
+
+    while(length >= 8) {
+        _mm256_store_si256((__m256i*)(dest), vector_data);
+
+        dest += 8;
+        length -= 8;
+    }
+
+    while(length) {
+        *dest++ = value;
+        length--;
+    }
+}
+
+PLUTOVG_TARGET_AVX2 static void memfill32_stream_avx2(uint32_t* dest, int length, uint32_t value)
+{
+    __m256i vector_data = _mm256_set1_epi32(value);
+    while(length && ((uintptr_t)dest & 0x1f)) {
+        *dest++ = value;
+        length--;
+    }
+
+    while(length >= 32) {
+        _mm256_stream_si256((__m256i*)(dest), vector_data);
+        _mm256_stream_si256((__m256i*)(dest + 8), vector_data);
+        _mm256_stream_si256((__m256i*)(dest + 16), vector_data);
+        _mm256_stream_si256((__m256i*)(dest + 24), vector_data);
+
+        dest += 32;
+        length -= 32;
+    }
+
+    _mm_sfence();
+    while(length) {
+        *dest++ = value;
+        length--;
+    }
+}
+
+PLUTOVG_TARGET_AVX2 static inline __m256i byte_mul_avx2(__m256i x, __m256i a)
+{
+    x = _mm256_mullo_epi16(x, a);
+    x = _mm256_add_epi16(x, _mm256_srli_epi16(x, 8));
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(0x80));
+    return _mm256_srli_epi16(x, 8);
+}
+
+PLUTOVG_TARGET_AVX2 static inline __m256i alpha_avx2(__m256i x)
+{
+    x = _mm256_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3));
+    return _mm256_shufflehi_epi16(x, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+PLUTOVG_TARGET_AVX2 static inline __m256i byte_mul_8_avx2(__m256i src, __m256i const_alpha)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i lo = byte_mul_avx2(_mm256_unpacklo_epi8(src, zero), const_alpha);
+    __m256i hi = byte_mul_avx2(_mm256_unpackhi_epi8(src, zero), const_alpha);
+    return _mm256_packus_epi16(lo, hi);
+}
+
+PLUTOVG_TARGET_AVX2 static inline __m256i source_over_8_avx2(__m256i src, __m256i dest)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi16(0xff);
+    __m256i src_lo = _mm256_unpacklo_epi8(src, zero);
+    __m256i src_hi = _mm256_unpackhi_epi8(src, zero);
+    __m256i lo = byte_mul_avx2(_mm256_unpacklo_epi8(dest, zero), _mm256_sub_epi16(one, alpha_avx2(src_lo)));
+    __m256i hi = byte_mul_avx2(_mm256_unpackhi_epi8(dest, zero), _mm256_sub_epi16(one, alpha_avx2(src_hi)));
+    return _mm256_add_epi8(src, _mm256_packus_epi16(lo, hi));
+}
+
+PLUTOVG_TARGET_AVX2 static inline __m256i interpolate_8_avx2(__m256i src, __m256i dest, __m256i a)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i half = _mm256_set1_epi16(0x80);
+    __m256i ia = _mm256_sub_epi16(_mm256_set1_epi16(0xff), a);
+    __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(src, zero), a), _mm256_mullo_epi16(_mm256_unpacklo_epi8(dest, zero), ia));
+    __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(src, zero), a), _mm256_mullo_epi16(_mm256_unpackhi_epi8(dest, zero), ia));
+    lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), half), 8);
+    hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), half), 8);
+    return _mm256_packus_epi16(lo, hi);
+}
+
+PLUTOVG_TARGET_AVX2 static void solid_source_over_avx2(uint32_t* dest, int length, uint32_t color, uint32_t ialpha)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i vcolor = _mm256_set1_epi32(color);
+    const __m256i vialpha = _mm256_set1_epi16(ialpha);
+    int i = 0;
+    for(; i + 8 <= length; i += 8) {
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dest + i));
+        __m256i lo = byte_mul_avx2(_mm256_unpacklo_epi8(d, zero), vialpha);
+        __m256i hi = byte_mul_avx2(_mm256_unpackhi_epi8(d, zero), vialpha);
+        _mm256_storeu_si256((__m256i*)(dest + i), _mm256_add_epi8(vcolor, _mm256_packus_epi16(lo, hi)));
+    }
+
+    for(; i < length; i++) {
+        dest[i] = color + BYTE_MUL(dest[i], ialpha);
+    }
+}
+
+PLUTOVG_TARGET_AVX2 static void composition_solid_source_avx2(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha)
+{
+    if(const_alpha == 255) {
+        memfill32_avx2(dest, length, color);
+    } else {
+        solid_source_over_avx2(dest, length, BYTE_MUL(color, const_alpha), 255 - const_alpha);
+    }
+}
+
+PLUTOVG_TARGET_AVX2 static void composition_solid_source_over_avx2(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha)
+{
+    if(const_alpha != 255)
+        color = BYTE_MUL(color, const_alpha);
+    solid_source_over_avx2(dest, length, color, 255 - plutovg_alpha(color));
+}
+
+PLUTOVG_TARGET_AVX2 static void composition_source_avx2(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha)
+{
+    if(const_alpha == 255) {
+        memcpy(dest, src, length * sizeof(uint32_t));
+        return;
+    }
+
+    uint32_t ialpha = 255 - const_alpha;
+    const __m256i vconst_alpha = _mm256_set1_epi16(const_alpha);
+    int i = 0;
+    for(; i + 8 <= length; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dest + i));
+        _mm256_storeu_si256((__m256i*)(dest + i), interpolate_8_avx2(s, d, vconst_alpha));
+    }
+
+    for(; i < length; i++) {
+        dest[i] = INTERPOLATE_PIXEL_255(src[i], const_alpha, dest[i], ialpha);
+    }
+}
+
+PLUTOVG_TARGET_AVX2 static void composition_source_over_avx2(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha)
+{
+    const __m256i vconst_alpha = _mm256_set1_epi16(const_alpha);
+    const __m256i opaque = _mm256_set1_epi32(0xff000000);
+    int i = 0;
+    for(; i + 8 <= length; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        if(const_alpha == 255) {
+            if(_mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_and_si256(s, opaque), opaque)) == -1) {
+                _mm256_storeu_si256((__m256i*)(dest + i), s);
+                continue;
+            }
+
+            if(_mm256_testz_si256(s, s)) {
+                continue;
+            }
+        } else {
+            s = byte_mul_8_avx2(s, vconst_alpha);
+        }
+
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dest + i));
+        _mm256_storeu_si256((__m256i*)(dest + i), source_over_8_avx2(s, d));
+    }
+
+    for(; i < length; i++) {
+        uint32_t s = src[i];
+        if(const_alpha != 255)
+            s = BYTE_MUL(s, const_alpha);
+        dest[i] = s + BYTE_MUL(dest[i], plutovg_alpha(~s));
+    }
+}
+
+PLUTOVG_TARGET_SSE2 static inline __m128i gradient_clamp_sse2(const gradient_data_t* gradient, __m128i ipos)
+{
+    if(gradient->spread == PLUTOVG_SPREAD_METHOD_REPEAT)
+        return _mm_and_si128(ipos, _mm_set1_epi32(COLOR_TABLE_SIZE - 1));
+    if(gradient->spread == PLUTOVG_SPREAD_METHOD_REFLECT) {
+        const __m128i limit = _mm_set1_epi32(COLOR_TABLE_SIZE * 2 - 1);
+        ipos = _mm_and_si128(ipos, limit);
+        __m128i mirror = _mm_cmpgt_epi32(ipos, _mm_set1_epi32(COLOR_TABLE_SIZE - 1));
+        return _mm_xor_si128(ipos, _mm_and_si128(mirror, limit));
+    }
+
+    const __m128i last = _mm_set1_epi32(COLOR_TABLE_SIZE - 1);
+    ipos = _mm_and_si128(ipos, _mm_cmpgt_epi32(ipos, _mm_setzero_si128()));
+    __m128i over = _mm_cmpgt_epi32(ipos, last);
+    return _mm_or_si128(_mm_andnot_si128(over, ipos), _mm_and_si128(over, last));
+}
+
+PLUTOVG_TARGET_SSE2 static inline __m128i gradient_pixel_4_sse2(const gradient_data_t* gradient, __m128i ipos)
+{
+    int32_t index[4];
+    _mm_storeu_si128((__m128i*)index, gradient_clamp_sse2(gradient, ipos));
+    const uint32_t* colortable = gradient->colortable;
+    return _mm_setr_epi32(colortable[index[0]], colortable[index[1]], colortable[index[2]], colortable[index[3]]);
+}
+
+PLUTOVG_TARGET_SSE2 static void fetch_linear_gradient_sse2(uint32_t* buffer, const linear_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length)
+{
+    float t, inc;
+    linear_gradient_position(v, gradient, y, x, &t, &inc);
+    if(linear_gradient_is_constant(inc) || !linear_gradient_fits_fixed(t, inc, length)) {
+        fetch_linear_gradient(buffer, v, gradient, y, x, length);
+        return;
+    }
+
+    uint32_t t_fixed = (uint32_t)(int)(t * FIXPT_SIZE) + FIXPT_SIZE / 2;
+    uint32_t inc_fixed = (uint32_t)(int)(inc * FIXPT_SIZE);
+    __m128i vt = _mm_setr_epi32(t_fixed, t_fixed + inc_fixed, t_fixed + 2 * inc_fixed, t_fixed + 3 * inc_fixed);
+    const __m128i vinc = _mm_set1_epi32(4 * inc_fixed);
+
+    int i = 0;
+    for(; i + 4 <= length; i += 4) {
+        _mm_storeu_si128((__m128i*)(buffer + i), gradient_pixel_4_sse2(gradient, _mm_srai_epi32(vt, FIXPT_BITS)));
+        vt = _mm_add_epi32(vt, vinc);
+    }
+
+    if(i < length) {
+        uint32_t pixels[4];
+        _mm_storeu_si128((__m128i*)pixels, gradient_pixel_4_sse2(gradient, _mm_srai_epi32(vt, FIXPT_BITS)));
+        memcpy(buffer + i, pixels, (length - i) * sizeof(uint32_t));
+    }
+}
+
+PLUTOVG_TARGET_SSE2 static void fetch_radial_gradient_sse2(uint32_t* buffer, const radial_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length)
+{
+    if(v->a == 0.f) {
+        plutovg_memfill32(buffer, length, 0);
+        return;
+    }
+
+    radial_gradient_step_t step;
+    radial_gradient_step_init(&step, v, gradient, y, x);
+
+    float b[4], det[4], delta_det[4];
+    for(int i = 0; i < 4; i++) {
+        b[i] = step.b;
+        det[i] = step.det;
+        delta_det[i] = step.delta_det;
+        step.det += step.delta_det;
+        step.delta_det += step.delta_delta_det;
+        step.b += step.delta_b;
+    }
+
+    __m128 vb = _mm_loadu_ps(b);
+    __m128 vdet = _mm_loadu_ps(det);
+    __m128 vdelta_det = _mm_loadu_ps(delta_det);
+    const __m128 vdelta_b = _mm_set1_ps(4 * step.delta_b);
+    const __m128 vdet_bias = _mm_set1_ps(6 * step.delta_delta_det);
+    const __m128 vdelta_delta_det = _mm_set1_ps(4 * step.delta_delta_det);
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 four = _mm_set1_ps(4.f);
+    const __m128 scale = _mm_set1_ps(COLOR_TABLE_SIZE - 1);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 fr = _mm_set1_ps(gradient->values.radial.fr);
+    const __m128 dr = _mm_set1_ps(v->dr);
+
+    for(int i = 0; i < length; i += 4) {
+        __m128 w = _mm_sub_ps(_mm_sqrt_ps(vdet), vb);
+        __m128i ipos = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(w, scale), half));
+        __m128i pixels = gradient_pixel_4_sse2(gradient, ipos);
+        if(v->extended) {
+            __m128 mask = _mm_and_ps(_mm_cmpge_ps(vdet, zero), _mm_cmpge_ps(_mm_add_ps(fr, _mm_mul_ps(dr, w)), zero));
+            pixels = _mm_and_si128(pixels, _mm_castps_si128(mask));
+        }
+
+        if(i + 4 <= length) {
+            _mm_storeu_si128((__m128i*)(buffer + i), pixels);
+        } else {
+            uint32_t tail[4];
+            _mm_storeu_si128((__m128i*)tail, pixels);
+            memcpy(buffer + i, tail, (length - i) * sizeof(uint32_t));
+        }
+
+        vdet = _mm_add_ps(vdet, _mm_add_ps(_mm_mul_ps(four, vdelta_det), vdet_bias));
+        vdelta_det = _mm_add_ps(vdelta_det, vdelta_delta_det);
+        vb = _mm_add_ps(vb, vdelta_b);
+    }
+}
+
+/* Computes interpolate_4_pixels() for four pixels; distx and disty hold one weight per 32-bit lane. */
+PLUTOVG_TARGET_SSE2 static inline __m128i interpolate_4_pixels_sse2(__m128i tl, __m128i tr, __m128i bl, __m128i br, __m128i distx, __m128i disty)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i full = _mm_set1_epi16(256);
+    distx = _mm_or_si128(distx, _mm_slli_epi32(distx, 16));
+    disty = _mm_or_si128(disty, _mm_slli_epi32(disty, 16));
+
+    __m128i dx_lo = _mm_unpacklo_epi32(distx, distx);
+    __m128i dx_hi = _mm_unpackhi_epi32(distx, distx);
+    __m128i dy_lo = _mm_unpacklo_epi32(disty, disty);
+    __m128i dy_hi = _mm_unpackhi_epi32(disty, disty);
+    __m128i idx_lo = _mm_sub_epi16(full, dx_lo);
+    __m128i idx_hi = _mm_sub_epi16(full, dx_hi);
+
+    __m128i top_lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(tl, zero), idx_lo), _mm_mullo_epi16(_mm_unpacklo_epi8(tr, zero), dx_lo)), 8);
+    __m128i top_hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(tl, zero), idx_hi), _mm_mullo_epi16(_mm_unpackhi_epi8(tr, zero), dx_hi)), 8);
+    __m128i bot_lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(bl, zero), idx_lo), _mm_mullo_epi16(_mm_unpacklo_epi8(br, zero), dx_lo)), 8);
+    __m128i bot_hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(bl, zero), idx_hi), _mm_mullo_epi16(_mm_unpackhi_epi8(br, zero), dx_hi)), 8);
+
+    __m128i lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(top_lo, _mm_sub_epi16(full, dy_lo)), _mm_mullo_epi16(bot_lo, dy_lo)), 8);
+    __m128i hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(top_hi, _mm_sub_epi16(full, dy_hi)), _mm_mullo_epi16(bot_hi, dy_hi)), 8);
+    return _mm_packus_epi16(lo, hi);
+}
+
+PLUTOVG_TARGET_SSE2 static void fetch_bilinear_sse2(uint32_t* buffer, const texture_data_t* texture, int fx, int fy, int fdx, int fdy, int length)
+{
+    uint32_t tl[4], tr[4], bl[4], br[4];
+    uint32_t distx[4], disty[4];
+    int i = 0;
+    for(; i + 4 <= length; i += 4) {
+        for(int k = 0; k < 4; k++) {
+            int x1 = fx >> 16;
+            int y1 = fy >> 16;
+            const uint32_t* s1 = (const uint32_t*)(texture->data + (ptrdiff_t)y1 * texture->stride);
+            const uint32_t* s2 = (const uint32_t*)(texture->data + (ptrdiff_t)(y1 + 1) * texture->stride);
+            tl[k] = s1[x1];
+            tr[k] = s1[x1 + 1];
+            bl[k] = s2[x1];
+            br[k] = s2[x1 + 1];
+            distx[k] = (fx & 0x0000ffff) >> 8;
+            disty[k] = (fy & 0x0000ffff) >> 8;
+            fx += fdx;
+            fy += fdy;
+        }
+
+        __m128i pixels = interpolate_4_pixels_sse2(_mm_loadu_si128((const __m128i*)tl), _mm_loadu_si128((const __m128i*)tr),
+                                                   _mm_loadu_si128((const __m128i*)bl), _mm_loadu_si128((const __m128i*)br),
+                                                   _mm_loadu_si128((const __m128i*)distx), _mm_loadu_si128((const __m128i*)disty));
+        _mm_storeu_si128((__m128i*)(buffer + i), pixels);
+    }
+
+    for(; i < length; i++) {
+        buffer[i] = fetch_bilinear_pixel(texture, &fx, &fy, fdx, fdy);
+    }
+}
+
+/* Sums horizontal pixel pairs of two rows of four pixels into two 16-bit pixels. */
+PLUTOVG_TARGET_SSE2 static inline __m128i downsample_2_sse2(__m128i row0, __m128i row1)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(row0, zero), _mm_unpacklo_epi8(row1, zero));
+    __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(row0, zero), _mm_unpackhi_epi8(row1, zero));
+    lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+    hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+    __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_set1_epi16(2));
+    return _mm_srli_epi16(sum, 2);
+}
+
+PLUTOVG_TARGET_SSE2 static void downsample_sse2(uint32_t* dest, const uint32_t* row0, const uint32_t* row1, int width)
+{
+    int i = 0;
+    for(; i + 4 <= width; i += 4) {
+        __m128i a = downsample_2_sse2(_mm_loadu_si128((const __m128i*)(row0 + 2 * i)), _mm_loadu_si128((const __m128i*)(row1 + 2 * i)));
+        __m128i b = downsample_2_sse2(_mm_loadu_si128((const __m128i*)(row0 + 2 * i + 4)), _mm_loadu_si128((const __m128i*)(row1 + 2 * i + 4)));
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_packus_epi16(a, b));
+    }
+
+    downsample(dest + i, row0 + 2 * i, row1 + 2 * i, width - i);
+}
+
+PLUTOVG_TARGET_AVX2 static inline __m256i gradient_clamp_avx2(const gradient_data_t* gradient, __m256i ipos)
+{
+    if(gradient->spread == PLUTOVG_SPREAD_METHOD_REPEAT)
+        return _mm256_and_si256(ipos, _mm256_set1_epi32(COLOR_TABLE_SIZE - 1));
+    if(gradient->spread == PLUTOVG_SPREAD_METHOD_REFLECT) {
+        const __m256i limit = _mm256_set1_epi32(COLOR_TABLE_SIZE * 2 - 1);
+        ipos = _mm256_and_si256(ipos, limit);
+        __m256i mirror = _mm256_cmpgt_epi32(ipos, _mm256_set1_epi32(COLOR_TABLE_SIZE - 1));
+        return _mm256_xor_si256(ipos, _mm256_and_si256(mirror, limit));
+    }
+
+    ipos = _mm256_max_epi32(ipos, _mm256_setzero_si256());
+    return _mm256_min_epi32(ipos, _mm256_set1_epi32(COLOR_TABLE_SIZE - 1));
+}
+
+PLUTOVG_TARGET_AVX2 static inline __m256i gradient_pixel_8_avx2(const gradient_data_t* gradient, __m256i ipos)
+{
+    return _mm256_i32gather_epi32((const int*)gradient->colortable, gradient_clamp_avx2(gradient, ipos), 4);
+}
+
+PLUTOVG_TARGET_AVX2 static void fetch_linear_gradient_avx2(uint32_t* buffer, const linear_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length)
+{
+    float t, inc;
+    linear_gradient_position(v, gradient, y, x, &t, &inc);
+    if(linear_gradient_is_constant(inc) || !linear_gradient_fits_fixed(t, inc, length)) {
+        fetch_linear_gradient(buffer, v, gradient, y, x, length);
+        return;
+    }
+
+    uint32_t t_fixed = (uint32_t)(int)(t * FIXPT_SIZE) + FIXPT_SIZE / 2;
+    uint32_t inc_fixed = (uint32_t)(int)(inc * FIXPT_SIZE);
+    __m256i vt = _mm256_add_epi32(_mm256_set1_epi32(t_fixed), _mm256_mullo_epi32(_mm256_set1_epi32(inc_fixed), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+    const __m256i vinc = _mm256_set1_epi32(8 * inc_fixed);
+
+    int i = 0;
+    for(; i + 8 <= length; i += 8) {
+        _mm256_storeu_si256((__m256i*)(buffer + i), gradient_pixel_8_avx2(gradient, _mm256_srai_epi32(vt, FIXPT_BITS)));
+        vt = _mm256_add_epi32(vt, vinc);
+    }
+
+    if(i < length) {
+        uint32_t pixels[8];
+        _mm256_storeu_si256((__m256i*)pixels, gradient_pixel_8_avx2(gradient, _mm256_srai_epi32(vt, FIXPT_BITS)));
+        memcpy(buffer + i, pixels, (length - i) * sizeof(uint32_t));
+    }
+}
+
+PLUTOVG_TARGET_AVX2 static void fetch_radial_gradient_avx2(uint32_t* buffer, const radial_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length)
+{
+    if(v->a == 0.f) {
+        plutovg_memfill32(buffer, length, 0);
+        return;
+    }
+
+    radial_gradient_step_t step;
+    radial_gradient_step_init(&step, v, gradient, y, x);
+
+    float b[8], det[8], delta_det[8];
+    for(int i = 0; i < 8; i++) {
+        b[i] = step.b;
+        det[i] = step.det;
+        delta_det[i] = step.delta_det;
+        step.det += step.delta_det;
+        step.delta_det += step.delta_delta_det;
+        step.b += step.delta_b;
+    }
+
+    __m256 vb = _mm256_loadu_ps(b);
+    __m256 vdet = _mm256_loadu_ps(det);
+    __m256 vdelta_det = _mm256_loadu_ps(delta_det);
+    const __m256 vdelta_b = _mm256_set1_ps(8 * step.delta_b);
+    const __m256 vdet_bias = _mm256_set1_ps(28 * step.delta_delta_det);
+    const __m256 vdelta_delta_det = _mm256_set1_ps(8 * step.delta_delta_det);
+
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 eight = _mm256_set1_ps(8.f);
+    const __m256 scale = _mm256_set1_ps(COLOR_TABLE_SIZE - 1);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 fr = _mm256_set1_ps(gradient->values.radial.fr);
+    const __m256 dr = _mm256_set1_ps(v->dr);
+
+    for(int i = 0; i < length; i += 8) {
+        __m256 w = _mm256_sub_ps(_mm256_sqrt_ps(vdet), vb);
+        __m256i ipos = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(w, scale), half));
+        __m256i pixels = gradient_pixel_8_avx2(gradient, ipos);
+        if(v->extended) {
+            __m256 inside = _mm256_cmp_ps(_mm256_add_ps(fr, _mm256_mul_ps(dr, w)), zero, _CMP_GE_OQ);
+            __m256 mask = _mm256_and_ps(_mm256_cmp_ps(vdet, zero, _CMP_GE_OQ), inside);
+            pixels = _mm256_and_si256(pixels, _mm256_castps_si256(mask));
+        }
+
+        if(i + 8 <= length) {
+            _mm256_storeu_si256((__m256i*)(buffer + i), pixels);
+        } else {
+            uint32_t tail[8];
+            _mm256_storeu_si256((__m256i*)tail, pixels);
+            memcpy(buffer + i, tail, (length - i) * sizeof(uint32_t));
+        }
+
+        vdet = _mm256_add_ps(vdet, _mm256_add_ps(_mm256_mul_ps(eight, vdelta_det), vdet_bias));
+        vdelta_det = _mm256_add_ps(vdelta_det, vdelta_delta_det);
+        vb = _mm256_add_ps(vb, vdelta_b);
+    }
+}
+
+PLUTOVG_TARGET_AVX2 static void fetch_nearest_avx2(uint32_t* buffer, const texture_data_t* texture, int x, int y, int fdx, int fdy, int length)
+{
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i vstride = _mm256_set1_epi32(texture->stride);
+    const __m256i vdx = _mm256_set1_epi32(fdx * 8);
+    const __m256i vdy = _mm256_set1_epi32(fdy * 8);
+    __m256i vx = _mm256_add_epi32(_mm256_set1_epi32(x), _mm256_mullo_epi32(_mm256_set1_epi32(fdx), lanes));
+    __m256i vy = _mm256_add_epi32(_mm256_set1_epi32(y), _mm256_mullo_epi32(_mm256_set1_epi32(fdy), lanes));
+    int i = 0;
+    for(; i + 8 <= length; i += 8) {
+        __m256i offset = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_srai_epi32(vy, 16), vstride), _mm256_slli_epi32(_mm256_srai_epi32(vx, 16), 2));
+        _mm256_storeu_si256((__m256i*)(buffer + i), _mm256_i32gather_epi32((const int*)texture->data, offset, 1));
+        vx = _mm256_add_epi32(vx, vdx);
+        vy = _mm256_add_epi32(vy, vdy);
+    }
+
+    x += i * fdx;
+    y += i * fdy;
+    for(; i < length; i++) {
+        buffer[i] = fetch_nearest_pixel(texture, &x, &y, fdx, fdy);
+    }
+}
+
+/* Computes interpolate_4_pixels() for eight pixels; distx and disty hold one weight per 32-bit lane. */
+PLUTOVG_TARGET_AVX2 static inline __m256i interpolate_8_pixels_avx2(__m256i tl, __m256i tr, __m256i bl, __m256i br, __m256i distx, __m256i disty)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i full = _mm256_set1_epi16(256);
+    distx = _mm256_or_si256(distx, _mm256_slli_epi32(distx, 16));
+    disty = _mm256_or_si256(disty, _mm256_slli_epi32(disty, 16));
+
+    __m256i dx_lo = _mm256_unpacklo_epi32(distx, distx);
+    __m256i dx_hi = _mm256_unpackhi_epi32(distx, distx);
+    __m256i dy_lo = _mm256_unpacklo_epi32(disty, disty);
+    __m256i dy_hi = _mm256_unpackhi_epi32(disty, disty);
+    __m256i idx_lo = _mm256_sub_epi16(full, dx_lo);
+    __m256i idx_hi = _mm256_sub_epi16(full, dx_hi);
+
+    __m256i top_lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(tl, zero), idx_lo), _mm256_mullo_epi16(_mm256_unpacklo_epi8(tr, zero), dx_lo)), 8);
+    __m256i top_hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(tl, zero), idx_hi), _mm256_mullo_epi16(_mm256_unpackhi_epi8(tr, zero), dx_hi)), 8);
+    __m256i bot_lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(bl, zero), idx_lo), _mm256_mullo_epi16(_mm256_unpacklo_epi8(br, zero), dx_lo)), 8);
+    __m256i bot_hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(bl, zero), idx_hi), _mm256_mullo_epi16(_mm256_unpackhi_epi8(br, zero), dx_hi)), 8);
+
+    __m256i lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(top_lo, _mm256_sub_epi16(full, dy_lo)), _mm256_mullo_epi16(bot_lo, dy_lo)), 8);
+    __m256i hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(top_hi, _mm256_sub_epi16(full, dy_hi)), _mm256_mullo_epi16(bot_hi, dy_hi)), 8);
+    return _mm256_packus_epi16(lo, hi);
+}
+
+PLUTOVG_TARGET_AVX2 static void fetch_bilinear_avx2(uint32_t* buffer, const texture_data_t* texture, int fx, int fy, int fdx, int fdy, int length)
+{
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i mask = _mm256_set1_epi32(0xff);
+    const __m256i vstride = _mm256_set1_epi32(texture->stride);
+    const __m256i vdx = _mm256_set1_epi32(fdx * 8);
+    const __m256i vdy = _mm256_set1_epi32(fdy * 8);
+    const int* data = (const int*)texture->data;
+    const int* next = (const int*)(texture->data + texture->stride);
+    __m256i vx = _mm256_add_epi32(_mm256_set1_epi32(fx), _mm256_mullo_epi32(_mm256_set1_epi32(fdx), lanes));
+    __m256i vy = _mm256_add_epi32(_mm256_set1_epi32(fy), _mm256_mullo_epi32(_mm256_set1_epi32(fdy), lanes));
+    int i = 0;
+    for(; i + 8 <= length; i += 8) {
+        __m256i offset = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_srai_epi32(vy, 16), vstride), _mm256_slli_epi32(_mm256_srai_epi32(vx, 16), 2));
+        __m256i tl = _mm256_i32gather_epi32(data, offset, 1);
+        __m256i tr = _mm256_i32gather_epi32(data + 1, offset, 1);
+        __m256i bl = _mm256_i32gather_epi32(next, offset, 1);
+        __m256i br = _mm256_i32gather_epi32(next + 1, offset, 1);
+        __m256i distx = _mm256_and_si256(_mm256_srli_epi32(vx, 8), mask);
+        __m256i disty = _mm256_and_si256(_mm256_srli_epi32(vy, 8), mask);
+        _mm256_storeu_si256((__m256i*)(buffer + i), interpolate_8_pixels_avx2(tl, tr, bl, br, distx, disty));
+        vx = _mm256_add_epi32(vx, vdx);
+        vy = _mm256_add_epi32(vy, vdy);
+    }
+
+    fx += i * fdx;
+    fy += i * fdy;
+    for(; i < length; i++) {
+        buffer[i] = fetch_bilinear_pixel(texture, &fx, &fy, fdx, fdy);
+    }
+}
+
+PLUTOVG_TARGET_AVX512 static void memfill32_avx512(uint32_t* dest, int length, uint32_t value)
+{
+    __m512i vector_data = _mm512_set1_epi32(value);
+    while(length && ((uintptr_t)dest & 0x3f)) {
+        *dest++ = value;
+        length--;
+    }
+
+    while(length >= 64) {
+        _mm512_store_si512((void*)(dest), vector_data);
+        _mm512_store_si512((void*)(dest + 16), vector_data);
+        _mm512_store_si512((void*)(dest + 32), vector_data);
+        _mm512_store_si512((void*)(dest + 48), vector_data);
+
+        dest += 64;
+        length -= 64;
+    }
+
+    while(length >= 16) {
+        _mm512_store_si512((void*)(dest), vector_data);
+
+        dest += 16;
+        length -= 16;
+    }
+
+    while(length) {
+        *dest++ = value;
+        length--;
+    }
+}
+
+PLUTOVG_TARGET_AVX512 static void memfill32_stream_avx512(uint32_t* dest, int length, uint32_t value)
+{
+    __m512i vector_data = _mm512_set1_epi32(value);
+    while(length && ((uintptr_t)dest & 0x3f)) {
+        *dest++ = value;
+        length--;
+    }
+
+    while(length >= 64) {
+        _mm512_stream_si512((void*)(dest), vector_data);
+        _mm512_stream_si512((void*)(dest + 16), vector_data);
+        _mm512_stream_si512((void*)(dest + 32), vector_data);
+        _mm512_stream_si512((void*)(dest + 48), vector_data);
+
+        dest += 64;
+        length -= 64;
+    }
+
+    while(length >= 16) {
+        _mm512_stream_si512((void*)(dest), vector_data);
+
+        dest += 16;
+        length -= 16;
+    }
+
+    _mm_sfence();
+    while(length) {
+        *dest++ = value;
+        length--;
+    }
+}
+
+static plutovg_cpu_level_t plutovg_cpu_detect(void)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f"))
+        return PLUTOVG_CPU_LEVEL_AVX512;
+    if(__builtin_cpu_supports("avx2"))
+        return PLUTOVG_CPU_LEVEL_AVX2;
+    if(__builtin_cpu_supports("sse2"))
+        return PLUTOVG_CPU_LEVEL_SSE2;
+    return PLUTOVG_CPU_LEVEL_SCALAR;
+#else
+    int info[4];
+    __cpuid(info, 0);
+    int max_leaf = info[0];
+    __cpuid(info, 1);
+    if((info[3] & (1 << 26)) == 0)
+        return PLUTOVG_CPU_LEVEL_SCALAR;
+    if((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || max_leaf < 7)
+        return PLUTOVG_CPU_LEVEL_SSE2;
+    unsigned long long xcr0 = _xgetbv(0);
+    if((xcr0 & 0x6) != 0x6)
+        return PLUTOVG_CPU_LEVEL_SSE2;
+    __cpuidex(info, 7, 0);
+    if((info[1] & (1 << 16)) && (xcr0 & 0xe6) == 0xe6)
+        return PLUTOVG_CPU_LEVEL_AVX512;
+    if(info[1] & (1 << 5))
+        return PLUTOVG_CPU_LEVEL_AVX2;
+    return PLUTOVG_CPU_LEVEL_SSE2;
+#endif
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#include <cpuid.h>
+#define plutovg_cpuid(info, leaf, subleaf) __cpuid_count(leaf, subleaf, (info)[0], (info)[1], (info)[2], (info)[3])
+#else
+#define plutovg_cpuid(info, leaf, subleaf) __cpuidex((int*)(info), leaf, subleaf)
+#endif
+
+static size_t plutovg_cache_size_from_leaf(unsigned int leaf)
+{
+    size_t size = 0;
+    for(unsigned int index = 0; index < 16; ++index) {
+        unsigned int info[4];
+        plutovg_cpuid(info, leaf, index);
+        unsigned int type = info[0] & 0x1f;
+        if(type == 0)
+            break;
+        if(type == 2)
+            continue;
+        size_t ways = ((info[1] >> 22) & 0x3ff) + 1;
+        size_t partitions = ((info[1] >> 12) & 0x3ff) + 1;
+        size_t line_size = (info[1] & 0xfff) + 1;
+        size_t sets = (size_t)info[2] + 1;
+        size_t cache_size = ways * partitions * line_size * sets;
+        if(size < cache_size) {
+            size = cache_size;
+        }
+    }
+
+    return size;
+}
+
+static size_t plutovg_cache_size(void)
+{
+    unsigned int info[4];
+    plutovg_cpuid(info, 0, 0);
+    if(info[0] >= 4) {
+        size_t size = plutovg_cache_size_from_leaf(4);
+        if(size > 0) {
+            return size;
+        }
+    }
+
+    plutovg_cpuid(info, 0x80000000, 0);
+    if(info[0] >= 0x8000001d)
+        return plutovg_cache_size_from_leaf(0x8000001d);
+    return 0;
+}
+
+#else
+
+static plutovg_cpu_level_t plutovg_cpu_detect(void)
+{
+    return PLUTOVG_CPU_LEVEL_SCALAR;
+}
+
+static size_t plutovg_cache_size(void)
+{
+    return 0;
+}
+
+#endif // x86
+
+typedef void(*memfill32_function_t)(uint32_t* dest, int length, uint32_t value);
+typedef void(*fetch_linear_gradient_function_t)(uint32_t* buffer, const linear_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length);
+typedef void(*fetch_radial_gradient_function_t)(uint32_t* buffer, const radial_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length);
+typedef void(*fetch_texture_function_t)(uint32_t* buffer, const texture_data_t* texture, int x, int y, int fdx, int fdy, int length);
+typedef void(*downsample_function_t)(uint32_t* dest, const uint32_t* row0, const uint32_t* row1, int width);
+
+/*
+ * Every kernel variant for one CPU level. The sets are constant, so selecting a level is a
+ * single pointer store that threads drawing concurrently can never observe half done.
+ */
+typedef struct {
+    plutovg_cpu_level_t level;
+    memfill32_function_t memfill32;
+    memfill32_function_t memfill32_stream;
+    fetch_linear_gradient_function_t fetch_linear_gradient;
+    fetch_radial_gradient_function_t fetch_radial_gradient;
+    fetch_texture_function_t fetch_nearest;
+    fetch_texture_function_t fetch_bilinear;
+    downsample_function_t downsample;
+    const composition_solid_function_t* composition_solid_table;
+    const composition_function_t* composition_table;
+    const composition_solid_a8_function_t* composition_solid_a8_table;
+} blend_functions_t;
+
+static const blend_functions_t blend_functions_scalar = {
+    PLUTOVG_CPU_LEVEL_SCALAR,
+    memfill32,
+    memfill32,
+    fetch_linear_gradient,
+    fetch_radial_gradient,
+    fetch_nearest,
+    fetch_bilinear,
+    downsample,
+    composition_solid_table_scalar,
+    composition_table_scalar,
+    composition_solid_a8_table_scalar
+};
+
+#if defined(PLUTOVG_HAS_X86_SIMD)
+
+static const composition_solid_function_t composition_solid_table_sse2[] = {
+    composition_solid_clear,
+    composition_solid_source_sse2,
+    composition_solid_destination,
+    composition_solid_source_over_sse2,
+    composition_solid_destination_over,
+    composition_solid_source_in,
+    composition_solid_destination_in,
+    composition_solid_source_out,
+    composition_solid_destination_out,
+    composition_solid_source_atop,
+    composition_solid_destination_atop,
+    composition_solid_xor
+};
+
+static const composition_function_t composition_table_sse2[] = {
+    composition_clear,
+    composition_source_sse2,
+    composition_destination,
+    composition_source_over_sse2,
+    composition_destination_over,
+    composition_source_in,
+    composition_destination_in,
+    composition_source_out,
+    composition_destination_out,
+    composition_source_atop,
+    composition_destination_atop,
+    composition_xor
+};
+
+static const composition_solid_a8_function_t composition_solid_a8_table_sse2[] = {
+    composition_solid_a8_clear,
+    composition_solid_a8_source,
+    composition_solid_a8_destination,
+    composition_solid_a8_source_over_sse2,
+    composition_solid_a8_destination_over,
+    composition_solid_a8_source_in,
+    composition_solid_a8_destination_in,
+    composition_solid_a8_source_out,
+    composition_solid_a8_destination_out,
+    composition_solid_a8_source_atop,
+    composition_solid_a8_destination_atop,
+    composition_solid_a8_xor
+};
+
+static const composition_solid_function_t composition_solid_table_avx2[] = {
+    composition_solid_clear,
+    composition_solid_source_avx2,
+    composition_solid_destination,
+    composition_solid_source_over_avx2,
+    composition_solid_destination_over,
+    composition_solid_source_in,
+    composition_solid_destination_in,
+    composition_solid_source_out,
+    composition_solid_destination_out,
+    composition_solid_source_atop,
+    composition_solid_destination_atop,
+    composition_solid_xor
+};
+
+static const composition_function_t composition_table_avx2[] = {
+    composition_clear,
+    composition_source_avx2,
+    composition_destination,
+    composition_source_over_avx2,
+    composition_destination_over,
+    composition_source_in,
+    composition_destination_in,
+    composition_source_out,
+    composition_destination_out,
+    composition_source_atop,
+    composition_destination_atop,
+    composition_xor
+};
+
+static const blend_functions_t blend_functions_sse2 = {
+    PLUTOVG_CPU_LEVEL_SSE2,
+    memfill32_sse2,
+    memfill32_stream_sse2,
+    fetch_linear_gradient_sse2,
+    fetch_radial_gradient_sse2,
+    fetch_nearest,
+    fetch_bilinear_sse2,
+    downsample_sse2,
+    composition_solid_table_sse2,
+    composition_table_sse2,
+    composition_solid_a8_table_sse2
+};
+
+static const blend_functions_t blend_functions_avx2 = {
+    PLUTOVG_CPU_LEVEL_AVX2,
+    memfill32_avx2,
+    memfill32_stream_avx2,
+    fetch_linear_gradient_avx2,
+    fetch_radial_gradient_avx2,
+    fetch_nearest_avx2,
+    fetch_bilinear_avx2,
+    downsample_sse2,
+    composition_solid_table_avx2,
+    composition_table_avx2,
+    composition_solid_a8_table_sse2
+};
+
+static const blend_functions_t blend_functions_avx512 = {
+    PLUTOVG_CPU_LEVEL_AVX512,
+    memfill32_avx512,
+    memfill32_stream_avx512,
+    fetch_linear_gradient_avx2,
+    fetch_radial_gradient_avx2,
+    fetch_nearest_avx2,
+    fetch_bilinear_avx2,
+    downsample_sse2,
+    composition_solid_table_avx2,
+    composition_table_avx2,
+    composition_solid_a8_table_sse2
+};
+
+#endif
+
+static PLUTOVG_ATOMIC(const blend_functions_t*) active_blend_functions = NULL;
+
+static const blend_functions_t* blend_functions(void)
+{
+    const blend_functions_t* functions = plutovg_atomic_load(&active_blend_functions);
+    if(functions == NULL) {
+        plutovg_set_cpu_level(PLUTOVG_CPU_LEVEL_AUTO);
+        functions = plutovg_atomic_load(&active_blend_functions);
+    }
+
+    return functions;
+}
+
+/*
+ * Fills at least this large bypass the cache with streaming stores. The default
+ * is the size of the last-level cache reported by the CPU, since a fill that big
+ * evicts everything else anyway. It is capped here because a single thread only
+ * gets a share of a large server cache; this value is also used when no cache
+ * size is reported.
+ */
+#define MAX_NONTEMPORAL_THRESHOLD (32 * 1024 * 1024)
+
+static PLUTOVG_ATOMIC(size_t) default_nontemporal_threshold = SIZE_MAX;
+static PLUTOVG_ATOMIC(size_t) nontemporal_threshold = 0;
+
+static plutovg_cpu_level_t plutovg_cpu_level_from_env(void)
+{
+    const char* name = getenv("PLUTOVG_CPU_LEVEL");
+    if(name == NULL)
+        return PLUTOVG_CPU_LEVEL_AUTO;
+    static const struct {
+        const char* name;
+        plutovg_cpu_level_t level;
+    } levels[] = {
+        {"scalar", PLUTOVG_CPU_LEVEL_SCALAR},
+        {"sse2", PLUTOVG_CPU_LEVEL_SSE2},
+        {"avx2", PLUTOVG_CPU_LEVEL_AVX2},
+        {"avx512", PLUTOVG_CPU_LEVEL_AVX512}
+    };
+
+    for(int i = 0; i < (int)(sizeof(levels) / sizeof(levels[0])); ++i) {
+        if(strcmp(name, levels[i].name) == 0) {
+            return levels[i].level;
+        }
+    }
+
+    return PLUTOVG_CPU_LEVEL_AUTO;
+}
+
+void plutovg_set_cpu_level(plutovg_cpu_level_t level)
+{
+    plutovg_cpu_level_t supported = plutovg_cpu_detect();
+    if(level == PLUTOVG_CPU_LEVEL_AUTO)
+        level = plutovg_cpu_level_from_env();
+    if(level == PLUTOVG_CPU_LEVEL_AUTO || level > supported) {
+        level = supported;
+    }
+
+    const blend_functions_t* functions = &blend_functions_scalar;
+#if defined(PLUTOVG_HAS_X86_SIMD)
+    if(level == PLUTOVG_CPU_LEVEL_SSE2) {
+        functions = &blend_functions_sse2;
+    } else if(level == PLUTOVG_CPU_LEVEL_AVX2) {
+        functions = &blend_functions_avx2;
+    } else if(level == PLUTOVG_CPU_LEVEL_AVX512) {
+        functions = &blend_functions_avx512;
+    }
+#endif
+
+    size_t threshold = SIZE_MAX;
+    if(functions->memfill32_stream != memfill32) {
+        threshold = plutovg_cache_size();
+        if(threshold == 0 || threshold > MAX_NONTEMPORAL_THRESHOLD) {
+            threshold = MAX_NONTEMPORAL_THRESHOLD;
+        }
+    }
+
+    plutovg_atomic_store(&default_nontemporal_threshold, threshold);
+    plutovg_atomic_store(&active_blend_functions, functions);
+}
+
+plutovg_cpu_level_t plutovg_get_cpu_level(void)
+{
+    return blend_functions()->level;
+}
+
+void plutovg_set_nontemporal_threshold(size_t threshold)
+{
+    plutovg_atomic_store(&nontemporal_threshold, threshold);
+}
+
+size_t plutovg_get_nontemporal_threshold(void)
+{
+    size_t threshold = plutovg_atomic_load(&nontemporal_threshold);
+    if(threshold > 0)
+        return threshold;
+    blend_functions();
+    return plutovg_atomic_load(&default_nontemporal_threshold);
+}
+
+static plutovg_blend_backend_t blend_backend = PLUTOVG_BLEND_BACKEND_INTEGER;
+
+void plutovg_set_blend_backend(plutovg_blend_backend_t backend)
+{
+    blend_backend = backend;
+}
+
+plutovg_blend_backend_t plutovg_get_blend_backend(void)
+{
+    return blend_backend;
+}
+
+void plutovg_memfill32(unsigned int* dest, int length, unsigned int value)
+{
+    blend_functions()->memfill32(dest, length, value);
+}
+
+void plutovg_memfill32_stream(unsigned int* dest, int length, unsigned int value)
+{
+    blend_functions()->memfill32_stream(dest, length, value);
+}
+
+static void blend_solid(plutovg_surface_t* surface, plutovg_operator_t op, uint32_t solid, const plutovg_span_buffer_t* span_buffer)
+{
+    composition_solid_function_t func = blend_functions()->composition_solid_table[op];
+    int count = span_buffer->spans.size;
+    const plutovg_span_t* spans = span_buffer->spans.data;
+    while(count--) {
+        uint32_t* target = (uint32_t*)plutovg_surface_address(surface, spans->x, spans->y);
+        func(target, spans->len, solid, spans->coverage);
+        ++spans;
+    }
+}
+
+/*
+ * Solid spans shorter than this are composited inline; longer ones go through the
+ * dispatched (possibly vectorized) kernel where the call overhead is amortized.
+ * Gradients and textures are not split this way: an inline composite measured no
+ * faster than their kernels at any span length, since the fetch dominates.
+ * tests/bench_spans.c measures the crossover.
+ */
+#ifndef SHORT_SPAN_LENGTH
+#define SHORT_SPAN_LENGTH 8
+#endif
+
+/*
+ * Full-coverage spans at least this long are streamed when the rows touched by
+ * the fill reach the non-temporal threshold; shorter ones do not fill enough
+ * whole cache lines to benefit.
+ */
+#define NONTEMPORAL_SPAN_LENGTH 1024
+
+static bool blend_solid_should_stream(const plutovg_surface_t* surface, const plutovg_span_buffer_t* span_buffer)
+{
+    if(span_buffer->spans.size == 0)
+        return false;
+    const plutovg_span_t* first = span_buffer->spans.data;
+    const plutovg_span_t* last = first + span_buffer->spans.size - 1;
+    size_t rows = (size_t)abs(last->y - first->y) + 1;
+    return rows * (size_t)surface->stride >= plutovg_get_nontemporal_threshold();
+}
+
+static void blend_solid_source(plutovg_surface_t* surface, uint32_t solid, const plutovg_span_buffer_t* span_buffer)
+{
+    composition_solid_function_t func = blend_functions()->composition_solid_table[PLUTOVG_OPERATOR_SRC];
+    bool stream = blend_solid_should_stream(surface, span_buffer);
+    int count = span_buffer->spans.size;
+    const plutovg_span_t* spans = span_buffer->spans.data;
+    while(count--) {
+        uint32_t* target = (uint32_t*)plutovg_surface_address(surface, spans->x, spans->y);
+        int length = spans->len;
+        if(spans->coverage == 255) {
+            if(length < SHORT_SPAN_LENGTH) {
+                while(length--) {
+                    *target++ = solid;
+                }
+            } else if(stream && length >= NONTEMPORAL_SPAN_LENGTH) {
+                blend_functions()->memfill32_stream(target, length, solid);
+            } else {
+                func(target, length, solid, 255);
+            }
+        } else if(length < SHORT_SPAN_LENGTH) {
+            uint32_t color = BYTE_MUL(solid, spans->coverage);
+            uint32_t ialpha = 255 - spans->coverage;
+            while(length--) {
+                *target = color + BYTE_MUL(*target, ialpha);
+                ++target;
+            }
+        } else {
+            func(target, length, solid, spans->coverage);
+        }
+
+        ++spans;
+    }
+}
+
+static void blend_solid_source_over(plutovg_surface_t* surface, uint32_t solid, const plutovg_span_buffer_t* span_buffer)
+{
+    composition_solid_function_t func = blend_functions()->composition_solid_table[PLUTOVG_OPERATOR_SRC_OVER];
+    const uint32_t solid_ialpha = 255 - plutovg_alpha(solid);
+    int count = span_buffer->spans.size;
+    const plutovg_span_t* spans = span_buffer->spans.data;
+    while(count--) {
+        uint32_t* target = (uint32_t*)plutovg_surface_address(surface, spans->x, spans->y);
+        int length = spans->len;
+        if(length < SHORT_SPAN_LENGTH) {
+            uint32_t color = solid;
+            uint32_t ialpha = solid_ialpha;
+            if(spans->coverage != 255) {
+                color = BYTE_MUL(solid, spans->coverage);
+                ialpha = 255 - plutovg_alpha(color);
+            }
+
+            while(length--) {
+                *target = color + BYTE_MUL(*target, ialpha);
+                ++target;
+            }
+        } else {
+            func(target, length, solid, spans->coverage);
+        }
+
+        ++spans;
+    }
+}
+
+#define BUFFER_SIZE 1024
+
+/*
+ * Composites `length` pixels produced by evaluating `fetch` once per pixel, in order,
+ * directly into `dest` without staging them in a buffer. Only SRC and SRC_OVER are
+ * supported; each operator and coverage class gets its own loop.
+ */
+#define COMPOSITE_FUSED(op, dest, length, const_alpha, fetch) \
+    do { \
+        uint32_t* d = (dest); \
+        uint32_t* d_end = d + (length); \
+        if((op) == PLUTOVG_OPERATOR_SRC) { \
+            if((const_alpha) == 255) { \
+                while(d < d_end) { \
+                    *d++ = (fetch); \
+                } \
+            } else { \
+                uint32_t ialpha = 255 - (const_alpha); \
+                while(d < d_end) { \
+                    uint32_t s = (fetch); \
+                    *d = INTERPOLATE_PIXEL_255(s, (const_alpha), *d, ialpha); \
+                    ++d; \
+                } \
+            } \
+        } else { \
+            if((const_alpha) == 255) { \
+                while(d < d_end) { \
+                    uint32_t s = (fetch); \
+                    if(s >= 0xff000000) { \
+                        *d = s; \
+                    } else if(s != 0) { \
+                        *d = s + BYTE_MUL(*d, plutovg_alpha(~s)); \
+                    } \
+                    ++d; \
+                } \
+            } else { \
+                while(d < d_end) { \
+                    uint32_t s = BYTE_MUL((fetch), (const_alpha)); \
+                    *d = s + BYTE_MUL(*d, plutovg_alpha(~s)); \
+                    ++d; \
+                } \
+            } \
+        } \
+    } while(0)
+
+/*
+ * Fusing only pays off while compositing is scalar anyway; the vector composite
+ * kernels are faster on a staged buffer than a per-pixel scalar composite.
+ */
+static inline bool composite_can_fuse(plutovg_operator_t op)
+{
+    if(op != PLUTOVG_OPERATOR_SRC && op != PLUTOVG_OPERATOR_SRC_OVER)
+        return false;
+    return blend_functions()->composition_table[op] == composition_table_scalar[op];
+}
+static void blend_linear_gradient(plutovg_canvas_t* canvas, plutovg_surface_t* surface, plutovg_operator_t op, const gradient_data_t* gradient, const plutovg_span_buffer_t* span_buffer)
+{
+    composition_function_t func = blend_functions()->composition_table[op];
+    unsigned int buffer[BUFFER_SIZE];
+
+    linear_gradient_values_t v;
+    v.dx = gradient->values.linear.x2 - gradient->values.linear.x1;
+    v.dy = gradient->values.linear.y2 - gradient->values.linear.y1;
+    v.l = v.dx * v.dx + v.dy * v.dy;
+    v.off = 0.f;
+    if(v.l != 0.f) {
+        v.dx /= v.l;
+        v.dy /= v.l;
+        v.off = -v.dx * gradient->values.linear.x1 - v.dy * gradient->values.linear.y1;
+    }
+
+    int count = span_buffer->spans.size;
+    const plutovg_span_t* spans = span_buffer->spans.data;
+    if(linear_gradient_is_constant((v.dx * gradient->matrix.a + v.dy * gradient->matrix.b) * (COLOR_TABLE_SIZE - 1))) {
+        composition_solid_function_t solid_func = blend_functions()->composition_solid_table[op];
+        while(count--) {
+            float t, inc;
+            linear_gradient_position(&v, gradient, spans->y, spans->x, &t, &inc);
+            uint32_t* target = (uint32_t*)plutovg_surface_address(surface, spans->x, spans->y);
+            solid_func(target, spans->len, gradient_pixel_fixed(gradient, (int)(t * FIXPT_SIZE)), spans->coverage);
+            ++spans;
+        }
+
+        return;
+    }
+
+    if((v.dx == 0.f || gradient->matrix.c == 0.f) && (v.dy == 0.f || gradient->matrix.d == 0.f)) {
+        int x1 = INT_MAX;
+        int x2 = INT_MIN;
+        for(int i = 0; i < count; i++) {
+            x1 = plutovg_min(x1, spans[i].x);
+            x2 = plutovg_max(x2, spans[i].x + spans[i].len);
+        }
+
+        /*
+         * The color only varies along x, so fetch the row spanning every span once and
+         * composite each span straight out of it.
+         */
+        plutovg_array_clear(canvas->row_buffer);
+        plutovg_array_ensure(canvas->row_buffer, x2 - x1);
+        unsigned int* row = canvas->row_buffer.data;
+        for(int row_x = x1; row_x < x2; row_x += BUFFER_SIZE) {
+            int l = plutovg_min(x2 - row_x, BUFFER_SIZE);
+            blend_functions()->fetch_linear_gradient(row + row_x - x1, &v, gradient, spans->y, row_x, l);
+        }
+
+        for(int i = 0; i < count; i++) {
+            uint32_t* target = (uint32_t*)plutovg_surface_address(surface, spans[i].x, spans[i].y);
+            func(target, spans[i].len, row + spans[i].x - x1, spans[i].coverage);
+        }
+
+        return;
+    }
+
+    while(count--) {
+        int length = spans->len;
+        int x = spans->x;
+        while(length) {
             int l = plutovg_min(length, BUFFER_SIZE);
-            fetch_linear_gradient(buffer, &v, gradient, spans->y, x, l);
-            uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + x;
+            blend_functions()->fetch_linear_gradient(buffer, &v, gradient, spans->y, x, l);
+            uint32_t* target = (uint32_t*)plutovg_surface_address(surface, x, spans->y);
             func(target, l, buffer, spans->coverage);
             x += l;
             length -= l;
@@ -698,7 +2340,7 @@ static void blend_linear_gradient(plutovg_surface_t* surface, plutovg_operator_t
 
 static void blend_radial_gradient(plutovg_surface_t* surface, plutovg_operator_t op, const gradient_data_t* gradient, const plutovg_span_buffer_t* span_buffer)
 {
-    composition_function_t func = composition_table[op];
+    composition_function_t func = blend_functions()->composition_table[op];
     unsigned int buffer[BUFFER_SIZE];
 
     radial_gradient_values_t v;
@@ -716,8 +2358,8 @@ static void blend_radial_gradient(plutovg_surface_t* surface, plutovg_operator_t
         int x = spans->x;
         while(length) {
             int l = plutovg_min(length, BUFFER_SIZE);
-            fetch_radial_gradient(buffer, &v, gradient, spans->y, x, l);
-            uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + x;
+            blend_functions()->fetch_radial_gradient(buffer, &v, gradient, spans->y, x, l);
+            uint32_t* target = (uint32_t*)plutovg_surface_address(surface, x, spans->y);
             func(target, l, buffer, spans->coverage);
             x += l;
             length -= l;
@@ -729,7 +2371,7 @@ static void blend_radial_gradient(plutovg_surface_t* surface, plutovg_operator_t
 
 static void blend_untransformed_argb(plutovg_surface_t* surface, plutovg_operator_t op, const texture_data_t* texture, const plutovg_span_buffer_t* span_buffer)
 {
-    composition_function_t func = composition_table[op];
+    composition_function_t func = blend_functions()->composition_table[op];
 
     const int image_width = texture->width;
     const int image_height = texture->height;
@@ -755,8 +2397,8 @@ static void blend_untransformed_argb(plutovg_surface_t* surface, plutovg_operato
                 length = image_width - sx;
             if(length > 0) {
                 const int coverage = (spans->coverage * texture->const_alpha) >> 8;
-                const uint32_t* src = (const uint32_t*)(texture->data + sy * texture->stride) + sx;
-                uint32_t* dest = (uint32_t*)(surface->data + spans->y * surface->stride) + x;
+                const uint32_t* src = (const uint32_t*)(texture->data + (ptrdiff_t)sy * texture->stride) + sx;
+                uint32_t* dest = (uint32_t*)plutovg_surface_address(surface, x, spans->y);
                 func(dest, length, src, coverage);
             }
         }
@@ -766,21 +2408,147 @@ static void blend_untransformed_argb(plutovg_surface_t* surface, plutovg_operato
 }
 
 #define FIXED_SCALE (1 << 16)
+#define HALF_POINT (1 << 15)
+
+static inline int64_t floor_div(int64_t a, int64_t b)
+{
+    int64_t q = a / b;
+    if((a % b) && ((a < 0) != (b < 0)))
+        --q;
+    return q;
+}
+
+/*
+ * Narrows [*first, *last) to the steps i for which lo <= pos + i * step < hi. The
+ * positions are linear in i, so the steps that pass form a single run and no
+ * per-pixel bounds test is needed inside it.
+ */
+static void clip_texture_run(int pos, int step, int64_t lo, int64_t hi, int* first, int* last)
+{
+    int64_t begin, end;
+    if(step > 0) {
+        begin = -floor_div(pos - lo, step);
+        end = -floor_div(pos - hi, step);
+    } else if(step < 0) {
+        begin = floor_div(pos - hi, -step) + 1;
+        end = floor_div(pos - lo, -step) + 1;
+    } else if(pos >= lo && pos < hi) {
+        return;
+    } else {
+        *last = *first;
+        return;
+    }
+
+    if(begin > *first)
+        *first = (int)plutovg_min(begin, *last);
+    if(end < *last) {
+        *last = (int)plutovg_max(end, *first);
+    }
+}
+
+/* Number of steps, at least one, before pos leaves [0, size) when it starts inside. */
+static inline int texture_run_length(int pos, int step, int size, int length)
+{
+    int64_t count;
+    if(step > 0) {
+        count = (size - 1 - pos) / step + 1;
+    } else if(step < 0) {
+        count = pos / -step + 1;
+    } else {
+        return length;
+    }
+
+    return (int)plutovg_min(count, length);
+}
+
+static inline int texture_wrap(int pos, int size)
+{
+    pos %= size;
+    if(pos < 0)
+        pos += size;
+    return pos;
+}
+
+/* Composites a run of fully transparent source pixels. */
+static void composite_transparent(plutovg_operator_t op, uint32_t* target, int length, int const_alpha, uint32_t* buffer)
+{
+    if(op == PLUTOVG_OPERATOR_SRC_OVER)
+        return;
+    composition_function_t func = blend_functions()->composition_table[op];
+    memset(buffer, 0, plutovg_min(length, BUFFER_SIZE) * sizeof(uint32_t));
+    while(length) {
+        int l = plutovg_min(length, BUFFER_SIZE);
+        func(target, l, buffer, const_alpha);
+        target += l;
+        length -= l;
+    }
+}
+
+static void composite_nearest(plutovg_operator_t op, const texture_data_t* texture, uint32_t* target, int x, int y, int fdx, int fdy, int length, int const_alpha, uint32_t* buffer)
+{
+    if(op == PLUTOVG_OPERATOR_SRC && const_alpha == 255) {
+        blend_functions()->fetch_nearest(target, texture, x, y, fdx, fdy, length);
+        return;
+    }
+
+    if(composite_can_fuse(op)) {
+        COMPOSITE_FUSED(op, target, length, const_alpha, fetch_nearest_pixel(texture, &x, &y, fdx, fdy));
+        return;
+    }
+
+    composition_function_t func = blend_functions()->composition_table[op];
+    while(length) {
+        int l = plutovg_min(length, BUFFER_SIZE);
+        blend_functions()->fetch_nearest(buffer, texture, x, y, fdx, fdy, l);
+        func(target, l, buffer, const_alpha);
+        x += l * fdx;
+        y += l * fdy;
+        target += l;
+        length -= l;
+    }
+}
+
+static void composite_bilinear(plutovg_operator_t op, const texture_data_t* texture, uint32_t* target, int fx, int fy, int fdx, int fdy, int length, int const_alpha, uint32_t* buffer)
+{
+    if(op == PLUTOVG_OPERATOR_SRC && const_alpha == 255) {
+        blend_functions()->fetch_bilinear(target, texture, fx, fy, fdx, fdy, length);
+        return;
+    }
+
+    if(composite_can_fuse(op)) {
+        COMPOSITE_FUSED(op, target, length, const_alpha, fetch_bilinear_pixel(texture, &fx, &fy, fdx, fdy));
+        return;
+    }
+
+    composition_function_t func = blend_functions()->composition_table[op];
+    while(length) {
+        int l = plutovg_min(length, BUFFER_SIZE);
+        blend_functions()->fetch_bilinear(buffer, texture, fx, fy, fdx, fdy, l);
+        func(target, l, buffer, const_alpha);
+        fx += l * fdx;
+        fy += l * fdy;
+        target += l;
+        length -= l;
+    }
+}
+
 static void blend_transformed_argb(plutovg_surface_t* surface, plutovg_operator_t op, const texture_data_t* texture, const plutovg_span_buffer_t* span_buffer)
 {
-    composition_function_t func = composition_table[op];
     uint32_t buffer[BUFFER_SIZE];
-
-    int image_width = texture->width;
-    int image_height = texture->height;
+    plutovg_operator_t opaque_op = op;
+    if(op == PLUTOVG_OPERATOR_SRC_OVER && texture->opaque)
+        opaque_op = PLUTOVG_OPERATOR_SRC;
 
     int fdx = (int)(texture->matrix.a * FIXED_SCALE);
     int fdy = (int)(texture->matrix.b * FIXED_SCALE);
 
+    const int64_t width = (int64_t)texture->width * FIXED_SCALE;
+    const int64_t height = (int64_t)texture->height * FIXED_SCALE;
+
     int count = span_buffer->spans.size;
     const plutovg_span_t* spans = span_buffer->spans.data;
     while(count--) {
-        uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + spans->x;
+        uint32_t* target = (uint32_t*)plutovg_surface_address(surface, spans->x, spans->y);
 
         const float cx = spans->x + 0.5f;
         const float cy = spans->y + 0.5f;
@@ -788,38 +2556,122 @@ static void blend_transformed_argb(plutovg_surface_t* surface, plutovg_operator_
         int x = (int)((texture->matrix.c * cy + texture->matrix.a * cx + texture->matrix.e) * FIXED_SCALE);
         int y = (int)((texture->matrix.d * cy + texture->matrix.b * cx + texture->matrix.f) * FIXED_SCALE);
 
-        int length = spans->len;
+        const int length = spans->len;
         const int coverage = (spans->coverage * texture->const_alpha) >> 8;
-        while(length) {
-            int l = plutovg_min(length, BUFFER_SIZE);
-            const uint32_t* end = buffer + l;
-            uint32_t* b = buffer;
-            while(b < end) {
-                int px = x >> 16;
-                int py = y >> 16;
-                if((px < 0) || (px >= image_width) || (py < 0) || (py >= image_height)) {
-                    *b = 0x00000000;
-                } else {
-                    *b = ((const uint32_t*)(texture->data + py * texture->stride))[px];
-                }
 
-                x += fdx;
-                y += fdy;
-                ++b;
+        int first = 0;
+        int last = length;
+        clip_texture_run(x, fdx, 0, width, &first, &last);
+        clip_texture_run(y, fdy, 0, height, &first, &last);
+
+        composite_transparent(op, target, first, coverage, buffer);
+        composite_nearest(opaque_op, texture, target + first, x + first * fdx, y + first * fdy, fdx, fdy, last - first, coverage, buffer);
+        composite_transparent(op, target + last, length - last, coverage, buffer);
+        ++spans;
+    }
+}
+
+/* Bilinear sample of a plain texture; texels outside the texture are transparent. */
+static inline uint32_t fetch_bilinear_clamped_pixel(const texture_data_t* texture, int fx, int fy)
+{
+    int x1 = fx >> 16;
+    int y1 = fy >> 16;
+
+    uint32_t texels[4] = {0, 0, 0, 0};
+    for(int j = 0; j < 2; j++) {
+        int py = y1 + j;
+        if(py < 0 || py >= texture->height)
+            continue;
+        const uint32_t* row = (const uint32_t*)(texture->data + (ptrdiff_t)py * texture->stride);
+        for(int i = 0; i < 2; i++) {
+            int px = x1 + i;
+            if(px >= 0 && px < texture->width) {
+                texels[j * 2 + i] = row[px];
             }
+        }
+    }
 
-            func(target, l, buffer, coverage);
-            target += l;
-            length -= l;
+    int distx = (fx & 0x0000ffff) >> 8;
+    int disty = (fy & 0x0000ffff) >> 8;
+    return interpolate_4_pixels(texels[0], texels[1], texels[2], texels[3], distx, disty);
+}
+
+static void composite_bilinear_clamped(plutovg_operator_t op, const texture_data_t* texture, uint32_t* target, int fx, int fy, int fdx, int fdy, int length, int const_alpha, uint32_t* buffer)
+{
+    composition_function_t func = blend_functions()->composition_table[op];
+    while(length) {
+        int l = plutovg_min(length, BUFFER_SIZE);
+        for(int i = 0; i < l; i++) {
+            buffer[i] = fetch_bilinear_clamped_pixel(texture, fx, fy);
+            fx += fdx;
+            fy += fdy;
+        }
+
+        func(target, l, buffer, const_alpha);
+        target += l;
+        length -= l;
+    }
+}
+
+static void blend_transformed_bilinear_argb(plutovg_surface_t* surface, plutovg_operator_t op, const texture_data_t* texture, const plutovg_span_buffer_t* span_buffer)
+{
+    uint32_t buffer[BUFFER_SIZE];
+    plutovg_operator_t opaque_op = op;
+    if(op == PLUTOVG_OPERATOR_SRC_OVER && texture->opaque)
+        opaque_op = PLUTOVG_OPERATOR_SRC;
+
+    int fdx = (int)(texture->matrix.a * FIXED_SCALE);
+    int fdy = (int)(texture->matrix.b * FIXED_SCALE);
+
+    const int64_t width = (int64_t)texture->width * FIXED_SCALE;
+    const int64_t height = (int64_t)texture->height * FIXED_SCALE;
+
+    int count = span_buffer->spans.size;
+    const plutovg_span_t* spans = span_buffer->spans.data;
+    while(count--) {
+        uint32_t* target = (uint32_t*)plutovg_surface_address(surface, spans->x, spans->y);
+
+        const float cx = spans->x + 0.5f;
+        const float cy = spans->y + 0.5f;
+
+        int fx = (int)((texture->matrix.c * cy + texture->matrix.a * cx + texture->matrix.e) * FIXED_SCALE);
+        int fy = (int)((texture->matrix.d * cy + texture->matrix.b * cx + texture->matrix.f) * FIXED_SCALE);
+
+        fx -= HALF_POINT;
+        fy -= HALF_POINT;
+
+        const int length = spans->len;
+        const int coverage = (spans->coverage * texture->const_alpha) >> 8;
+
+        /*
+         * Pixels in [first, last) touch at least one texel, and those in [inner_first, inner_last)
+         * have all four texels inside the texture and take the vector path.
+         */
+        int first = 0;
+        int last = length;
+        clip_texture_run(fx, fdx, -FIXED_SCALE, width, &first, &last);
+        clip_texture_run(fy, fdy, -FIXED_SCALE, height, &first, &last);
+
+        int inner_first = first;
+        int inner_last = last;
+        clip_texture_run(fx, fdx, 0, width - FIXED_SCALE, &inner_first, &inner_last);
+        clip_texture_run(fy, fdy, 0, height - FIXED_SCALE, &inner_first, &inner_last);
+        if(inner_first == inner_last) {
+            inner_first = inner_last = last;
         }
 
+        composite_transparent(op, target, first, coverage, buffer);
+        composite_bilinear_clamped(op, texture, target + first, fx + first * fdx, fy + first * fdy, fdx, fdy, inner_first - first, coverage, buffer);
+        composite_bilinear(opaque_op, texture, target + inner_first, fx + inner_first * fdx, fy + inner_first * fdy, fdx, fdy, inner_last - inner_first, coverage, buffer);
+        composite_bilinear_clamped(op, texture, target + inner_last, fx + inner_last * fdx, fy + inner_last * fdy, fdx, fdy, last - inner_last, coverage, buffer);
+        composite_transparent(op, target + last, length - last, coverage, buffer);
         ++spans;
     }
 }
 
 static void blend_untransformed_tiled_argb(plutovg_surface_t* surface, plutovg_operator_t op, const texture_data_t* texture, const plutovg_span_buffer_t* span_buffer)
 {
-    composition_function_t func = composition_table[op];
+    composition_function_t func = blend_functions()->composition_table[op];
 
     int image_width = texture->width;
     int image_height = texture->height;
@@ -848,41 +2700,54 @@ static void blend_untransformed_tiled_argb(plutovg_surface_t* surface, plutovg_o
 
         const int coverage = (spans->coverage * texture->const_alpha) >> 8;
         while(length) {
-            int l = plutovg_min(image_width - sx, length);
+            int l = plutovg_min(texture->row_width - sx, length);
             if(BUFFER_SIZE < l)
                 l = BUFFER_SIZE;
-            const uint32_t* src = (const uint32_t*)(texture->data + sy * texture->stride) + sx;
-            uint32_t* dest = (uint32_t*)(surface->data + spans->y * surface->stride) + x;
+            const uint32_t* src = (const uint32_t*)(texture->data + (ptrdiff_t)sy * texture->stride) + sx;
+            uint32_t* dest = (uint32_t*)plutovg_surface_address(surface, x, spans->y);
             func(dest, l, src, coverage);
             x += l;
-            sx += l;
+            sx = (sx + l) % image_width;
             length -= l;
-            if(sx >= image_width) {
-                sx = 0;
-            }
         }
 
         ++spans;
     }
 }
 
+/*
+ * Fetches a tiled texture by splitting the span into runs that stay inside one tile,
+ * so the wrap is computed once per run instead of once per pixel.
+ */
+static void fetch_transformed_tiled(uint32_t* buffer, const texture_data_t* texture, int x, int y, int fdx, int fdy, int length)
+{
+    const int width = texture->width * FIXED_SCALE;
+    const int height = texture->height * FIXED_SCALE;
+    x = texture_wrap(x, width);
+    y = texture_wrap(y, height);
+    while(length) {
+        int l = texture_run_length(x, fdx, width, length);
+        l = texture_run_length(y, fdy, height, l);
+        blend_functions()->fetch_nearest(buffer, texture, x, y, fdx, fdy, l);
+        x = texture_wrap(x + l * fdx, width);
+        y = texture_wrap(y + l * fdy, height);
+        buffer += l;
+        length -= l;
+    }
+}
+
 static void blend_transformed_tiled_argb(plutovg_surface_t* surface, plutovg_operator_t op, const texture_data_t* texture, const plutovg_span_buffer_t* span_buffer)
 {
-    composition_function_t func = composition_table[op];
+    composition_function_t func = blend_functions()->composition_table[op];
     uint32_t buffer[BUFFER_SIZE];
 
-    int image_width = texture->width;
-    int image_height = texture->height;
-    const int scanline_offset = texture->stride / 4;
-
     int fdx = (int)(texture->matrix.a * FIXED_SCALE);
     int fdy = (int)(texture->matrix.b * FIXED_SCALE);
 
     int count = span_buffer->spans.size;
     const plutovg_span_t* spans = span_buffer->spans.data;
     while(count--) {
-        uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + spans->x;
-        const uint32_t* image_bits = (const uint32_t*)texture->data;
+        uint32_t* target = (uint32_t*)plutovg_surface_address(surface, spans->x, spans->y);
 
         const float cx = spans->x + 0.5f;
         const float cy = spans->y + 0.5f;
@@ -892,29 +2757,18 @@ static void blend_transformed_tiled_argb(plutovg_surface_t* surface, plutovg_ope
 
         const int coverage = (spans->coverage * texture->const_alpha) >> 8;
         int length = spans->len;
+        if(op == PLUTOVG_OPERATOR_SRC && coverage == 255) {
+            fetch_transformed_tiled(target, texture, x, y, fdx, fdy, length);
+            ++spans;
+            continue;
+        }
+
         while(length) {
             int l = plutovg_min(length, BUFFER_SIZE);
-            const uint32_t* end = buffer + l;
-            uint32_t* b = buffer;
-            while(b < end) {
-                int px = x >> 16;
-                int py = y >> 16;
-                px %= image_width;
-                py %= image_height;
-                if(px < 0) px += image_width;
-                if(py < 0) py += image_height;
-                int y_offset = py * scanline_offset;
-
-                assert(px >= 0 && px < image_width);
-                assert(py >= 0 && py < image_height);
-
-                *b = image_bits[y_offset + px];
-                x += fdx;
-                y += fdy;
-                ++b;
-            }
-
+            fetch_transformed_tiled(buffer, texture, x, y, fdx, fdy, l);
             func(target, l, buffer, coverage);
+            x += l * fdx;
+            y += l * fdy;
             target += l;
             length -= l;
         }
@@ -923,31 +2777,68 @@ static void blend_transformed_tiled_argb(plutovg_surface_t* surface, plutovg_ope
     }
 }
 
-static inline uint32_t interpolate_4_pixels(uint32_t tl, uint32_t tr, uint32_t bl, uint32_t br, uint32_t distx, uint32_t disty)
+static inline uint32_t fetch_transformed_bilinear_tiled_pixel(const texture_data_t* texture, int* fx, int* fy, int fdx, int fdy)
 {
-    uint32_t idistx = 256 - distx;
-    uint32_t idisty = 256 - disty;
-    uint32_t xtop = INTERPOLATE_PIXEL_256(tl, idistx, tr, distx);
-    uint32_t xbot = INTERPOLATE_PIXEL_256(bl, idistx, br, distx);
-    return INTERPOLATE_PIXEL_256(xtop, idisty, xbot, disty);
+    int x1 = (*fx >> 16) % texture->width;
+    int y1 = (*fy >> 16) % texture->height;
+
+    if(x1 < 0) x1 += texture->width;
+    if(y1 < 0) y1 += texture->height;
+
+    int x2 = (x1 + 1) % texture->width;
+    int y2 = (y1 + 1) % texture->height;
+
+    const uint32_t* s1 = (const uint32_t*)(texture->data + (ptrdiff_t)y1 * texture->stride);
+    const uint32_t* s2 = (const uint32_t*)(texture->data + (ptrdiff_t)y2 * texture->stride);
+
+    uint32_t tl = s1[x1];
+    uint32_t tr = s1[x2];
+    uint32_t bl = s2[x1];
+    uint32_t br = s2[x2];
+
+    int distx = (*fx & 0x0000ffff) >> 8;
+    int disty = (*fy & 0x0000ffff) >> 8;
+    *fx += fdx;
+    *fy += fdy;
+    return interpolate_4_pixels(tl, tr, bl, br, distx, disty);
+}
+
+static void fetch_transformed_bilinear_tiled(uint32_t* buffer, const texture_data_t* texture, int fx, int fy, int fdx, int fdy, int length)
+{
+    const int width = texture->width * FIXED_SCALE;
+    const int height = texture->height * FIXED_SCALE;
+    fx = texture_wrap(fx, width);
+    fy = texture_wrap(fy, height);
+    while(length) {
+        int l = 1;
+        if(fx < width - FIXED_SCALE && fy < height - FIXED_SCALE) {
+            l = texture_run_length(fx, fdx, width - FIXED_SCALE, length);
+            l = texture_run_length(fy, fdy, height - FIXED_SCALE, l);
+            blend_functions()->fetch_bilinear(buffer, texture, fx, fy, fdx, fdy, l);
+        } else {
+            int x = fx, y = fy;
+            buffer[0] = fetch_transformed_bilinear_tiled_pixel(texture, &x, &y, fdx, fdy);
+        }
+
+        fx = texture_wrap(fx + l * fdx, width);
+        fy = texture_wrap(fy + l * fdy, height);
+        buffer += l;
+        length -= l;
+    }
 }
 
-#define HALF_POINT (1 << 15)
 static void blend_transformed_bilinear_tiled_argb(plutovg_surface_t* surface, plutovg_operator_t op, const texture_data_t* texture, const plutovg_span_buffer_t* span_buffer)
 {
-    composition_function_t func = composition_table[op];
+    composition_function_t func = blend_functions()->composition_table[op];
     uint32_t buffer[BUFFER_SIZE];
 
-    int image_width = texture->width;
-    int image_height = texture->height;
-
     int fdx = (int)(texture->matrix.a * FIXED_SCALE);
     int fdy = (int)(texture->matrix.b * FIXED_SCALE);
 
     int count = span_buffer->spans.size;
     const plutovg_span_t* spans = span_buffer->spans.data;
     while(count--) {
-        uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + spans->x;
+        uint32_t* target = (uint32_t*)plutovg_surface_address(surface, spans->x, spans->y);
 
         const float cx = spans->x + 0.5f;
         const float cy = spans->y + 0.5f;
@@ -960,38 +2851,18 @@ static void blend_transformed_bilinear_tiled_argb(plutovg_surface_t* surface, pl
 
         const int coverage = (spans->coverage * texture->const_alpha) >> 8;
         int length = spans->len;
+        if(op == PLUTOVG_OPERATOR_SRC && coverage == 255) {
+            fetch_transformed_bilinear_tiled(target, texture, fx, fy, fdx, fdy, length);
+            ++spans;
+            continue;
+        }
+
         while(length) {
             int l = plutovg_min(length, BUFFER_SIZE);
-            const uint32_t* end = buffer + l;
-            uint32_t* b = buffer;
-            while (b < end) {
-                int x1 = (fx >> 16) % image_width;
-                int y1 = (fy >> 16) % image_height;
-
-                if(x1 < 0) x1 += image_width;
-                if(y1 < 0) y1 += image_height;
-
-                int x2 = (x1 + 1) % image_width;
-                int y2 = (y1 + 1) % image_height;
-
-                const uint32_t* s1 = (const uint32_t*)(texture->data + y1 * texture->stride);
-                const uint32_t* s2 = (const uint32_t*)(texture->data + y2 * texture->stride);
-
-                uint32_t tl = s1[x1];
-                uint32_t tr = s1[x2];
-                uint32_t bl = s2[x1];
-                uint32_t br = s2[x2];
-
-                int distx = (fx & 0x0000ffff) >> 8;
-                int disty = (fy & 0x0000ffff) >> 8;
-                *b = interpolate_4_pixels(tl, tr, bl, br, distx, disty);
-
-                fx += fdx;
-                fy += fdy;
-                ++b;
-            }
-
+            fetch_transformed_bilinear_tiled(buffer, texture, fx, fy, fdx, fdy, l);
             func(target, l, buffer, coverage);
+            fx += l * fdx;
+            fy += l * fdy;
             target += l;
             length -= l;
         }
@@ -1000,47 +2871,57 @@ static void blend_transformed_bilinear_tiled_argb(plutovg_surface_t* surface, pl
     }
 }
 
-static void plutovg_blend_color(plutovg_canvas_t* canvas, const plutovg_color_t* color, const plutovg_span_buffer_t* span_buffer)
+static void plutovg_blend_color(plutovg_canvas_t* canvas, plutovg_operator_t op, const plutovg_color_t* color, const plutovg_span_buffer_t* span_buffer)
 {
     plutovg_state_t* state = canvas->state;
     uint32_t solid = premultiply_color_with_opacity(color, state->opacity);
     uint32_t alpha = plutovg_alpha(solid);
+    if(op == PLUTOVG_OPERATOR_SRC_OVER) {
+        if(alpha == 0)
+            return;
+        if(alpha == 255) {
+            op = PLUTOVG_OPERATOR_SRC;
+        }
+    }
 
-    if(alpha == 255 && state->op == PLUTOVG_OPERATOR_SRC_OVER) {
-        blend_solid(canvas->surface, PLUTOVG_OPERATOR_SRC, solid, span_buffer);
-    } else {
-        blend_solid(canvas->surface, state->op, solid, span_buffer);
+    switch(op) {
+    case PLUTOVG_OPERATOR_DST:
+        break;
+    case PLUTOVG_OPERATOR_SRC:
+        blend_solid_source(canvas->surface, solid, span_buffer);
+        break;
+    case PLUTOVG_OPERATOR_SRC_OVER:
+        blend_solid_source_over(canvas->surface, solid, span_buffer);
+        break;
+    default:
+        blend_solid(canvas->surface, op, solid, span_buffer);
+        break;
     }
 }
 
-static void plutovg_blend_gradient(plutovg_canvas_t* canvas, const plutovg_gradient_paint_t* gradient, const plutovg_span_buffer_t* span_buffer)
+static plutovg_color_table_t* plutovg_color_table_create(const plutovg_gradient_paint_t* gradient, float opacity)
 {
-    if(gradient->nstops == 0)
-        return;
-    plutovg_state_t* state = canvas->state;
-    gradient_data_t data;
-    data.spread = gradient->spread;
-    data.matrix = gradient->matrix;
-    plutovg_matrix_multiply(&data.matrix, &data.matrix, &state->matrix);
-    if(!plutovg_matrix_invert(&data.matrix, &data.matrix))
-        return;
+    plutovg_color_table_t* colortable = plutovg_malloc(sizeof(plutovg_color_table_t));
+    plutovg_init_reference(colortable);
+    colortable->opacity = opacity;
+
     int i, pos = 0, nstops = gradient->nstops;
     const plutovg_gradient_stop_t *curr, *next, *start, *last;
     uint32_t curr_color, next_color, last_color;
     uint32_t dist, idist;
     float delta, t, incr, fpos;
-    float opacity = state->opacity;
+    uint32_t* data = colortable->data;
 
     start = gradient->stops;
     curr = start;
     curr_color = premultiply_color_with_opacity(&curr->color, opacity);
 
-    data.colortable[pos++] = curr_color;
+    data[pos++] = curr_color;
     incr = 1.0f / COLOR_TABLE_SIZE;
     fpos = 1.5f * incr;
 
     while(fpos <= curr->offset) {
-        data.colortable[pos] = data.colortable[pos - 1];
+        data[pos] = data[pos - 1];
         ++pos;
         fpos += incr;
     }
@@ -1056,7 +2937,7 @@ static void plutovg_blend_gradient(plutovg_canvas_t* canvas, const plutovg_gradi
             t = (fpos - curr->offset) * delta;
             dist = (uint32_t)(255 * t);
             idist = 255 - dist;
-            data.colortable[pos] = INTERPOLATE_PIXEL_255(curr_color, idist, next_color, dist);
+            data[pos] = INTERPOLATE_PIXEL_255(curr_color, idist, next_color, dist);
             ++pos;
             fpos += incr;
         }
@@ -1067,15 +2948,53 @@ static void plutovg_blend_gradient(plutovg_canvas_t* canvas, const plutovg_gradi
     last = start + nstops - 1;
     last_color = premultiply_color_with_opacity(&last->color, opacity);
     for(; pos < COLOR_TABLE_SIZE; ++pos) {
-        data.colortable[pos] = last_color;
+        data[pos] = last_color;
+    }
+
+    return colortable;
+}
+
+void plutovg_color_table_destroy(plutovg_color_table_t* colortable)
+{
+    if(plutovg_destroy_reference(colortable)) {
+        plutovg_free(colortable);
+    }
+}
+
+static plutovg_color_table_t* plutovg_gradient_get_color_table(plutovg_gradient_paint_t* gradient, float opacity)
+{
+    plutovg_mutex_lock(&gradient->mutex);
+    plutovg_color_table_t* colortable = gradient->colortable;
+    if(colortable == NULL || colortable->opacity != opacity) {
+        plutovg_color_table_destroy(colortable);
+        colortable = plutovg_color_table_create(gradient, opacity);
+        gradient->colortable = colortable;
     }
 
+    plutovg_increment_reference(colortable);
+    plutovg_mutex_unlock(&gradient->mutex);
+    return colortable;
+}
+
+static void plutovg_blend_gradient(plutovg_canvas_t* canvas, plutovg_surface_t* surface, plutovg_operator_t op, plutovg_gradient_paint_t* gradient, const plutovg_span_buffer_t* span_buffer)
+{
+    if(gradient->nstops == 0)
+        return;
+    plutovg_state_t* state = canvas->state;
+    gradient_data_t data;
+    data.spread = gradient->spread;
+    data.matrix = gradient->matrix;
+    plutovg_matrix_multiply(&data.matrix, &data.matrix, &state->matrix);
+    if(!plutovg_matrix_invert(&data.matrix, &data.matrix))
+        return;
+    plutovg_color_table_t* colortable = plutovg_gradient_get_color_table(gradient, state->opacity);
+    data.colortable = colortable->data;
     if(gradient->type == PLUTOVG_GRADIENT_TYPE_LINEAR) {
         data.values.linear.x1 = gradient->values[0];
         data.values.linear.y1 = gradient->values[1];
         data.values.linear.x2 = gradient->values[2];
         data.values.linear.y2 = gradient->values[3];
-        blend_linear_gradient(canvas->surface, state->op, &data, span_buffer);
+        blend_linear_gradient(canvas, surface, op, &data, span_buffer);
     } else {
         data.values.radial.cx = gradient->values[0];
         data.values.radial.cy = gradient->values[1];
@@ -1083,62 +3002,707 @@ static void plutovg_blend_gradient(plutovg_canvas_t* canvas, const plutovg_gradi
         data.values.radial.fx = gradient->values[3];
         data.values.radial.fy = gradient->values[4];
         data.values.radial.fr = gradient->values[5];
-        blend_radial_gradient(canvas->surface, state->op, &data, span_buffer);
+        blend_radial_gradient(surface, op, &data, span_buffer);
+    }
+
+    plutovg_color_table_destroy(colortable);
+}
+
+/*
+ * Besides the box-filtered levels, the mip chain of a non-ARGB surface holds an ARGB
+ * expansion of its pixels in `base`, which the texture samplers read instead.
+ */
+#define MIPMAP_MAX_LEVELS 16
+struct plutovg_mipmap {
+    plutovg_ref_count_t ref_count;
+    unsigned int generation;
+    int count;
+    int built;
+    plutovg_texture_level_t base;
+    plutovg_texture_level_t levels[MIPMAP_MAX_LEVELS];
+};
+
+static void plutovg_mipmap_expand(plutovg_texture_level_t* base, const plutovg_surface_t* surface)
+{
+    for(int y = 0; y < surface->height; y++) {
+        const uint8_t* src = surface->data + (ptrdiff_t)y * surface->stride;
+        uint32_t* dest = (uint32_t*)(base->data + (ptrdiff_t)y * base->stride);
+        switch(surface->format) {
+        case PLUTOVG_FORMAT_A8:
+            for(int x = 0; x < surface->width; x++)
+                dest[x] = (uint32_t)src[x] << 24;
+            break;
+        case PLUTOVG_FORMAT_XRGB32:
+            for(int x = 0; x < surface->width; x++)
+                dest[x] = ((const uint32_t*)(src))[x] | 0xff000000;
+            break;
+        case PLUTOVG_FORMAT_RGB565:
+            for(int x = 0; x < surface->width; x++)
+                dest[x] = plutovg_rgb565_to_argb(((const uint16_t*)(src))[x]);
+            break;
+        default:
+            assert(false);
+        }
+    }
+}
+
+static plutovg_mipmap_t* plutovg_mipmap_create(const plutovg_surface_t* surface, bool levels)
+{
+    int width = surface->width;
+    int height = surface->height;
+    int count = 0;
+    size_t size = 0;
+    while(levels && (width > 1 || height > 1) && count < MIPMAP_MAX_LEVELS) {
+        width = plutovg_max(1, width >> 1);
+        height = plutovg_max(1, height >> 1);
+        size += (size_t)width * height * 4;
+        ++count;
+    }
+
+    bool expand = surface->format != PLUTOVG_FORMAT_ARGB32;
+    if(count == 0 && !expand)
+        return NULL;
+    size_t base_size = expand ? (size_t)surface->width * surface->height * 4 : 0;
+    plutovg_mipmap_t* mipmap = plutovg_malloc(sizeof(plutovg_mipmap_t) + base_size + size);
+    if(mipmap == NULL)
+        return NULL;
+    plutovg_init_reference(mipmap);
+    mipmap->generation = surface->generation;
+    mipmap->count = count;
+    mipmap->built = 0;
+
+    unsigned char* data = (unsigned char*)(mipmap + 1);
+    mipmap->base.data = surface->data;
+    mipmap->base.width = surface->width;
+    mipmap->base.height = surface->height;
+    mipmap->base.stride = surface->stride;
+    mipmap->base.opaque = plutovg_surface_is_opaque(surface);
+    if(expand) {
+        mipmap->base.data = data;
+        mipmap->base.stride = surface->width * 4;
+        plutovg_mipmap_expand(&mipmap->base, surface);
+        data += base_size;
+    }
+
+    width = surface->width;
+    height = surface->height;
+    for(int i = 0; i < count; i++) {
+        plutovg_texture_level_t* level = &mipmap->levels[i];
+        width = plutovg_max(1, width >> 1);
+        height = plutovg_max(1, height >> 1);
+        level->data = data;
+        level->width = width;
+        level->height = height;
+        level->stride = width * 4;
+        data += (size_t)width * height * 4;
+    }
+
+    return mipmap;
+}
+
+void plutovg_mipmap_destroy(plutovg_mipmap_t* mipmap)
+{
+    if(plutovg_destroy_reference(mipmap)) {
+        plutovg_free(mipmap);
+    }
+}
+
+/* Box-filters levels until `count` of them hold valid pixels; each level halves the one above. */
+static void plutovg_mipmap_build(plutovg_mipmap_t* mipmap, int count)
+{
+    while(mipmap->built < count) {
+        plutovg_texture_level_t source = mipmap->base;
+        if(mipmap->built > 0)
+            source = mipmap->levels[mipmap->built - 1];
+        const plutovg_texture_level_t* level = &mipmap->levels[mipmap->built];
+        for(int y = 0; y < level->height; y++) {
+            const uint32_t* row0 = (const uint32_t*)(source.data + (ptrdiff_t)2 * y * source.stride);
+            const uint32_t* row1 = (const uint32_t*)(source.data + (ptrdiff_t)plutovg_min(2 * y + 1, source.height - 1) * source.stride);
+            uint32_t* dest = (uint32_t*)(level->data + (ptrdiff_t)y * level->stride);
+            if(source.width == 1) {
+                uint32_t column0[2] = {row0[0], row0[0]};
+                uint32_t column1[2] = {row1[0], row1[0]};
+                downsample(dest, column0, column1, 1);
+            } else {
+                blend_functions()->downsample(dest, row0, row1, level->width);
+            }
+        }
+
+        mipmap->built++;
+    }
+}
+
+static int plutovg_surface_level_index(const plutovg_surface_t* surface, plutovg_texture_type_t type, const plutovg_matrix_t* matrix)
+{
+    if(!surface->mipmap_enabled)
+        return 0;
+    float footprint = sqrtf(fabsf(matrix->a * matrix->d - matrix->b * matrix->c));
+    if(footprint < 2.f)
+        return 0;
+    int index = plutovg_min((int)log2f(footprint), MIPMAP_MAX_LEVELS);
+    if(type == PLUTOVG_TEXTURE_TYPE_TILED) {
+        while(index > 0 && ((surface->width | surface->height) & ((1 << index) - 1))) {
+            --index;
+        }
+    }
+
+    return index;
+}
+
+plutovg_mipmap_t* plutovg_surface_select_level(plutovg_surface_t* surface, plutovg_texture_type_t type, plutovg_matrix_t* matrix, plutovg_texture_level_t* level)
+{
+    level->data = surface->data;
+    level->width = surface->width;
+    level->height = surface->height;
+    level->stride = surface->stride;
+    level->opaque = plutovg_surface_is_opaque(surface);
+    int index = plutovg_surface_level_index(surface, type, matrix);
+    if(index == 0 && surface->format == PLUTOVG_FORMAT_ARGB32)
+        return NULL;
+    plutovg_mutex_lock(&surface->mutex);
+    plutovg_mipmap_t* mipmap = surface->mipmap;
+    if(mipmap == NULL || mipmap->generation != surface->generation || plutovg_surface_is_volatile(surface)) {
+        plutovg_mipmap_destroy(mipmap);
+        mipmap = plutovg_mipmap_create(surface, surface->mipmap_enabled);
+        surface->mipmap = mipmap;
+    }
+
+    if(mipmap == NULL) {
+        plutovg_mutex_unlock(&surface->mutex);
+        if(surface->format != PLUTOVG_FORMAT_ARGB32)
+            level->data = NULL;
+        return NULL;
+    }
+
+    index = plutovg_min(index, mipmap->count);
+    plutovg_mipmap_build(mipmap, index);
+    plutovg_increment_reference(mipmap);
+    plutovg_mutex_unlock(&surface->mutex);
+
+    *level = index > 0 ? mipmap->levels[index - 1] : mipmap->base;
+    level->opaque = plutovg_surface_is_opaque(surface);
+    if(index > 0) {
+        plutovg_matrix_t scale;
+        plutovg_matrix_init_scale(&scale, (float)level->width / surface->width, (float)level->height / surface->height);
+        plutovg_matrix_multiply(matrix, matrix, &scale);
+    }
+
+    return mipmap;
+}
+
+/*
+ * Untransformed tiled blits composite at most one tile width per call, so small
+ * pattern tiles are cached with each row repeated to at least BUFFER_SIZE + width
+ * pixels; any span chunk then reads its source contiguously. The cache is keyed on
+ * the surface generation, so tiles whose pixels can be written directly are not cached.
+ */
+#define TILE_CACHE_MAX_SIZE 256
+struct plutovg_tile_cache {
+    plutovg_ref_count_t ref_count;
+    unsigned int generation;
+    int width;
+    int height;
+    uint32_t* data;
+};
+
+static plutovg_tile_cache_t* plutovg_tile_cache_create(const plutovg_surface_t* surface)
+{
+    int tile_width = surface->width;
+    int width = tile_width * ((BUFFER_SIZE + 2 * tile_width - 1) / tile_width);
+    plutovg_tile_cache_t* tilecache = plutovg_malloc(sizeof(plutovg_tile_cache_t) + (size_t)width * surface->height * sizeof(uint32_t));
+    if(tilecache == NULL)
+        return NULL;
+    plutovg_init_reference(tilecache);
+    tilecache->generation = surface->generation;
+    tilecache->width = width;
+    tilecache->height = surface->height;
+    tilecache->data = (uint32_t*)(tilecache + 1);
+    for(int y = 0; y < surface->height; y++) {
+        uint32_t* row = tilecache->data + (ptrdiff_t)y * width;
+        memcpy(row, surface->data + (ptrdiff_t)y * surface->stride, tile_width * sizeof(uint32_t));
+        for(int x = tile_width; x < width; x *= 2) {
+            memcpy(row + x, row, plutovg_min(x, width - x) * sizeof(uint32_t));
+        }
+    }
+
+    return tilecache;
+}
+
+void plutovg_tile_cache_destroy(plutovg_tile_cache_t* tilecache)
+{
+    if(plutovg_destroy_reference(tilecache)) {
+        plutovg_free(tilecache);
+    }
+}
+
+static plutovg_tile_cache_t* plutovg_texture_get_tile_cache(plutovg_texture_paint_t* texture)
+{
+    const plutovg_surface_t* surface = texture->surface;
+    if(surface->width > TILE_CACHE_MAX_SIZE || surface->height > TILE_CACHE_MAX_SIZE || plutovg_surface_is_volatile(surface))
+        return NULL;
+    plutovg_mutex_lock(&texture->mutex);
+    plutovg_tile_cache_t* tilecache = texture->tilecache;
+    if(tilecache == NULL || tilecache->generation != surface->generation) {
+        plutovg_tile_cache_destroy(tilecache);
+        tilecache = plutovg_tile_cache_create(surface);
+        texture->tilecache = tilecache;
+    }
+
+    plutovg_increment_reference(tilecache);
+    plutovg_mutex_unlock(&texture->mutex);
+    return tilecache;
+}
+
+/*
+ * The transformed fetchers step through the texture in 16.16 fixed point and gather
+ * with 32-bit byte offsets; larger textures are sampled by the wide fetcher below.
+ */
+static bool texture_level_fits_fixed_point(const plutovg_texture_level_t* level)
+{
+    return level->width < (1 << 15) && level->height < (1 << 15) && (int64_t)level->stride * level->height <= INT_MAX;
+}
+
+static inline uint32_t fetch_wide_texel(const texture_data_t* texture, int64_t x, int64_t y, bool tiled)
+{
+    if(tiled) {
+        x %= texture->width;
+        y %= texture->height;
+        if(x < 0) x += texture->width;
+        if(y < 0) y += texture->height;
+    } else if(x < 0 || y < 0 || x >= texture->width || y >= texture->height) {
+        return 0;
+    }
+
+    const uint32_t* row = (const uint32_t*)(texture->data + (ptrdiff_t)y * texture->stride);
+    return row[x];
+}
+
+/*
+ * Samples textures too large for the 16.16 fetchers with 48.16 fixed point coordinates and
+ * 64-bit offsets. It is scalar, but keeps such textures on the integer kernels.
+ */
+static void fetch_transformed_wide(uint32_t* buffer, const texture_data_t* texture, int64_t fx, int64_t fy, int64_t fdx, int64_t fdy, int length, bool bilinear, bool tiled)
+{
+    for(int i = 0; i < length; i++) {
+        if(bilinear) {
+            int64_t x = fx >> 16;
+            int64_t y = fy >> 16;
+            uint32_t tl = fetch_wide_texel(texture, x, y, tiled);
+            uint32_t tr = fetch_wide_texel(texture, x + 1, y, tiled);
+            uint32_t bl = fetch_wide_texel(texture, x, y + 1, tiled);
+            uint32_t br = fetch_wide_texel(texture, x + 1, y + 1, tiled);
+            int distx = (fx & 0x0000ffff) >> 8;
+            int disty = (fy & 0x0000ffff) >> 8;
+            buffer[i] = interpolate_4_pixels(tl, tr, bl, br, distx, disty);
+        } else {
+            buffer[i] = fetch_wide_texel(texture, fx >> 16, fy >> 16, tiled);
+        }
+
+        fx += fdx;
+        fy += fdy;
+    }
+}
+
+static void blend_transformed_wide_argb(plutovg_surface_t* surface, plutovg_operator_t op, const texture_data_t* texture, bool bilinear, bool tiled, const plutovg_span_buffer_t* span_buffer)
+{
+    composition_function_t func = blend_functions()->composition_table[op];
+    uint32_t buffer[BUFFER_SIZE];
+
+    const int64_t fdx = (int64_t)(texture->matrix.a * FIXED_SCALE);
+    const int64_t fdy = (int64_t)(texture->matrix.b * FIXED_SCALE);
+
+    int count = span_buffer->spans.size;
+    const plutovg_span_t* spans = span_buffer->spans.data;
+    while(count--) {
+        uint32_t* target = (uint32_t*)plutovg_surface_address(surface, spans->x, spans->y);
+
+        const double cx = spans->x + 0.5;
+        const double cy = spans->y + 0.5;
+
+        int64_t fx = (int64_t)((texture->matrix.c * cy + texture->matrix.a * cx + texture->matrix.e) * FIXED_SCALE);
+        int64_t fy = (int64_t)((texture->matrix.d * cy + texture->matrix.b * cx + texture->matrix.f) * FIXED_SCALE);
+        if(bilinear) {
+            fx -= HALF_POINT;
+            fy -= HALF_POINT;
+        }
+
+        const int coverage = (spans->coverage * texture->const_alpha) >> 8;
+        int length = spans->len;
+        while(length) {
+            int l = plutovg_min(length, BUFFER_SIZE);
+            fetch_transformed_wide(buffer, texture, fx, fy, fdx, fdy, l, bilinear, tiled);
+            func(target, l, buffer, coverage);
+            fx += l * fdx;
+            fy += l * fdy;
+            target += l;
+            length -= l;
+        }
+
+        ++spans;
     }
 }
 
-static void plutovg_blend_texture(plutovg_canvas_t* canvas, const plutovg_texture_paint_t* texture, const plutovg_span_buffer_t* span_buffer)
+static void plutovg_blend_texture(plutovg_canvas_t* canvas, plutovg_surface_t* surface, plutovg_operator_t op, plutovg_texture_paint_t* texture, const plutovg_span_buffer_t* span_buffer)
 {
     if(texture->surface == NULL)
         return;
     plutovg_state_t* state = canvas->state;
     texture_data_t data;
     data.matrix = texture->matrix;
-    data.data = texture->surface->data;
-    data.width = texture->surface->width;
-    data.height = texture->surface->height;
-    data.stride = texture->surface->stride;
     data.const_alpha = lroundf(state->opacity * texture->opacity * 256);
 
     plutovg_matrix_multiply(&data.matrix, &data.matrix, &state->matrix);
     if(!plutovg_matrix_invert(&data.matrix, &data.matrix))
         return;
+    plutovg_texture_level_t level;
+    plutovg_mipmap_t* mipmap = plutovg_surface_select_level(texture->surface, texture->type, &data.matrix, &level);
+    if(level.data == NULL)
+        return;
+    data.data = level.data;
+    data.width = level.width;
+    data.height = level.height;
+    data.stride = level.stride;
+    data.row_width = level.width;
+    data.opaque = level.opaque && data.const_alpha == 256;
+
+    /*
+     * An opaque source composites over the destination like a copy. Transformed plain
+     * textures remap only their in-bounds runs, since pixels outside the image are transparent.
+     */
+    plutovg_operator_t opaque_op = op;
+    if(op == PLUTOVG_OPERATOR_SRC_OVER && data.opaque)
+        opaque_op = PLUTOVG_OPERATOR_SRC;
     const plutovg_matrix_t* matrix = &data.matrix;
     if(matrix->a == 1 && matrix->b == 0 && matrix->c == 0 && matrix->d == 1) {
         if(texture->type == PLUTOVG_TEXTURE_TYPE_PLAIN) {
-            blend_untransformed_argb(canvas->surface, state->op, &data, span_buffer);
+            blend_untransformed_argb(surface, opaque_op, &data, span_buffer);
         } else {
-            blend_untransformed_tiled_argb(canvas->surface, state->op, &data, span_buffer);
+            plutovg_tile_cache_t* tilecache = NULL;
+            if(mipmap == NULL)
+                tilecache = plutovg_texture_get_tile_cache(texture);
+            if(tilecache) {
+                data.data = (uint8_t*)tilecache->data;
+                data.stride = tilecache->width * sizeof(uint32_t);
+                data.row_width = tilecache->width;
+            }
+
+            blend_untransformed_tiled_argb(surface, opaque_op, &data, span_buffer);
+            plutovg_tile_cache_destroy(tilecache);
         }
     } else {
-        if(texture->type == PLUTOVG_TEXTURE_TYPE_PLAIN) {
-            blend_transformed_argb(canvas->surface, state->op, &data, span_buffer);
-        } else if(fabsf(matrix->b) > 1e-6f || fabsf(matrix->c) > 1e-6f) {
-            blend_transformed_bilinear_tiled_argb(canvas->surface, state->op, &data, span_buffer);
+        bool bilinear = fabsf(matrix->b) > 1e-6f || fabsf(matrix->c) > 1e-6f;
+        if(!texture_level_fits_fixed_point(&level)) {
+            if(texture->type == PLUTOVG_TEXTURE_TYPE_PLAIN) {
+                blend_transformed_wide_argb(surface, op, &data, bilinear, false, span_buffer);
+            } else {
+                blend_transformed_wide_argb(surface, opaque_op, &data, bilinear, true, span_buffer);
+            }
+        } else if(texture->type == PLUTOVG_TEXTURE_TYPE_PLAIN) {
+            if(bilinear) {
+                blend_transformed_bilinear_argb(surface, op, &data, span_buffer);
+            } else {
+                blend_transformed_argb(surface, op, &data, span_buffer);
+            }
+        } else if(bilinear) {
+            blend_transformed_bilinear_tiled_argb(surface, opaque_op, &data, span_buffer);
+        } else {
+            blend_transformed_tiled_argb(surface, opaque_op, &data, span_buffer);
+        }
+    }
+
+    plutovg_mipmap_destroy(mipmap);
+}
+
+static void plutovg_blend_paint(plutovg_canvas_t* canvas, plutovg_surface_t* surface, plutovg_operator_t op, const plutovg_span_buffer_t* span_buffer)
+{
+    plutovg_paint_t* paint = canvas->state->paint;
+    if(paint->type == PLUTOVG_PAINT_TYPE_GRADIENT) {
+        plutovg_gradient_paint_t* gradient = (plutovg_gradient_paint_t*)(paint);
+        plutovg_blend_gradient(canvas, surface, op, gradient, span_buffer);
+    } else {
+        plutovg_texture_paint_t* texture = (plutovg_texture_paint_t*)(paint);
+        plutovg_blend_texture(canvas, surface, op, texture, span_buffer);
+    }
+}
+
+/*
+ * Gradients and textures reach A8 and RGB565 targets through the ARGB paths: bands of
+ * rows are expanded into an ARGB staging surface, blended there with the regular fetchers
+ * and kernels, and stored back in the target format. A band holds about this many pixels.
+ */
+#define STAGING_SIZE (16 * 1024)
+
+static void staging_load(const plutovg_surface_t* surface, uint32_t* dest, int x, int y, int length)
+{
+    const uint8_t* src = plutovg_surface_address(surface, x, y);
+    if(surface->format == PLUTOVG_FORMAT_A8) {
+        for(int i = 0; i < length; i++) {
+            dest[i] = (uint32_t)src[i] << 24;
+        }
+    } else {
+        const uint16_t* pixels = (const uint16_t*)(src);
+        for(int i = 0; i < length; i++) {
+            dest[i] = plutovg_rgb565_to_argb(pixels[i]);
+        }
+    }
+}
+
+static void staging_store(plutovg_surface_t* surface, const uint32_t* src, int x, int y, int length)
+{
+    uint8_t* dest = plutovg_surface_address(surface, x, y);
+    if(surface->format == PLUTOVG_FORMAT_A8) {
+        for(int i = 0; i < length; i++) {
+            dest[i] = src[i] >> 24;
+        }
+    } else {
+        uint16_t* pixels = (uint16_t*)(dest);
+        for(int i = 0; i < length; i++) {
+            pixels[i] = plutovg_argb_to_rgb565(src[i], plutovg_rgb565_dither(x + i, y));
+        }
+    }
+}
+
+static void plutovg_blend_staged(plutovg_canvas_t* canvas, plutovg_operator_t op, const plutovg_span_buffer_t* span_buffer)
+{
+    const plutovg_span_t* spans = span_buffer->spans.data;
+    const int count = span_buffer->spans.size;
+    int x1 = INT_MAX;
+    int x2 = INT_MIN;
+    for(int i = 0; i < count; i++) {
+        x1 = plutovg_min(x1, spans[i].x);
+        x2 = plutovg_max(x2, spans[i].x + spans[i].len);
+    }
+
+    const int width = x2 - x1;
+    const int rows = plutovg_max(1, STAGING_SIZE / width);
+    plutovg_array_clear(canvas->staging_buffer);
+    plutovg_array_ensure(canvas->staging_buffer, width * rows);
+
+    plutovg_surface_t staging;
+    memset(&staging, 0, sizeof(staging));
+    staging.width = width;
+    staging.height = rows;
+    staging.stride = width * sizeof(uint32_t);
+    staging.origin_x = x1;
+    staging.format = PLUTOVG_FORMAT_ARGB32;
+    staging.data = (unsigned char*)canvas->staging_buffer.data;
+
+    plutovg_span_buffer_t band;
+    band.spans.capacity = 0;
+    band.x = x1;
+    band.w = width;
+    band.h = rows;
+
+    plutovg_surface_t* surface = canvas->surface;
+    int index = 0;
+    while(index < count) {
+        const int y = spans[index].y;
+        int end = index + 1;
+        while(end < count && spans[end].y >= y && spans[end].y < y + rows)
+            ++end;
+        staging.origin_y = y;
+        for(int i = index; i < end; i++) {
+            uint32_t* dest = (uint32_t*)plutovg_surface_address(&staging, spans[i].x, spans[i].y);
+            staging_load(surface, dest, spans[i].x, spans[i].y, spans[i].len);
+        }
+
+        band.spans.data = (plutovg_span_t*)(spans + index);
+        band.spans.size = end - index;
+        band.y = y;
+        plutovg_blend_paint(canvas, &staging, op, &band);
+        for(int i = index; i < end; i++) {
+            const uint32_t* src = (const uint32_t*)plutovg_surface_address(&staging, spans[i].x, spans[i].y);
+            staging_store(surface, src, spans[i].x, spans[i].y, spans[i].len);
+        }
+
+        index = end;
+    }
+}
+
+static void blend_solid_a8(plutovg_surface_t* surface, plutovg_operator_t op, uint32_t alpha, const plutovg_span_buffer_t* span_buffer)
+{
+    composition_solid_a8_function_t func = blend_functions()->composition_solid_a8_table[op];
+    int count = span_buffer->spans.size;
+    const plutovg_span_t* spans = span_buffer->spans.data;
+    while(count--) {
+        uint8_t* target = plutovg_surface_address(surface, spans->x, spans->y);
+        func(target, spans->len, alpha, spans->coverage);
+        ++spans;
+    }
+}
+
+/*
+ * Alpha-only targets keep just the coverage of solid colors; gradients and textures
+ * have per-pixel alpha and are staged through the ARGB paths.
+ */
+static void plutovg_blend_a8(plutovg_canvas_t* canvas, const plutovg_span_buffer_t* span_buffer)
+{
+    plutovg_state_t* state = canvas->state;
+    const plutovg_color_t* color = &state->color;
+    if(state->paint && state->paint->type != PLUTOVG_PAINT_TYPE_COLOR) {
+        plutovg_blend_staged(canvas, state->op, span_buffer);
+        return;
+    }
+
+    if(state->paint)
+        color = &((const plutovg_solid_paint_t*)(state->paint))->color;
+    uint32_t alpha = lroundf(color->a * state->opacity * 255);
+    plutovg_operator_t op = state->op;
+    if(op == PLUTOVG_OPERATOR_SRC_OVER) {
+        if(alpha == 0)
+            return;
+        if(alpha == 255) {
+            op = PLUTOVG_OPERATOR_SRC;
+        }
+    }
+
+    blend_solid_a8(canvas->surface, op, alpha, span_buffer);
+}
+
+/*
+ * RGB565 targets composite solid colors in ARGB row buffers: pixels are expanded,
+ * blended by the regular kernels and packed back with ordered dithering. Copies of
+ * an opaque color skip the expansion and fill a repeating four-pixel dither pattern.
+ */
+static void blend_solid_rgb565(plutovg_surface_t* surface, plutovg_operator_t op, uint32_t solid, const plutovg_span_buffer_t* span_buffer)
+{
+    composition_solid_function_t func = blend_functions()->composition_solid_table[op];
+    uint32_t buffer[BUFFER_SIZE];
+    int count = span_buffer->spans.size;
+    const plutovg_span_t* spans = span_buffer->spans.data;
+    while(count--) {
+        uint16_t* target = (uint16_t*)plutovg_surface_address(surface, spans->x, spans->y);
+        const int y = spans->y;
+        if(op == PLUTOVG_OPERATOR_SRC && spans->coverage == 255) {
+            uint16_t pattern[4];
+            for(int i = 0; i < 4; i++)
+                pattern[i] = plutovg_argb_to_rgb565(solid, plutovg_rgb565_dither(i, y));
+            for(int i = 0; i < spans->len; i++) {
+                target[i] = pattern[(spans->x + i) & 3];
+            }
         } else {
-            blend_transformed_tiled_argb(canvas->surface, state->op, &data, span_buffer);
+            for(int offset = 0; offset < spans->len; offset += BUFFER_SIZE) {
+                int length = plutovg_min(BUFFER_SIZE, spans->len - offset);
+                for(int i = 0; i < length; i++)
+                    buffer[i] = plutovg_rgb565_to_argb(target[offset + i]);
+                func(buffer, length, solid, spans->coverage);
+                for(int i = 0; i < length; i++) {
+                    target[offset + i] = plutovg_argb_to_rgb565(buffer[i], plutovg_rgb565_dither(spans->x + offset + i, y));
+                }
+            }
+        }
+
+        ++spans;
+    }
+}
+
+/*
+ * Solid colors are blended into RGB565 targets by the integer kernels; gradients and
+ * textures are staged through the ARGB paths.
+ */
+static void plutovg_blend_rgb565(plutovg_canvas_t* canvas, plutovg_operator_t op, const plutovg_span_buffer_t* span_buffer)
+{
+    plutovg_state_t* state = canvas->state;
+    const plutovg_color_t* color = &state->color;
+    if(state->paint && state->paint->type != PLUTOVG_PAINT_TYPE_COLOR) {
+        if(op != PLUTOVG_OPERATOR_DST)
+            plutovg_blend_staged(canvas, op, span_buffer);
+        return;
+    }
+
+    if(state->paint)
+        color = &((const plutovg_solid_paint_t*)(state->paint))->color;
+    uint32_t solid = premultiply_color_with_opacity(color, state->opacity);
+    if(op == PLUTOVG_OPERATOR_SRC_OVER) {
+        if(plutovg_alpha(solid) == 0)
+            return;
+        if(plutovg_alpha(solid) == 255) {
+            op = PLUTOVG_OPERATOR_SRC;
         }
     }
+
+    if(op != PLUTOVG_OPERATOR_DST) {
+        blend_solid_rgb565(canvas->surface, op, solid, span_buffer);
+    }
+}
+
+/*
+ * With a destination alpha of one, every operator reduces to one that ignores the
+ * destination alpha; opaque formats composite with the reduced operator.
+ */
+static inline plutovg_operator_t opaque_destination_operator(plutovg_operator_t op)
+{
+    switch(op) {
+    case PLUTOVG_OPERATOR_DST_OVER:
+        return PLUTOVG_OPERATOR_DST;
+    case PLUTOVG_OPERATOR_SRC_IN:
+        return PLUTOVG_OPERATOR_SRC;
+    case PLUTOVG_OPERATOR_SRC_OUT:
+        return PLUTOVG_OPERATOR_CLEAR;
+    case PLUTOVG_OPERATOR_SRC_ATOP:
+        return PLUTOVG_OPERATOR_SRC_OVER;
+    case PLUTOVG_OPERATOR_DST_ATOP:
+        return PLUTOVG_OPERATOR_DST_IN;
+    case PLUTOVG_OPERATOR_XOR:
+        return PLUTOVG_OPERATOR_DST_OUT;
+    default:
+        return op;
+    }
+}
+
+/* Whether compositing with `op` keeps a fully opaque destination opaque. */
+static inline bool operator_preserves_opaque(plutovg_operator_t op)
+{
+    switch(op) {
+    case PLUTOVG_OPERATOR_SRC_OVER:
+    case PLUTOVG_OPERATOR_DST:
+    case PLUTOVG_OPERATOR_DST_OVER:
+    case PLUTOVG_OPERATOR_SRC_ATOP:
+        return true;
+    default:
+        return false;
+    }
 }
 
 void plutovg_blend(plutovg_canvas_t* canvas, const plutovg_span_buffer_t* span_buffer)
 {
     if(span_buffer->spans.size == 0)
         return;
+    if(canvas->layer == NULL)
+        plutovg_canvas_add_damage(canvas, span_buffer);
+    plutovg_surface_t* surface = canvas->surface;
+    bool opaque = surface->opaque && operator_preserves_opaque(canvas->state->op);
+    plutovg_surface_invalidate(surface);
+    if(opaque)
+        surface->opaque = true;
+    if(blend_backend == PLUTOVG_BLEND_BACKEND_PIPELINE) {
+        plutovg_pipeline_blend(canvas, surface, span_buffer);
+        return;
+    }
+
+    if(surface->format == PLUTOVG_FORMAT_A8) {
+        plutovg_blend_a8(canvas, span_buffer);
+        return;
+    }
+
+    plutovg_operator_t op = canvas->state->op;
+    if(plutovg_format_is_opaque(surface->format))
+        op = opaque_destination_operator(op);
+    if(surface->format == PLUTOVG_FORMAT_RGB565) {
+        plutovg_blend_rgb565(canvas, op, span_buffer);
+        return;
+    }
+
     if(canvas->state->paint == NULL) {
-        plutovg_blend_color(canvas, &canvas->state->color, span_buffer);
+        plutovg_blend_color(canvas, op, &canvas->state->color, span_buffer);
         return;
     }
 
     plutovg_paint_t* paint = canvas->state->paint;
     if(paint->type == PLUTOVG_PAINT_TYPE_COLOR) {
         plutovg_solid_paint_t* solid = (plutovg_solid_paint_t*)(paint);
-        plutovg_blend_color(canvas, &solid->color, span_buffer);
-    } else if(paint->type == PLUTOVG_PAINT_TYPE_GRADIENT) {
-        plutovg_gradient_paint_t* gradient = (plutovg_gradient_paint_t*)(paint);
-        plutovg_blend_gradient(canvas, gradient, span_buffer);
+        plutovg_blend_color(canvas, op, &solid->color, span_buffer);
     } else {
-        plutovg_texture_paint_t* texture = (plutovg_texture_paint_t*)(paint);
-        plutovg_blend_texture(canvas, texture, span_buffer);
+        plutovg_blend_paint(canvas, surface, op, span_buffer);
     }
 }
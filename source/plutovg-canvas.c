@@ -11,11 +11,77 @@ const char* plutovg_version_string(void)
     return PLUTOVG_VERSION_STRING;
 }
 
+static void* plutovg_default_malloc(size_t size, void* user_data)
+{
+    return malloc(size);
+}
+
+static void* plutovg_default_realloc(void* ptr, size_t size, void* user_data)
+{
+    return realloc(ptr, size);
+}
+
+static void plutovg_default_free(void* ptr, void* user_data)
+{
+    free(ptr);
+}
+
+static plutovg_allocator_t plutovg_allocator = {plutovg_default_malloc, plutovg_default_realloc, plutovg_default_free, NULL};
+
+void plutovg_set_allocator(const plutovg_allocator_t* allocator)
+{
+    if(allocator == NULL) {
+        plutovg_allocator.malloc_func = plutovg_default_malloc;
+        plutovg_allocator.realloc_func = plutovg_default_realloc;
+        plutovg_allocator.free_func = plutovg_default_free;
+        plutovg_allocator.user_data = NULL;
+    } else {
+        plutovg_allocator = *allocator;
+    }
+}
+
+void plutovg_get_allocator(plutovg_allocator_t* allocator)
+{
+    *allocator = plutovg_allocator;
+}
+
+bool plutovg_allocator_is_default(void)
+{
+    return plutovg_allocator.malloc_func == plutovg_default_malloc;
+}
+
+void* plutovg_malloc(size_t size)
+{
+    return plutovg_allocator.malloc_func(size, plutovg_allocator.user_data);
+}
+
+void* plutovg_calloc(size_t count, size_t size)
+{
+    if(size && count > SIZE_MAX / size)
+        return NULL;
+    void* ptr = plutovg_malloc(count * size);
+    if(ptr)
+        memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void* plutovg_realloc(void* ptr, size_t size)
+{
+    return plutovg_allocator.realloc_func(ptr, size, plutovg_allocator.user_data);
+}
+
+void plutovg_free(void* ptr)
+{
+    if(ptr) {
+        plutovg_allocator.free_func(ptr, plutovg_allocator.user_data);
+    }
+}
+
 #define PLUTOVG_DEFAULT_STROKE_STYLE ((plutovg_stroke_style_t){1.f, PLUTOVG_LINE_CAP_BUTT, PLUTOVG_LINE_JOIN_MITER, 10.f})
 
 static plutovg_state_t* plutovg_state_create(void)
 {
-    plutovg_state_t* state = malloc(sizeof(plutovg_state_t));
+    plutovg_state_t* state = plutovg_malloc(sizeof(plutovg_state_t));
     state->paint = NULL;
     state->font_face = NULL;
     state->color = PLUTOVG_BLACK_COLOR;
@@ -76,24 +142,67 @@ static void plutovg_state_destroy(plutovg_state_t* state)
     plutovg_font_face_destroy(state->font_face);
     plutovg_array_destroy(state->stroke.dash.array);
     plutovg_span_buffer_destroy(&state->clip_spans);
-    free(state);
+    plutovg_free(state);
 }
 
-plutovg_canvas_t* plutovg_canvas_create(plutovg_surface_t* surface)
+static plutovg_layer_t* plutovg_layer_create(void)
+{
+    plutovg_layer_t* layer = plutovg_malloc(sizeof(plutovg_layer_t));
+    layer->surface = plutovg_surface_create_for_data(NULL, 0, 0, 0);
+    layer->paint = plutovg_paint_create_texture(layer->surface, PLUTOVG_TEXTURE_TYPE_PLAIN, 1.f, NULL);
+    layer->capacity = 0;
+    layer->target = NULL;
+    layer->state = NULL;
+    layer->next = NULL;
+    return layer;
+}
+
+static void plutovg_layer_destroy(plutovg_layer_t* layer)
+{
+    plutovg_free(layer->surface->data);
+    plutovg_paint_destroy(layer->paint);
+    plutovg_surface_destroy(layer->surface);
+    plutovg_free(layer);
+}
+
+static plutovg_canvas_t* plutovg_canvas_create_internal(plutovg_surface_t* surface, int width, int height, plutovg_display_list_t* recording)
 {
-    plutovg_canvas_t* canvas = malloc(sizeof(plutovg_canvas_t));
+    plutovg_canvas_t* canvas = plutovg_malloc(sizeof(plutovg_canvas_t));
+    if(canvas == NULL)
+        return NULL;
     plutovg_init_reference(canvas);
     canvas->surface = plutovg_surface_reference(surface);
     canvas->path = plutovg_path_create();
     canvas->state = plutovg_state_create();
     canvas->freed_state = NULL;
+    canvas->layer = NULL;
+    canvas->freed_layer = NULL;
+    canvas->recording = recording;
     canvas->face_cache = NULL;
-    canvas->clip_rect = PLUTOVG_MAKE_RECT(0, 0, surface->width, surface->height);
+    canvas->clip_rect = PLUTOVG_MAKE_RECT(0, 0, width, height);
+    canvas->tile_rect = canvas->clip_rect;
+    canvas->num_damage_rects = 0;
     plutovg_span_buffer_init(&canvas->clip_spans);
     plutovg_span_buffer_init(&canvas->fill_spans);
+    canvas->rasterizer = plutovg_rasterizer_create();
+    plutovg_array_init(canvas->stops_buffer);
+    plutovg_array_init(canvas->staging_buffer);
+    plutovg_array_init(canvas->row_buffer);
     return canvas;
 }
 
+plutovg_canvas_t* plutovg_canvas_create(plutovg_surface_t* surface)
+{
+    return plutovg_canvas_create_internal(surface, surface->width, surface->height, NULL);
+}
+
+plutovg_canvas_t* plutovg_canvas_create_recording(int width, int height)
+{
+    width = plutovg_max(0, width);
+    height = plutovg_max(0, height);
+    return plutovg_canvas_create_internal(NULL, width, height, plutovg_display_list_create(width, height));
+}
+
 plutovg_canvas_t* plutovg_canvas_reference(plutovg_canvas_t* canvas)
 {
     plutovg_increment_reference(canvas);
@@ -115,12 +224,30 @@ void plutovg_canvas_destroy(plutovg_canvas_t* canvas)
             plutovg_state_destroy(state);
         }
 
+        while(canvas->layer) {
+            plutovg_layer_t* layer = canvas->layer;
+            canvas->layer = layer->next;
+            canvas->surface = layer->target;
+            plutovg_layer_destroy(layer);
+        }
+
+        while(canvas->freed_layer) {
+            plutovg_layer_t* layer = canvas->freed_layer;
+            canvas->freed_layer = layer->next;
+            plutovg_layer_destroy(layer);
+        }
+
+        plutovg_display_list_destroy(canvas->recording);
         plutovg_font_face_cache_destroy(canvas->face_cache);
         plutovg_span_buffer_destroy(&canvas->fill_spans);
         plutovg_span_buffer_destroy(&canvas->clip_spans);
+        plutovg_rasterizer_destroy(canvas->rasterizer);
+        plutovg_array_destroy(canvas->stops_buffer);
+        plutovg_array_destroy(canvas->staging_buffer);
+        plutovg_array_destroy(canvas->row_buffer);
         plutovg_surface_destroy(canvas->surface);
         plutovg_path_destroy(canvas->path);
-        free(canvas);
+        plutovg_free(canvas);
     }
 }
 
@@ -131,10 +258,15 @@ int plutovg_canvas_get_reference_count(const plutovg_canvas_t* canvas)
 
 plutovg_surface_t* plutovg_canvas_get_surface(const plutovg_canvas_t* canvas)
 {
-    return canvas->surface;
+    const plutovg_layer_t* layer = canvas->layer;
+    if(layer == NULL)
+        return canvas->surface;
+    while(layer->next)
+        layer = layer->next;
+    return layer->target;
 }
 
-void plutovg_canvas_save(plutovg_canvas_t* canvas)
+static void plutovg_canvas_save_state(plutovg_canvas_t* canvas)
 {
     plutovg_state_t* new_state = canvas->freed_state;
     if(new_state == NULL)
@@ -146,10 +278,8 @@ void plutovg_canvas_save(plutovg_canvas_t* canvas)
     canvas->state = new_state;
 }
 
-void plutovg_canvas_restore(plutovg_canvas_t* canvas)
+static void plutovg_canvas_restore_state(plutovg_canvas_t* canvas)
 {
-    if(canvas->state->next == NULL)
-        return;
     plutovg_state_t* old_state = canvas->state;
     canvas->state = old_state->next;
     plutovg_state_reset(old_state);
@@ -157,6 +287,177 @@ void plutovg_canvas_restore(plutovg_canvas_t* canvas)
     canvas->freed_state = old_state;
 }
 
+void plutovg_canvas_save(plutovg_canvas_t* canvas)
+{
+    if(canvas->recording)
+        plutovg_display_list_add(canvas->recording, PLUTOVG_COMMAND_TYPE_SAVE, canvas);
+    plutovg_canvas_save_state(canvas);
+}
+
+void plutovg_canvas_restore(plutovg_canvas_t* canvas)
+{
+    if(canvas->state->next == NULL)
+        return;
+    if(canvas->layer && canvas->layer->state == canvas->state)
+        return;
+    if(canvas->recording)
+        plutovg_display_list_add(canvas->recording, PLUTOVG_COMMAND_TYPE_RESTORE, canvas);
+    plutovg_canvas_restore_state(canvas);
+}
+
+void plutovg_canvas_reset(plutovg_canvas_t* canvas, plutovg_surface_t* surface)
+{
+    while(canvas->layer) {
+        plutovg_layer_t* layer = canvas->layer;
+        canvas->layer = layer->next;
+        canvas->surface = layer->target;
+        layer->next = canvas->freed_layer;
+        canvas->freed_layer = layer;
+    }
+
+    while(canvas->state->next)
+        plutovg_canvas_restore_state(canvas);
+    plutovg_state_reset(canvas->state);
+    plutovg_path_reset(canvas->path);
+    plutovg_span_buffer_reset(&canvas->clip_spans);
+    plutovg_span_buffer_reset(&canvas->fill_spans);
+    if(canvas->recording) {
+        plutovg_display_list_clear(canvas->recording);
+    } else if(surface) {
+        plutovg_surface_reference(surface);
+        plutovg_surface_destroy(canvas->surface);
+        canvas->surface = surface;
+        canvas->clip_rect = PLUTOVG_MAKE_RECT(0, 0, surface->width, surface->height);
+    }
+
+    canvas->tile_rect = canvas->clip_rect;
+    canvas->num_damage_rects = 0;
+}
+
+static plutovg_layer_t* plutovg_canvas_acquire_layer(plutovg_canvas_t* canvas, int x, int y, int width, int height)
+{
+    size_t size = (size_t)width * height * 4;
+    plutovg_layer_t** best = NULL;
+    for(plutovg_layer_t** it = &canvas->freed_layer; *it; it = &(*it)->next) {
+        if((*it)->capacity >= size && (best == NULL || (*it)->capacity < (*best)->capacity)) {
+            best = it;
+        }
+    }
+
+    plutovg_layer_t* layer;
+    if(best) {
+        layer = *best;
+        *best = layer->next;
+    } else if(canvas->freed_layer) {
+        layer = canvas->freed_layer;
+        canvas->freed_layer = layer->next;
+    } else {
+        layer = plutovg_layer_create();
+    }
+
+    plutovg_surface_t* surface = layer->surface;
+    if(layer->capacity < size) {
+        plutovg_free(surface->data);
+        surface->data = plutovg_malloc(size);
+        layer->capacity = size;
+        if(surface->data == NULL) {
+            layer->capacity = 0;
+            width = height = 0;
+        }
+    }
+
+    surface->width = width;
+    surface->height = height;
+    surface->stride = width * 4;
+    surface->origin_x = x;
+    surface->origin_y = y;
+    return layer;
+}
+
+void plutovg_canvas_push_group(plutovg_canvas_t* canvas)
+{
+    if(canvas->recording) {
+        plutovg_display_list_add(canvas->recording, PLUTOVG_COMMAND_TYPE_PUSH_GROUP, canvas);
+        plutovg_layer_t* layer = plutovg_canvas_acquire_layer(canvas, 0, 0, 0, 0);
+        layer->target = canvas->surface;
+        plutovg_canvas_save_state(canvas);
+        layer->state = canvas->state;
+        layer->next = canvas->layer;
+        canvas->layer = layer;
+        return;
+    }
+
+    plutovg_rect_t extents;
+    plutovg_canvas_clip_extents(canvas, &extents);
+    const plutovg_rect_t* rect = &canvas->tile_rect;
+    int x1 = (int)floorf(plutovg_max(extents.x, rect->x));
+    int y1 = (int)floorf(plutovg_max(extents.y, rect->y));
+    int x2 = (int)ceilf(plutovg_min(extents.x + extents.w, rect->x + rect->w));
+    int y2 = (int)ceilf(plutovg_min(extents.y + extents.h, rect->y + rect->h));
+
+    /*
+     * The layer only covers the pixels the group can reach, but it keeps canvas coordinates:
+     * its surface is addressed from (x1, y1), and paths are still clipped against the canvas,
+     * so everything is rasterized exactly as it would be on the canvas itself.
+     */
+    plutovg_layer_t* layer = plutovg_canvas_acquire_layer(canvas, x1, y1, plutovg_max(0, x2 - x1), plutovg_max(0, y2 - y1));
+    plutovg_surface_clear(layer->surface, &PLUTOVG_MAKE_COLOR(0, 0, 0, 0));
+    layer->target = canvas->surface;
+
+    plutovg_canvas_save_state(canvas);
+    layer->state = canvas->state;
+    layer->next = canvas->layer;
+    canvas->layer = layer;
+    canvas->surface = layer->surface;
+}
+
+void plutovg_canvas_pop_group(plutovg_canvas_t* canvas, float opacity, plutovg_operator_t op)
+{
+    plutovg_layer_t* layer = canvas->layer;
+    if(layer == NULL)
+        return;
+    while(canvas->state != layer->state)
+        plutovg_canvas_restore_state(canvas);
+    canvas->layer = layer->next;
+    canvas->surface = layer->target;
+    plutovg_canvas_restore_state(canvas);
+    layer->next = canvas->freed_layer;
+    canvas->freed_layer = layer;
+    if(canvas->recording) {
+        plutovg_command_t* command = plutovg_display_list_add(canvas->recording, PLUTOVG_COMMAND_TYPE_POP_GROUP, canvas);
+        command->opacity = plutovg_clamp(opacity, 0.f, 1.f);
+        command->op = op;
+        return;
+    }
+
+    const plutovg_surface_t* surface = layer->surface;
+    plutovg_texture_paint_t* texture = (plutovg_texture_paint_t*)(layer->paint);
+    plutovg_matrix_init_translate(&texture->matrix, surface->origin_x, surface->origin_y);
+
+    plutovg_state_t* state = canvas->state;
+    plutovg_paint_t* paint = state->paint;
+    plutovg_matrix_t matrix = state->matrix;
+    plutovg_operator_t state_op = state->op;
+    float state_opacity = state->opacity;
+    state->paint = layer->paint;
+    state->matrix = PLUTOVG_IDENTITY_MATRIX;
+    state->op = op;
+    state->opacity = plutovg_clamp(opacity, 0.f, 1.f);
+
+    plutovg_span_buffer_init_rect(&canvas->fill_spans, surface->origin_x, surface->origin_y, surface->width, surface->height);
+    if(state->clipping) {
+        plutovg_span_buffer_intersect(&canvas->clip_spans, &canvas->fill_spans, &state->clip_spans);
+        plutovg_blend(canvas, &canvas->clip_spans);
+    } else {
+        plutovg_blend(canvas, &canvas->fill_spans);
+    }
+
+    state->paint = paint;
+    state->matrix = matrix;
+    state->op = state_op;
+    state->opacity = state_opacity;
+}
+
 void plutovg_canvas_set_rgb(plutovg_canvas_t* canvas, float r, float g, float b)
 {
     plutovg_canvas_set_rgba(canvas, r, g, b, 1.f);
@@ -504,13 +805,13 @@ plutovg_path_t* plutovg_canvas_get_path(const plutovg_canvas_t* canvas)
 
 bool plutovg_canvas_fill_contains(plutovg_canvas_t* canvas, float x, float y)
 {
-    plutovg_rasterize(&canvas->fill_spans, canvas->path, &canvas->state->matrix, NULL, NULL, canvas->state->winding);
+    plutovg_rasterize(canvas->rasterizer, &canvas->fill_spans, canvas->path, &canvas->state->matrix, NULL, NULL, NULL, canvas->state->winding);
     return plutovg_span_buffer_contains(&canvas->fill_spans, x, y);
 }
 
 bool plutovg_canvas_stroke_contains(plutovg_canvas_t* canvas, float x, float y)
 {
-    plutovg_rasterize(&canvas->fill_spans, canvas->path, &canvas->state->matrix, NULL, NULL, canvas->state->winding);
+    plutovg_rasterize(canvas->rasterizer, &canvas->fill_spans, canvas->path, &canvas->state->matrix, NULL, NULL, NULL, canvas->state->winding);
     return plutovg_span_buffer_contains(&canvas->fill_spans, x, y);
 }
 
@@ -530,16 +831,108 @@ bool plutovg_canvas_clip_contains(plutovg_canvas_t* canvas, float x, float y)
 
 void plutovg_canvas_fill_extents(plutovg_canvas_t *canvas, plutovg_rect_t* extents)
 {
-    plutovg_rasterize(&canvas->fill_spans, canvas->path, &canvas->state->matrix, NULL, NULL, canvas->state->winding);
+    plutovg_rasterize(canvas->rasterizer, &canvas->fill_spans, canvas->path, &canvas->state->matrix, NULL, NULL, NULL, canvas->state->winding);
     plutovg_span_buffer_extents(&canvas->fill_spans, extents);
 }
 
 void plutovg_canvas_stroke_extents(plutovg_canvas_t *canvas, plutovg_rect_t* extents)
 {
-    plutovg_rasterize(&canvas->fill_spans, canvas->path, &canvas->state->matrix, NULL, &canvas->state->stroke, PLUTOVG_FILL_RULE_NON_ZERO);
+    plutovg_rasterize(canvas->rasterizer, &canvas->fill_spans, canvas->path, &canvas->state->matrix, NULL, NULL, &canvas->state->stroke, PLUTOVG_FILL_RULE_NON_ZERO);
     plutovg_span_buffer_extents(&canvas->fill_spans, extents);
 }
 
+static bool plutovg_rect_overlaps(const plutovg_rect_t* a, const plutovg_rect_t* b)
+{
+    return a->x < b->x + b->w && a->x + a->w > b->x && a->y < b->y + b->h && a->y + a->h > b->y;
+}
+
+static void plutovg_rect_unite(plutovg_rect_t* rect, const plutovg_rect_t* a, const plutovg_rect_t* b)
+{
+    float x1 = plutovg_min(a->x, b->x);
+    float y1 = plutovg_min(a->y, b->y);
+    float x2 = plutovg_max(a->x + a->w, b->x + b->w);
+    float y2 = plutovg_max(a->y + a->h, b->y + b->h);
+    *rect = PLUTOVG_MAKE_RECT(x1, y1, x2 - x1, y2 - y1);
+}
+
+void plutovg_canvas_add_damage(plutovg_canvas_t* canvas, const plutovg_span_buffer_t* span_buffer)
+{
+    /*
+     * Spans are sorted by row, so only the horizontal extent needs a pass over them.
+     */
+    const plutovg_span_t* spans = span_buffer->spans.data;
+    int count = span_buffer->spans.size;
+    int x1 = spans[0].x;
+    int x2 = spans[0].x + spans[0].len;
+    for(int i = 1; i < count; i++) {
+        x1 = plutovg_min(x1, spans[i].x);
+        x2 = plutovg_max(x2, spans[i].x + spans[i].len);
+    }
+
+    int y1 = spans[0].y;
+    int y2 = spans[count - 1].y + 1;
+    plutovg_rect_t rect = PLUTOVG_MAKE_RECT(x1, y1, x2 - x1, y2 - y1);
+    while(true) {
+        int index = -1;
+        for(int i = 0; i < canvas->num_damage_rects; i++) {
+            if(plutovg_rect_overlaps(&canvas->damage_rects[i], &rect)) {
+                index = i;
+                break;
+            }
+        }
+
+        if(index == -1 && canvas->num_damage_rects == PLUTOVG_MAX_DAMAGE_RECTS) {
+            float growth = 0.f;
+            for(int i = 0; i < canvas->num_damage_rects; i++) {
+                const plutovg_rect_t* damage = &canvas->damage_rects[i];
+                plutovg_rect_t united;
+                plutovg_rect_unite(&united, damage, &rect);
+                float area = united.w * united.h - damage->w * damage->h;
+                if(index == -1 || area < growth) {
+                    growth = area;
+                    index = i;
+                }
+            }
+        }
+
+        if(index == -1)
+            break;
+        plutovg_rect_unite(&rect, &rect, &canvas->damage_rects[index]);
+        canvas->damage_rects[index] = canvas->damage_rects[--canvas->num_damage_rects];
+    }
+
+    canvas->damage_rects[canvas->num_damage_rects++] = rect;
+}
+
+int plutovg_canvas_get_damage(const plutovg_canvas_t* canvas, plutovg_rect_t* rects, int max_rects)
+{
+    if(rects) {
+        int count = plutovg_min(max_rects, canvas->num_damage_rects);
+        for(int i = 0; i < count; i++) {
+            rects[i] = canvas->damage_rects[i];
+        }
+    }
+
+    return canvas->num_damage_rects;
+}
+
+void plutovg_canvas_get_damage_extents(const plutovg_canvas_t* canvas, plutovg_rect_t* extents)
+{
+    *extents = PLUTOVG_EMPTY_RECT;
+    for(int i = 0; i < canvas->num_damage_rects; i++) {
+        if(i == 0) {
+            *extents = canvas->damage_rects[i];
+        } else {
+            plutovg_rect_unite(extents, extents, &canvas->damage_rects[i]);
+        }
+    }
+}
+
+void plutovg_canvas_reset_damage(plutovg_canvas_t* canvas)
+{
+    canvas->num_damage_rects = 0;
+}
+
 void plutovg_canvas_clip_extents(plutovg_canvas_t* canvas, plutovg_rect_t* extents)
 {
     if(canvas->state->clipping) {
@@ -572,17 +965,48 @@ void plutovg_canvas_clip(plutovg_canvas_t* canvas)
 
 void plutovg_canvas_paint(plutovg_canvas_t* canvas)
 {
+    if(canvas->recording) {
+        plutovg_display_list_add(canvas->recording, PLUTOVG_COMMAND_TYPE_PAINT, canvas);
+        return;
+    }
+
     if(canvas->state->clipping) {
         plutovg_blend(canvas, &canvas->state->clip_spans);
     } else {
-        plutovg_span_buffer_init_rect(&canvas->clip_spans, 0, 0, canvas->surface->width, canvas->surface->height);
+        const plutovg_rect_t* rect = &canvas->tile_rect;
+        plutovg_span_buffer_init_rect(&canvas->clip_spans, (int)rect->x, (int)rect->y, (int)rect->w, (int)rect->h);
+        plutovg_blend(canvas, &canvas->clip_spans);
+    }
+}
+
+void plutovg_canvas_mask_surface(plutovg_canvas_t* canvas, const plutovg_surface_t* mask, float x, float y)
+{
+    if(canvas->recording) {
+        plutovg_command_t* command = plutovg_display_list_add(canvas->recording, PLUTOVG_COMMAND_TYPE_MASK, canvas);
+        command->mask = plutovg_surface_reference((plutovg_surface_t*)mask);
+        command->offset = PLUTOVG_MAKE_POINT(x, y);
+        return;
+    }
+
+    plutovg_matrix_t matrix = canvas->state->matrix;
+    plutovg_matrix_translate(&matrix, x, y);
+    plutovg_span_buffer_init_mask(&canvas->fill_spans, mask, &matrix, &canvas->tile_rect);
+    if(canvas->state->clipping) {
+        plutovg_span_buffer_intersect(&canvas->clip_spans, &canvas->fill_spans, &canvas->state->clip_spans);
         plutovg_blend(canvas, &canvas->clip_spans);
+    } else {
+        plutovg_blend(canvas, &canvas->fill_spans);
     }
 }
 
 void plutovg_canvas_fill_preserve(plutovg_canvas_t* canvas)
 {
-    plutovg_rasterize(&canvas->fill_spans, canvas->path, &canvas->state->matrix, &canvas->clip_rect, NULL, canvas->state->winding);
+    if(canvas->recording) {
+        plutovg_display_list_add(canvas->recording, PLUTOVG_COMMAND_TYPE_FILL, canvas);
+        return;
+    }
+
+    plutovg_rasterize(canvas->rasterizer, &canvas->fill_spans, canvas->path, &canvas->state->matrix, &canvas->clip_rect, &canvas->tile_rect, NULL, canvas->state->winding);
     if(canvas->state->clipping) {
         plutovg_span_buffer_intersect(&canvas->clip_spans, &canvas->fill_spans, &canvas->state->clip_spans);
         plutovg_blend(canvas, &canvas->clip_spans);
@@ -593,7 +1017,12 @@ void plutovg_canvas_fill_preserve(plutovg_canvas_t* canvas)
 
 void plutovg_canvas_stroke_preserve(plutovg_canvas_t* canvas)
 {
-    plutovg_rasterize(&canvas->fill_spans, canvas->path, &canvas->state->matrix, &canvas->clip_rect, &canvas->state->stroke, PLUTOVG_FILL_RULE_NON_ZERO);
+    if(canvas->recording) {
+        plutovg_display_list_add(canvas->recording, PLUTOVG_COMMAND_TYPE_STROKE, canvas);
+        return;
+    }
+
+    plutovg_rasterize(canvas->rasterizer, &canvas->fill_spans, canvas->path, &canvas->state->matrix, &canvas->clip_rect, &canvas->tile_rect, &canvas->state->stroke, PLUTOVG_FILL_RULE_NON_ZERO);
     if(canvas->state->clipping) {
         plutovg_span_buffer_intersect(&canvas->clip_spans, &canvas->fill_spans, &canvas->state->clip_spans);
         plutovg_blend(canvas, &canvas->clip_spans);
@@ -604,12 +1033,17 @@ void plutovg_canvas_stroke_preserve(plutovg_canvas_t* canvas)
 
 void plutovg_canvas_clip_preserve(plutovg_canvas_t* canvas)
 {
+    if(canvas->recording) {
+        plutovg_display_list_add(canvas->recording, PLUTOVG_COMMAND_TYPE_CLIP, canvas);
+        return;
+    }
+
     if(canvas->state->clipping) {
-        plutovg_rasterize(&canvas->fill_spans, canvas->path, &canvas->state->matrix, &canvas->clip_rect, NULL, canvas->state->winding);
+        plutovg_rasterize(canvas->rasterizer, &canvas->fill_spans, canvas->path, &canvas->state->matrix, &canvas->clip_rect, &canvas->tile_rect, NULL, canvas->state->winding);
         plutovg_span_buffer_intersect(&canvas->clip_spans, &canvas->fill_spans, &canvas->state->clip_spans);
         plutovg_span_buffer_copy(&canvas->state->clip_spans, &canvas->clip_spans);
     } else {
-        plutovg_rasterize(&canvas->state->clip_spans, canvas->path, &canvas->state->matrix, &canvas->clip_rect, NULL, canvas->state->winding);
+        plutovg_rasterize(canvas->rasterizer, &canvas->state->clip_spans, canvas->path, &canvas->state->matrix, &canvas->clip_rect, &canvas->tile_rect, NULL, canvas->state->winding);
         canvas->state->clipping = true;
     }
 }
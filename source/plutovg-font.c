@@ -5,6 +5,8 @@
 #include <assert.h>
 
 #define STBTT_STATIC
+#define STBTT_malloc(x, u) ((void)(u), plutovg_malloc(x))
+#define STBTT_free(x, u) ((void)(u), plutovg_free(x))
 #define STB_TRUETYPE_IMPLEMENTATION
 #include "plutovg-stb-truetype.h"
 
@@ -108,39 +110,6 @@ plutovg_codepoint_t plutovg_text_iterator_next(plutovg_text_iterator_t* it)
     return codepoint;
 }
 
-#if defined(_WIN32)
-
-#include <windows.h>
-
-typedef CRITICAL_SECTION plutovg_mutex_t;
-
-#define plutovg_mutex_init(mutex) InitializeCriticalSection(mutex)
-#define plutovg_mutex_lock(mutex) EnterCriticalSection(mutex)
-#define plutovg_mutex_unlock(mutex) LeaveCriticalSection(mutex)
-#define plutovg_mutex_destroy(mutex) DeleteCriticalSection(mutex)
-
-#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && defined(HAVE_THREADS_H) && !defined(__STDC_NO_THREADS__)
-
-#include <threads.h>
-
-typedef mtx_t plutovg_mutex_t;
-
-#define plutovg_mutex_init(mutex) mtx_init(mutex, mtx_plain | mtx_recursive)
-#define plutovg_mutex_lock(mutex) mtx_lock(mutex)
-#define plutovg_mutex_unlock(mutex) mtx_unlock(mutex)
-#define plutovg_mutex_destroy(mutex) mtx_destroy(mutex)
-
-#else
-
-typedef int plutovg_mutex_t;
-
-#define plutovg_mutex_init(mutex) ((void)(mutex))
-#define plutovg_mutex_lock(mutex) ((void)(mutex))
-#define plutovg_mutex_unlock(mutex) ((void)(mutex))
-#define plutovg_mutex_destroy(mutex) ((void)(mutex))
-
-#endif
-
 typedef struct plutovg_glyph {
     plutovg_codepoint_t codepoint;
     stbtt_vertex* vertices;
@@ -194,12 +163,12 @@ static void plutovg_glyph_cache_finish(plutovg_glyph_cache_t* cache, plutovg_fon
             while(glyph) {
                 plutovg_glyph_t* next = glyph->next;
                 stbtt_FreeShape(&face->info, glyph->vertices);
-                free(glyph);
+                plutovg_free(glyph);
                 glyph = next;
             }
         }
 
-        free(cache->glyphs);
+        plutovg_free(cache->glyphs);
         cache->glyphs = NULL;
         cache->capacity = 0;
         cache->size = 0;
@@ -216,7 +185,7 @@ static plutovg_glyph_t* plutovg_glyph_cache_get(plutovg_glyph_cache_t* cache, pl
 
     if(cache->glyphs == NULL) {
         assert(cache->size == 0);
-        cache->glyphs = calloc(GLYPH_CACHE_INIT_CAPACITY, sizeof(plutovg_glyph_t*));
+        cache->glyphs = plutovg_calloc(GLYPH_CACHE_INIT_CAPACITY, sizeof(plutovg_glyph_t*));
         cache->capacity = GLYPH_CACHE_INIT_CAPACITY;
     }
 
@@ -227,7 +196,7 @@ static plutovg_glyph_t* plutovg_glyph_cache_get(plutovg_glyph_cache_t* cache, pl
     }
 
     if(glyph == NULL) {
-        glyph = malloc(sizeof(plutovg_glyph_t));
+        glyph = plutovg_malloc(sizeof(plutovg_glyph_t));
         glyph->codepoint = codepoint;
         glyph->index = stbtt_FindGlyphIndex(&face->info, codepoint);
         glyph->nvertices = stbtt_GetGlyphShape(&face->info, glyph->index, &glyph->vertices);
@@ -242,7 +211,7 @@ static plutovg_glyph_t* plutovg_glyph_cache_get(plutovg_glyph_cache_t* cache, pl
 
         if(cache->size > (cache->capacity * 3 / 4)) {
             size_t newcapacity = cache->capacity << 1;
-            plutovg_glyph_t** newglyphs = calloc(newcapacity, sizeof(plutovg_glyph_t*));
+            plutovg_glyph_t** newglyphs = plutovg_calloc(newcapacity, sizeof(plutovg_glyph_t*));
 
             for(size_t i = 0; i < cache->capacity; ++i) {
                 plutovg_glyph_t* entry = cache->glyphs[i];
@@ -255,7 +224,7 @@ static plutovg_glyph_t* plutovg_glyph_cache_get(plutovg_glyph_cache_t* cache, pl
                 }
             }
 
-            free(cache->glyphs);
+            plutovg_free(cache->glyphs);
             cache->glyphs = newglyphs;
             cache->capacity = newcapacity;
         }
@@ -279,7 +248,7 @@ plutovg_font_face_t* plutovg_font_face_load_from_file(const char* filename, int
         return NULL;
     }
 
-    void* data = malloc(length);
+    void* data = plutovg_malloc(length);
     if(data == NULL) {
         fclose(fp);
         return NULL;
@@ -290,11 +259,11 @@ plutovg_font_face_t* plutovg_font_face_load_from_file(const char* filename, int
     fclose(fp);
 
     if(nread != length) {
-        free(data);
+        plutovg_free(data);
         return NULL;
     }
 
-    return plutovg_font_face_load_from_data(data, length, ttcindex, free, data);
+    return plutovg_font_face_load_from_data(data, length, ttcindex, plutovg_free, data);
 }
 
 plutovg_font_face_t* plutovg_font_face_load_from_data(const void* data, unsigned int length, int ttcindex, plutovg_destroy_func_t destroy_func, void* closure)
@@ -307,7 +276,7 @@ plutovg_font_face_t* plutovg_font_face_load_from_data(const void* data, unsigned
         return NULL;
     }
 
-    plutovg_font_face_t* face = malloc(sizeof(plutovg_font_face_t));
+    plutovg_font_face_t* face = plutovg_malloc(sizeof(plutovg_font_face_t));
     plutovg_init_reference(face);
     face->info = info;
     stbtt_GetFontVMetrics(&face->info, &face->ascent, &face->descent, &face->line_gap);
@@ -332,7 +301,7 @@ void plutovg_font_face_destroy(plutovg_font_face_t* face)
         plutovg_mutex_destroy(&face->mutex);
         if(face->destroy_func)
             face->destroy_func(face->closure);
-        free(face);
+        plutovg_free(face);
     }
 }
 
@@ -527,7 +496,7 @@ struct plutovg_font_face_cache {
 
 plutovg_font_face_cache_t* plutovg_font_face_cache_create(void)
 {
-    plutovg_font_face_cache_t* cache = malloc(sizeof(plutovg_font_face_cache_t));
+    plutovg_font_face_cache_t* cache = plutovg_malloc(sizeof(plutovg_font_face_cache_t));
     plutovg_init_reference(cache);
     plutovg_mutex_init(&cache->mutex);
     cache->entries = NULL;
@@ -548,7 +517,7 @@ void plutovg_font_face_cache_destroy(plutovg_font_face_cache_t* cache)
     if(plutovg_destroy_reference(cache)) {
         plutovg_font_face_cache_reset(cache);
         plutovg_mutex_destroy(&cache->mutex);
-        free(cache);
+        plutovg_free(cache);
     }
 }
 
@@ -566,12 +535,12 @@ void plutovg_font_face_cache_reset(plutovg_font_face_cache_t* cache)
         do {
             plutovg_font_face_entry_t* next = entry->next;
             plutovg_font_face_destroy(entry->face);
-            free(entry);
+            plutovg_free(entry);
             entry = next;
         } while(entry);
     }
 
-    free(cache->entries);
+    plutovg_free(cache->entries);
     cache->entries = NULL;
     cache->size = 0;
     cache->capacity = 0;
@@ -594,7 +563,7 @@ static void plutovg_font_face_cache_add_entry(plutovg_font_face_cache_t* cache,
 
     if(cache->size >= cache->capacity) {
         cache->capacity = cache->capacity == 0 ? 8 : cache->capacity << 2;
-        cache->entries = realloc(cache->entries, cache->capacity * sizeof(plutovg_font_face_entry_t*));
+        cache->entries = plutovg_realloc(cache->entries, cache->capacity * sizeof(plutovg_font_face_entry_t*));
     }
 
     entry->next = NULL;
@@ -610,7 +579,7 @@ void plutovg_font_face_cache_add(plutovg_font_face_cache_t* cache, const char* f
     if(family == NULL) family = "";
     size_t family_length = strlen(family) + 1;
 
-    plutovg_font_face_entry_t* entry = malloc(family_length + sizeof(plutovg_font_face_entry_t));
+    plutovg_font_face_entry_t* entry = plutovg_malloc(family_length + sizeof(plutovg_font_face_entry_t));
     entry->face = plutovg_font_face_reference(face);
     entry->family = (char*)(entry + 1);
     memcpy(entry->family, family, family_length);
@@ -828,7 +797,7 @@ int plutovg_font_face_cache_load_file(plutovg_font_face_cache_t* cache, const ch
         size_t filename_length = strlen(filename) + 1;
         size_t max_family_length = (unicode_family_name ? 3 * (family_length / 2) : family_length * 3) + 1;
 
-        plutovg_font_face_entry_t* entry = malloc(max_family_length + filename_length + sizeof(plutovg_font_face_entry_t));
+        plutovg_font_face_entry_t* entry = plutovg_malloc(max_family_length + filename_length + sizeof(plutovg_font_face_entry_t));
         entry->family = (char*)(entry + 1);
         entry->filename = entry->family + max_family_length;
         memcpy(entry->filename, filename, filename_length);
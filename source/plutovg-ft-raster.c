@@ -57,6 +57,7 @@
 
 #include "plutovg-ft-raster.h"
 #include "plutovg-ft-math.h"
+#include "plutovg-utils.h"
 
 #include <setjmp.h>
 
@@ -173,6 +174,7 @@ PVG_FT_END_STMNT
 
     PVG_FT_Outline  outline;
     PVG_FT_BBox     clip_box;
+    TPos            band_min, band_max;
 
     int clip_flags;
     int clipping;
@@ -1695,6 +1697,14 @@ void PVG_FT_Outline_Get_CBox(const PVG_FT_Outline* outline, PVG_FT_BBox* acbox)
     clip->xMax = (ras.max_ex + 1) * ONE_PIXEL;
     clip->yMax = (ras.max_ey + 1) * ONE_PIXEL;
 
+    /* drop the rows outside of the band once the outline clipping is set */
+    if ( ras.min_ey < ras.band_min )
+      ras.min_ey = ras.band_min;
+    if ( ras.max_ey > ras.band_max )
+      ras.max_ey = ras.band_max;
+    if ( ras.min_ey >= ras.max_ey )
+      return 0;
+
     ras.count_ex = ras.max_ex - ras.min_ex;
     ras.count_ey = ras.max_ey - ras.min_ey;
 
@@ -1852,6 +1862,17 @@ void PVG_FT_Outline_Get_CBox(const PVG_FT_Outline* outline, PVG_FT_BBox* acbox)
       ras.clip_box.yMax =  (1 << 23) - 1;
     }
 
+    if ( params->flags & PVG_FT_RASTER_FLAG_BAND )
+    {
+      ras.band_min = params->band_min;
+      ras.band_max = params->band_max;
+    }
+    else
+    {
+      ras.band_min = -(1 << 23);
+      ras.band_max =  (1 << 23) - 1;
+    }
+
     gray_init_cells( RAS_VAR_ buffer, buffer_size );
 
     ras.outline   = *outline;
@@ -1866,23 +1887,34 @@ void PVG_FT_Outline_Get_CBox(const PVG_FT_Outline* outline, PVG_FT_BBox* acbox)
   }
 
   void
-  PVG_FT_Raster_Render(const PVG_FT_Raster_Params *params)
+  PVG_FT_Raster_Render(const PVG_FT_Raster_Params *params, PVG_FT_Raster_Pool *pool)
   {
       char stack[PVG_FT_MINIMUM_POOL_SIZE];
-      size_t length = PVG_FT_MINIMUM_POOL_SIZE;
+      void* buffer = stack;
+      long length = PVG_FT_MINIMUM_POOL_SIZE;
+      if(pool && pool->size > length) {
+          buffer = pool->buffer;
+          length = pool->size;
+      }
 
       TWorker worker;
       worker.skip_spans = 0;
       int rendered_spans = 0;
-      int error = gray_raster_render(&worker, stack, length, params);
+      int error = gray_raster_render(&worker, buffer, length, params);
       while(error == ErrRaster_OutOfMemory) {
           if(worker.skip_spans < 0)
               rendered_spans += -worker.skip_spans;
           worker.skip_spans = rendered_spans;
           length *= 2;
-          void* heap = malloc(length);
+          void* heap = plutovg_malloc(length);
           error = gray_raster_render(&worker, heap, length, params);
-          free(heap);
+          if(pool) {
+              plutovg_free(pool->buffer);
+              pool->buffer = heap;
+              pool->size = length;
+          } else {
+              plutovg_free(heap);
+          }
       }
   }
 
@@ -347,10 +347,16 @@ typedef void
 /*                              in direct rendering mode where all spans */
 /*                              are generated if no clipping box is set. */
 /*                                                                       */
+/*    PVG_FT_RASTER_FLAG_BAND    :: If set, only the rows from `band_min'    */
+/*                              up to `band_max' are generated.  Unlike  */
+/*                              the clipping box, this does not change   */
+/*                              the coverage of the rows it keeps.       */
+/*                                                                       */
 #define PVG_FT_RASTER_FLAG_DEFAULT  0x0
 #define PVG_FT_RASTER_FLAG_AA       0x1
 #define PVG_FT_RASTER_FLAG_DIRECT   0x2
 #define PVG_FT_RASTER_FLAG_CLIP     0x4
+#define PVG_FT_RASTER_FLAG_BAND     0x8
 
 
 /*************************************************************************/
@@ -386,6 +392,11 @@ typedef void
 /*                   should be expressed in _integer_ pixels (and not in */
 /*                   26.6 fixed-point units).                            */
 /*                                                                       */
+/*    band_min    :: The first row generated with the band flag.         */
+/*                                                                       */
+/*    band_max    :: The row after the last one generated with the band  */
+/*                   flag.                                               */
+/*                                                                       */
 /* <Note>                                                                */
 /*    An anti-aliased glyph bitmap is drawn if the @PVG_FT_RASTER_FLAG_AA    */
 /*    bit flag is set in the `flags' field, otherwise a monochrome       */
@@ -410,11 +421,36 @@ typedef struct  PVG_FT_Raster_Params_
     PVG_FT_SpanFunc          gray_spans;
     void*                   user;
     PVG_FT_BBox              clip_box;
+    PVG_FT_Pos               band_min;
+    PVG_FT_Pos               band_max;
 
 } PVG_FT_Raster_Params;
 
 
+/*************************************************************************/
+/*                                                                       */
+/* <Struct>                                                              */
+/*    PVG_FT_Raster_Pool                                                 */
+/*                                                                       */
+/* <Description>                                                         */
+/*    A render pool that outlives a single call to the renderer.  When   */
+/*    the default pool is too small for an outline, the larger pool is   */
+/*    kept here and reused by the next calls.                            */
+/*                                                                       */
+/* <Fields>                                                              */
+/*    buffer      :: The pool memory, or NULL.                           */
+/*                                                                       */
+/*    size        :: The size of `buffer' in bytes.                      */
+/*                                                                       */
+typedef struct  PVG_FT_Raster_Pool_
+{
+    void*                   buffer;
+    long                    size;
+
+} PVG_FT_Raster_Pool;
+
+
 void
-PVG_FT_Raster_Render(const PVG_FT_Raster_Params *params);
+PVG_FT_Raster_Render(const PVG_FT_Raster_Params *params, PVG_FT_Raster_Pool *pool);
 
 #endif // PLUTOVG_FT_RASTER_H
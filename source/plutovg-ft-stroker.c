@@ -18,6 +18,7 @@
 
 #include "plutovg-ft-stroker.h"
 #include "plutovg-ft-math.h"
+#include "plutovg-utils.h"
 
 #include <assert.h>
 #include <stdlib.h>
@@ -250,10 +251,10 @@ static PVG_FT_Error ft_stroke_border_grow(PVG_FT_StrokeBorder border,
 
         while (cur_max < new_max) cur_max += (cur_max >> 1) + 16;
 
-        border->points = (PVG_FT_Vector*)realloc(border->points,
+        border->points = (PVG_FT_Vector*)plutovg_realloc(border->points,
                                                 cur_max * sizeof(PVG_FT_Vector));
         border->tags =
-            (PVG_FT_Byte*)realloc(border->tags, cur_max * sizeof(PVG_FT_Byte));
+            (PVG_FT_Byte*)plutovg_realloc(border->tags, cur_max * sizeof(PVG_FT_Byte));
 
         if (!border->points || !border->tags) goto Exit;
 
@@ -503,8 +504,8 @@ static void ft_stroke_border_reset(PVG_FT_StrokeBorder border)
 
 static void ft_stroke_border_done(PVG_FT_StrokeBorder border)
 {
-    free(border->points);
-    free(border->tags);
+    plutovg_free(border->points);
+    plutovg_free(border->tags);
 
     border->num_points = 0;
     border->max_points = 0;
@@ -635,7 +636,7 @@ PVG_FT_Error PVG_FT_Stroker_New(PVG_FT_Stroker* astroker)
     PVG_FT_Error   error = 0; /* assigned in PVG_FT_NEW */
     PVG_FT_Stroker stroker = NULL;
 
-    stroker = (PVG_FT_StrokerRec*)calloc(1, sizeof(PVG_FT_StrokerRec));
+    stroker = (PVG_FT_StrokerRec*)plutovg_calloc(1, sizeof(PVG_FT_StrokerRec));
     if (stroker) {
         ft_stroke_border_init(&stroker->borders[0]);
         ft_stroke_border_init(&stroker->borders[1]);
@@ -684,7 +685,7 @@ void PVG_FT_Stroker_Done(PVG_FT_Stroker stroker)
         ft_stroke_border_done(&stroker->borders[0]);
         ft_stroke_border_done(&stroker->borders[1]);
 
-        free(stroker);
+        plutovg_free(stroker);
     }
 }
 
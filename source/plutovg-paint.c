@@ -384,7 +384,7 @@ int plutovg_color_parse(plutovg_color_t* color, const char* data, int length)
 
 static void* plutovg_paint_create(plutovg_paint_type_t type, size_t size)
 {
-    plutovg_paint_t* paint = malloc(size);
+    plutovg_paint_t* paint = plutovg_malloc(size);
     plutovg_init_reference(paint);
     paint->type = type;
     return paint;
@@ -418,6 +418,8 @@ static plutovg_gradient_paint_t* plutovg_gradient_create(plutovg_gradient_type_t
     gradient->matrix = matrix ? *matrix : PLUTOVG_IDENTITY_MATRIX;
     gradient->stops = (plutovg_gradient_stop_t*)(gradient + 1);
     gradient->nstops = nstops;
+    gradient->colortable = NULL;
+    plutovg_mutex_init(&gradient->mutex);
 
     float prev_offset = 0.f;
     for(int i = 0; i < nstops; ++i) {
@@ -462,6 +464,8 @@ plutovg_paint_t* plutovg_paint_create_texture(plutovg_surface_t* surface, plutov
     texture->opacity = plutovg_clamp(opacity, 0.f, 1.f);
     texture->matrix = matrix ? *matrix : PLUTOVG_IDENTITY_MATRIX;
     texture->surface = plutovg_surface_reference(surface);
+    texture->tilecache = NULL;
+    plutovg_mutex_init(&texture->mutex);
     return &texture->base;
 }
 
@@ -477,9 +481,15 @@ void plutovg_paint_destroy(plutovg_paint_t* paint)
         if(paint->type == PLUTOVG_PAINT_TYPE_TEXTURE) {
             plutovg_texture_paint_t* texture = (plutovg_texture_paint_t*)(paint);
             plutovg_surface_destroy(texture->surface);
+            plutovg_tile_cache_destroy(texture->tilecache);
+            plutovg_mutex_destroy(&texture->mutex);
+        } else if(paint->type == PLUTOVG_PAINT_TYPE_GRADIENT) {
+            plutovg_gradient_paint_t* gradient = (plutovg_gradient_paint_t*)(paint);
+            plutovg_color_table_destroy(gradient->colortable);
+            plutovg_mutex_destroy(&gradient->mutex);
         }
 
-        free(paint);
+        plutovg_free(paint);
     }
 }
 
@@ -37,7 +37,7 @@ plutovg_path_command_t plutovg_path_iterator_next(plutovg_path_iterator_t* it, p
 
 plutovg_path_t* plutovg_path_create(void)
 {
-    plutovg_path_t* path = malloc(sizeof(plutovg_path_t));
+    plutovg_path_t* path = plutovg_malloc(sizeof(plutovg_path_t));
     plutovg_init_reference(path);
     path->num_points = 0;
     path->num_contours = 0;
@@ -57,7 +57,7 @@ void plutovg_path_destroy(plutovg_path_t* path)
 {
     if(plutovg_destroy_reference(path)) {
         plutovg_array_destroy(path->elements);
-        free(path);
+        plutovg_free(path);
     }
 }
 
@@ -649,11 +649,17 @@ plutovg_path_t* plutovg_path_clone_flatten(const plutovg_path_t* path)
     return clone;
 }
 
+void plutovg_path_dash(plutovg_path_t* dashed, const plutovg_path_t* path, float offset, const float* dashes, int ndashes)
+{
+    plutovg_path_reset(dashed);
+    plutovg_path_reserve(dashed, path->elements.size + path->num_curves * 32);
+    plutovg_path_traverse_dashed(path, offset, dashes, ndashes, clone_traverse_func, dashed);
+}
+
 plutovg_path_t* plutovg_path_clone_dashed(const plutovg_path_t* path, float offset, const float* dashes, int ndashes)
 {
     plutovg_path_t* clone = plutovg_path_create();
-    plutovg_path_reserve(clone, path->elements.size + path->num_curves * 32);
-    plutovg_path_traverse_dashed(path, offset, dashes, ndashes, clone_traverse_func, clone);
+    plutovg_path_dash(clone, path, offset, dashes, ndashes);
     return clone;
 }
 
@@ -0,0 +1,635 @@
+#include "plutovg-private.h"
+#include "plutovg-utils.h"
+
+#include <assert.h>
+
+/*
+ * A staged raster pipeline: every paint and operator combination is expressed as a
+ * short list of stages that each process PIPELINE_LANES pixels held in float registers.
+ * The stages are chosen once per plutovg_blend call and run over every span.
+ */
+
+#define PIPELINE_LANES 8
+#define PIPELINE_MAX_STAGES 12
+
+typedef struct {
+    float x[PIPELINE_LANES];
+    float y[PIPELINE_LANES];
+    float t[PIPELINE_LANES];
+    float r[PIPELINE_LANES];
+    float g[PIPELINE_LANES];
+    float b[PIPELINE_LANES];
+    float a[PIPELINE_LANES];
+    float dr[PIPELINE_LANES];
+    float dg[PIPELINE_LANES];
+    float db[PIPELINE_LANES];
+    float da[PIPELINE_LANES];
+    float coverage[PIPELINE_LANES];
+    void* dest;
+    int count;
+    int px;
+    int py;
+} pipeline_registers_t;
+
+typedef void(*pipeline_stage_function_t)(pipeline_registers_t* regs, const void* context);
+
+typedef struct {
+    pipeline_stage_function_t function;
+    const void* context;
+} pipeline_stage_t;
+
+typedef struct {
+    pipeline_stage_t stages[PIPELINE_MAX_STAGES];
+    int nstages;
+} pipeline_t;
+
+static void pipeline_append(pipeline_t* pipeline, pipeline_stage_function_t function, const void* context)
+{
+    assert(pipeline->nstages < PIPELINE_MAX_STAGES);
+    pipeline->stages[pipeline->nstages].function = function;
+    pipeline->stages[pipeline->nstages].context = context;
+    pipeline->nstages++;
+}
+
+static void pipeline_run(const pipeline_t* pipeline, plutovg_surface_t* surface, float coverage_scale, const plutovg_span_buffer_t* span_buffer)
+{
+    pipeline_registers_t regs;
+    const int bpp = plutovg_format_bytes_per_pixel(surface->format);
+    int count = span_buffer->spans.size;
+    const plutovg_span_t* spans = span_buffer->spans.data;
+    while(count--) {
+        unsigned char* target = plutovg_surface_address(surface, spans->x, spans->y);
+        const float coverage = spans->coverage * coverage_scale / 255.f;
+        regs.py = spans->y;
+        int end = spans->x + spans->len;
+        for(int x = spans->x; x < end; x += PIPELINE_LANES) {
+            for(int i = 0; i < PIPELINE_LANES; i++)
+                regs.coverage[i] = coverage;
+            regs.px = x;
+            regs.dest = target + (x - spans->x) * bpp;
+            regs.count = plutovg_min(PIPELINE_LANES, end - x);
+            for(int i = 0; i < pipeline->nstages; i++) {
+                pipeline->stages[i].function(&regs, pipeline->stages[i].context);
+            }
+        }
+
+        ++spans;
+    }
+}
+
+static inline void unpack_pixel(uint32_t pixel, float* r, float* g, float* b, float* a)
+{
+    *a = (int)((pixel >> 24) & 0xff) * (1.f / 255.f);
+    *r = (int)((pixel >> 16) & 0xff) * (1.f / 255.f);
+    *g = (int)((pixel >> 8) & 0xff) * (1.f / 255.f);
+    *b = (int)((pixel >> 0) & 0xff) * (1.f / 255.f);
+}
+
+static inline uint32_t pack_channel(float value)
+{
+    int channel = (int)(value * 255.f + 0.5f);
+    channel = channel < 0 ? 0 : channel;
+    channel = channel > 255 ? 255 : channel;
+    return (uint32_t)channel;
+}
+
+static void stage_seed(pipeline_registers_t* regs, const void* context)
+{
+    for(int i = 0; i < PIPELINE_LANES; i++) {
+        regs->x[i] = regs->px + i + 0.5f;
+        regs->y[i] = regs->py + 0.5f;
+    }
+}
+
+static void stage_transform(pipeline_registers_t* regs, const void* context)
+{
+    const plutovg_matrix_t* matrix = context;
+    for(int i = 0; i < PIPELINE_LANES; i++) {
+        float x = regs->x[i];
+        float y = regs->y[i];
+        regs->x[i] = matrix->a * x + matrix->c * y + matrix->e;
+        regs->y[i] = matrix->b * x + matrix->d * y + matrix->f;
+    }
+}
+
+static void stage_solid(pipeline_registers_t* regs, const void* context)
+{
+    const float* color = context;
+    for(int i = 0; i < PIPELINE_LANES; i++) {
+        regs->r[i] = color[0];
+        regs->g[i] = color[1];
+        regs->b[i] = color[2];
+        regs->a[i] = color[3];
+    }
+}
+
+typedef struct {
+    float dx;
+    float dy;
+    float off;
+} linear_gradient_context_t;
+
+static void stage_linear_gradient(pipeline_registers_t* regs, const void* context)
+{
+    const linear_gradient_context_t* linear = context;
+    for(int i = 0; i < PIPELINE_LANES; i++) {
+        regs->t[i] = linear->dx * regs->x[i] + linear->dy * regs->y[i] + linear->off;
+    }
+}
+
+typedef struct {
+    float fx;
+    float fy;
+    float fr;
+    float dx;
+    float dy;
+    float dr;
+    float sqrfr;
+    float a;
+    bool extended;
+} radial_gradient_context_t;
+
+static void stage_radial_gradient(pipeline_registers_t* regs, const void* context)
+{
+    const radial_gradient_context_t* radial = context;
+    if(radial->a == 0.f) {
+        for(int i = 0; i < PIPELINE_LANES; i++)
+            regs->t[i] = NAN;
+        return;
+    }
+
+    const float inv_a = 1.f / (2.f * radial->a);
+    for(int i = 0; i < PIPELINE_LANES; i++) {
+        float rx = regs->x[i] - radial->fx;
+        float ry = regs->y[i] - radial->fy;
+        float b = 2.f * (radial->dr * radial->fr + rx * radial->dx + ry * radial->dy);
+        float det = b * b - 4.f * radial->a * (radial->sqrfr - (rx * rx + ry * ry));
+        float t = (sqrtf(det) - b) * inv_a;
+        if(radial->extended) {
+            if(det < 0.f || radial->fr + radial->dr * t < 0.f) {
+                t = NAN;
+            }
+        } else if(isnan(t)) {
+            t = 0.f;
+        }
+
+        regs->t[i] = t;
+    }
+}
+
+static void stage_spread_pad(pipeline_registers_t* regs, const void* context)
+{
+    for(int i = 0; i < PIPELINE_LANES; i++) {
+        float t = regs->t[i];
+        regs->t[i] = t < 0.f ? 0.f : t > 1.f ? 1.f : t;
+    }
+}
+
+static void stage_spread_repeat(pipeline_registers_t* regs, const void* context)
+{
+    for(int i = 0; i < PIPELINE_LANES; i++) {
+        regs->t[i] = regs->t[i] - floorf(regs->t[i]);
+    }
+}
+
+static void stage_spread_reflect(pipeline_registers_t* regs, const void* context)
+{
+    for(int i = 0; i < PIPELINE_LANES; i++) {
+        float t = regs->t[i] - 2.f * floorf(regs->t[i] * 0.5f);
+        regs->t[i] = t > 1.f ? 2.f - t : t;
+    }
+}
+
+typedef struct {
+    int nstops;
+    const float* offsets;
+    const float* colors;
+} gradient_stops_context_t;
+
+static void stage_gradient_stops(pipeline_registers_t* regs, const void* context)
+{
+    const gradient_stops_context_t* stops = context;
+    const int last = stops->nstops - 1;
+    for(int i = 0; i < PIPELINE_LANES; i++) {
+        float t = regs->t[i];
+        if(isnan(t)) {
+            regs->r[i] = regs->g[i] = regs->b[i] = regs->a[i] = 0.f;
+            continue;
+        }
+
+        const float* color;
+        if(t <= stops->offsets[0]) {
+            color = stops->colors;
+        } else if(t >= stops->offsets[last]) {
+            color = stops->colors + 4 * last;
+        } else {
+            int k = 0;
+            while(t >= stops->offsets[k + 1])
+                ++k;
+            const float* c0 = stops->colors + 4 * k;
+            const float* c1 = c0 + 4;
+            float f = (t - stops->offsets[k]) / (stops->offsets[k + 1] - stops->offsets[k]);
+            regs->r[i] = c0[0] + (c1[0] - c0[0]) * f;
+            regs->g[i] = c0[1] + (c1[1] - c0[1]) * f;
+            regs->b[i] = c0[2] + (c1[2] - c0[2]) * f;
+            regs->a[i] = c0[3] + (c1[3] - c0[3]) * f;
+            continue;
+        }
+
+        regs->r[i] = color[0];
+        regs->g[i] = color[1];
+        regs->b[i] = color[2];
+        regs->a[i] = color[3];
+    }
+}
+
+typedef struct {
+    const uint8_t* data;
+    int width;
+    int height;
+    int stride;
+    bool clip;
+} texture_context_t;
+
+static inline uint32_t texture_pixel(const texture_context_t* texture, int x, int y)
+{
+    return ((const uint32_t*)(texture->data + (ptrdiff_t)y * texture->stride))[x];
+}
+
+static inline int texture_wrap(int value, int size)
+{
+    value %= size;
+    return value < 0 ? value + size : value;
+}
+
+static void stage_texture_plain(pipeline_registers_t* regs, const void* context)
+{
+    const texture_context_t* texture = context;
+    for(int i = 0; i < PIPELINE_LANES; i++) {
+        int x = (int)floorf(regs->x[i]);
+        int y = (int)floorf(regs->y[i]);
+        uint32_t pixel = 0;
+        if(x >= 0 && x < texture->width && y >= 0 && y < texture->height) {
+            pixel = texture_pixel(texture, x, y);
+        } else if(texture->clip) {
+            regs->coverage[i] = 0.f;
+        }
+
+        unpack_pixel(pixel, &regs->r[i], &regs->g[i], &regs->b[i], &regs->a[i]);
+    }
+}
+
+static void stage_texture_tiled(pipeline_registers_t* regs, const void* context)
+{
+    const texture_context_t* texture = context;
+    for(int i = 0; i < PIPELINE_LANES; i++) {
+        int x = texture_wrap((int)floorf(regs->x[i]), texture->width);
+        int y = texture_wrap((int)floorf(regs->y[i]), texture->height);
+        unpack_pixel(texture_pixel(texture, x, y), &regs->r[i], &regs->g[i], &regs->b[i], &regs->a[i]);
+    }
+}
+
+static inline uint32_t texture_pixel_or_transparent(const texture_context_t* texture, int x, int y)
+{
+    if(x < 0 || x >= texture->width || y < 0 || y >= texture->height)
+        return 0;
+    return texture_pixel(texture, x, y);
+}
+
+static inline void texture_bilinear(pipeline_registers_t* regs, int i, uint32_t ptl, uint32_t ptr, uint32_t pbl, uint32_t pbr, float wx, float wy)
+{
+    float tl[4], tr[4], bl[4], br[4];
+    unpack_pixel(ptl, &tl[0], &tl[1], &tl[2], &tl[3]);
+    unpack_pixel(ptr, &tr[0], &tr[1], &tr[2], &tr[3]);
+    unpack_pixel(pbl, &bl[0], &bl[1], &bl[2], &bl[3]);
+    unpack_pixel(pbr, &br[0], &br[1], &br[2], &br[3]);
+
+    float c[4];
+    for(int k = 0; k < 4; k++) {
+        float top = tl[k] + (tr[k] - tl[k]) * wx;
+        float bottom = bl[k] + (br[k] - bl[k]) * wx;
+        c[k] = top + (bottom - top) * wy;
+    }
+
+    regs->r[i] = c[0];
+    regs->g[i] = c[1];
+    regs->b[i] = c[2];
+    regs->a[i] = c[3];
+}
+
+static void stage_texture_plain_bilinear(pipeline_registers_t* regs, const void* context)
+{
+    const texture_context_t* texture = context;
+    for(int i = 0; i < PIPELINE_LANES; i++) {
+        float fx = regs->x[i] - 0.5f;
+        float fy = regs->y[i] - 0.5f;
+        float x0 = floorf(fx);
+        float y0 = floorf(fy);
+
+        int x1 = (int)x0;
+        int y1 = (int)y0;
+        texture_bilinear(regs, i, texture_pixel_or_transparent(texture, x1, y1), texture_pixel_or_transparent(texture, x1 + 1, y1),
+                         texture_pixel_or_transparent(texture, x1, y1 + 1), texture_pixel_or_transparent(texture, x1 + 1, y1 + 1), fx - x0, fy - y0);
+    }
+}
+
+static void stage_texture_tiled_bilinear(pipeline_registers_t* regs, const void* context)
+{
+    const texture_context_t* texture = context;
+    for(int i = 0; i < PIPELINE_LANES; i++) {
+        float fx = regs->x[i] - 0.5f;
+        float fy = regs->y[i] - 0.5f;
+        float x0 = floorf(fx);
+        float y0 = floorf(fy);
+
+        int x1 = texture_wrap((int)x0, texture->width);
+        int y1 = texture_wrap((int)y0, texture->height);
+        int x2 = (x1 + 1) % texture->width;
+        int y2 = (y1 + 1) % texture->height;
+        texture_bilinear(regs, i, texture_pixel(texture, x1, y1), texture_pixel(texture, x2, y1),
+                         texture_pixel(texture, x1, y2), texture_pixel(texture, x2, y2), fx - x0, fy - y0);
+    }
+}
+
+static void stage_load_dest(pipeline_registers_t* regs, const void* context)
+{
+    const uint32_t* pixels = regs->dest;
+    uint32_t tail[PIPELINE_LANES] = {0};
+    if(regs->count < PIPELINE_LANES) {
+        memcpy(tail, regs->dest, regs->count * sizeof(uint32_t));
+        pixels = tail;
+    }
+
+    for(int i = 0; i < PIPELINE_LANES; i++) {
+        unpack_pixel(pixels[i], &regs->dr[i], &regs->dg[i], &regs->db[i], &regs->da[i]);
+    }
+}
+
+static void stage_load_dest_a8(pipeline_registers_t* regs, const void* context)
+{
+    const uint8_t* pixels = regs->dest;
+    for(int i = 0; i < PIPELINE_LANES; i++) {
+        regs->dr[i] = regs->dg[i] = regs->db[i] = 0.f;
+        regs->da[i] = i < regs->count ? pixels[i] * (1.f / 255.f) : 0.f;
+    }
+}
+
+static void stage_load_dest_xrgb(pipeline_registers_t* regs, const void* context)
+{
+    stage_load_dest(regs, context);
+    for(int i = 0; i < PIPELINE_LANES; i++) {
+        regs->da[i] = 1.f;
+    }
+}
+
+static void stage_load_dest_rgb565(pipeline_registers_t* regs, const void* context)
+{
+    const uint16_t* pixels = regs->dest;
+    for(int i = 0; i < PIPELINE_LANES; i++) {
+        uint32_t pixel = i < regs->count ? plutovg_rgb565_to_argb(pixels[i]) : 0;
+        unpack_pixel(pixel, &regs->dr[i], &regs->dg[i], &regs->db[i], &regs->da[i]);
+    }
+}
+
+/* Every Porter-Duff operator is src * src_factor + dest * dest_factor. */
+#define PIPELINE_BLEND_STAGE(name, src_factor, dest_factor) \
+    static void stage_blend_##name(pipeline_registers_t* regs, const void* context) \
+    { \
+        for(int i = 0; i < PIPELINE_LANES; i++) { \
+            const float sa = regs->a[i]; \
+            const float da = regs->da[i]; \
+            const float fs = (src_factor); \
+            const float fd = (dest_factor); \
+            (void)sa; \
+            (void)da; \
+            regs->r[i] = regs->r[i] * fs + regs->dr[i] * fd; \
+            regs->g[i] = regs->g[i] * fs + regs->dg[i] * fd; \
+            regs->b[i] = regs->b[i] * fs + regs->db[i] * fd; \
+            regs->a[i] = regs->a[i] * fs + regs->da[i] * fd; \
+        } \
+    }
+
+PIPELINE_BLEND_STAGE(clear, 0.f, 0.f)
+PIPELINE_BLEND_STAGE(source, 1.f, 0.f)
+PIPELINE_BLEND_STAGE(destination, 0.f, 1.f)
+PIPELINE_BLEND_STAGE(source_over, 1.f, 1.f - sa)
+PIPELINE_BLEND_STAGE(destination_over, 1.f - da, 1.f)
+PIPELINE_BLEND_STAGE(source_in, da, 0.f)
+PIPELINE_BLEND_STAGE(destination_in, 0.f, sa)
+PIPELINE_BLEND_STAGE(source_out, 1.f - da, 0.f)
+PIPELINE_BLEND_STAGE(destination_out, 0.f, 1.f - sa)
+PIPELINE_BLEND_STAGE(source_atop, da, 1.f - sa)
+PIPELINE_BLEND_STAGE(destination_atop, 1.f - da, sa)
+PIPELINE_BLEND_STAGE(xor, 1.f - da, 1.f - sa)
+
+static const pipeline_stage_function_t blend_stage_table[] = {
+    stage_blend_clear,
+    stage_blend_source,
+    stage_blend_destination,
+    stage_blend_source_over,
+    stage_blend_destination_over,
+    stage_blend_source_in,
+    stage_blend_destination_in,
+    stage_blend_source_out,
+    stage_blend_destination_out,
+    stage_blend_source_atop,
+    stage_blend_destination_atop,
+    stage_blend_xor
+};
+
+static void stage_lerp_coverage(pipeline_registers_t* regs, const void* context)
+{
+    for(int i = 0; i < PIPELINE_LANES; i++) {
+        const float coverage = regs->coverage[i];
+        regs->r[i] = regs->dr[i] + (regs->r[i] - regs->dr[i]) * coverage;
+        regs->g[i] = regs->dg[i] + (regs->g[i] - regs->dg[i]) * coverage;
+        regs->b[i] = regs->db[i] + (regs->b[i] - regs->db[i]) * coverage;
+        regs->a[i] = regs->da[i] + (regs->a[i] - regs->da[i]) * coverage;
+    }
+}
+
+static void stage_store(pipeline_registers_t* regs, const void* context)
+{
+    uint32_t tail[PIPELINE_LANES];
+    uint32_t* pixels = regs->count < PIPELINE_LANES ? tail : regs->dest;
+    for(int i = 0; i < PIPELINE_LANES; i++) {
+        pixels[i] = (pack_channel(regs->a[i]) << 24) | (pack_channel(regs->r[i]) << 16) | (pack_channel(regs->g[i]) << 8) | pack_channel(regs->b[i]);
+    }
+
+    if(pixels == tail) {
+        memcpy(regs->dest, tail, regs->count * sizeof(uint32_t));
+    }
+}
+
+static void stage_store_a8(pipeline_registers_t* regs, const void* context)
+{
+    uint8_t* pixels = regs->dest;
+    for(int i = 0; i < regs->count; i++) {
+        pixels[i] = pack_channel(regs->a[i]);
+    }
+}
+
+static void stage_store_rgb565(pipeline_registers_t* regs, const void* context)
+{
+    uint16_t* pixels = regs->dest;
+    for(int i = 0; i < regs->count; i++) {
+        uint32_t pixel = (pack_channel(regs->r[i]) << 16) | (pack_channel(regs->g[i]) << 8) | pack_channel(regs->b[i]);
+        pixels[i] = plutovg_argb_to_rgb565(pixel, plutovg_rgb565_dither(regs->px + i, regs->py));
+    }
+}
+
+static void premultiply_color(float* output, const plutovg_color_t* color, float opacity)
+{
+    float alpha = color->a * opacity;
+    output[0] = color->r * alpha;
+    output[1] = color->g * alpha;
+    output[2] = color->b * alpha;
+    output[3] = alpha;
+}
+
+static bool pipeline_append_gradient(pipeline_t* pipeline, const plutovg_gradient_paint_t* gradient, const plutovg_state_t* state,
+    plutovg_matrix_t* matrix, linear_gradient_context_t* linear, radial_gradient_context_t* radial, gradient_stops_context_t* stops, float* buffer)
+{
+    plutovg_matrix_multiply(matrix, &gradient->matrix, &state->matrix);
+    if(!plutovg_matrix_invert(matrix, matrix))
+        return false;
+    pipeline_append(pipeline, stage_transform, matrix);
+    if(gradient->type == PLUTOVG_GRADIENT_TYPE_LINEAR) {
+        float dx = gradient->values[2] - gradient->values[0];
+        float dy = gradient->values[3] - gradient->values[1];
+        float l = dx * dx + dy * dy;
+        linear->dx = linear->dy = linear->off = 0.f;
+        if(l != 0.f) {
+            linear->dx = dx / l;
+            linear->dy = dy / l;
+            linear->off = -linear->dx * gradient->values[0] - linear->dy * gradient->values[1];
+        }
+
+        pipeline_append(pipeline, stage_linear_gradient, linear);
+    } else {
+        radial->fx = gradient->values[3];
+        radial->fy = gradient->values[4];
+        radial->fr = gradient->values[5];
+        radial->dx = gradient->values[0] - radial->fx;
+        radial->dy = gradient->values[1] - radial->fy;
+        radial->dr = gradient->values[2] - radial->fr;
+        radial->sqrfr = radial->fr * radial->fr;
+        radial->a = radial->dr * radial->dr - radial->dx * radial->dx - radial->dy * radial->dy;
+        radial->extended = radial->fr != 0.f || radial->a <= 0.f;
+        pipeline_append(pipeline, stage_radial_gradient, radial);
+    }
+
+    switch(gradient->spread) {
+    case PLUTOVG_SPREAD_METHOD_PAD:
+        pipeline_append(pipeline, stage_spread_pad, NULL);
+        break;
+    case PLUTOVG_SPREAD_METHOD_REFLECT:
+        pipeline_append(pipeline, stage_spread_reflect, NULL);
+        break;
+    case PLUTOVG_SPREAD_METHOD_REPEAT:
+        pipeline_append(pipeline, stage_spread_repeat, NULL);
+        break;
+    }
+
+    float* offsets = buffer;
+    float* colors = buffer + gradient->nstops;
+    for(int i = 0; i < gradient->nstops; i++) {
+        offsets[i] = gradient->stops[i].offset;
+        premultiply_color(colors + 4 * i, &gradient->stops[i].color, state->opacity);
+    }
+
+    stops->nstops = gradient->nstops;
+    stops->offsets = offsets;
+    stops->colors = colors;
+    pipeline_append(pipeline, stage_gradient_stops, stops);
+    return true;
+}
+
+static void pipeline_append_texture(pipeline_t* pipeline, const plutovg_texture_paint_t* texture, const plutovg_texture_level_t* level, const plutovg_matrix_t* matrix, texture_context_t* context)
+{
+    context->data = level->data;
+    context->width = level->width;
+    context->height = level->height;
+    context->stride = level->stride;
+    context->clip = matrix->a == 1 && matrix->b == 0 && matrix->c == 0 && matrix->d == 1;
+    pipeline_append(pipeline, stage_transform, matrix);
+    bool bilinear = fabsf(matrix->b) > 1e-6f || fabsf(matrix->c) > 1e-6f;
+    if(texture->type == PLUTOVG_TEXTURE_TYPE_PLAIN) {
+        pipeline_append(pipeline, bilinear ? stage_texture_plain_bilinear : stage_texture_plain, context);
+    } else {
+        pipeline_append(pipeline, bilinear ? stage_texture_tiled_bilinear : stage_texture_tiled, context);
+    }
+}
+
+void plutovg_pipeline_blend(plutovg_canvas_t* canvas, plutovg_surface_t* surface, const plutovg_span_buffer_t* span_buffer)
+{
+    plutovg_state_t* state = canvas->state;
+    if(state->op == PLUTOVG_OPERATOR_DST)
+        return;
+    pipeline_t pipeline;
+    pipeline.nstages = 0;
+    pipeline_append(&pipeline, stage_seed, NULL);
+
+    float coverage_scale = 1.f;
+    float solid[4];
+    plutovg_matrix_t matrix;
+    linear_gradient_context_t linear;
+    radial_gradient_context_t radial;
+    gradient_stops_context_t stops;
+    texture_context_t texture;
+    plutovg_texture_level_t level;
+    plutovg_mipmap_t* mipmap = NULL;
+
+    const plutovg_paint_t* paint = state->paint;
+    if(paint == NULL || paint->type == PLUTOVG_PAINT_TYPE_COLOR) {
+        const plutovg_color_t* color = paint ? &((const plutovg_solid_paint_t*)(paint))->color : &state->color;
+        premultiply_color(solid, color, state->opacity);
+        pipeline_append(&pipeline, stage_solid, solid);
+    } else if(paint->type == PLUTOVG_PAINT_TYPE_GRADIENT) {
+        const plutovg_gradient_paint_t* gradient = (const plutovg_gradient_paint_t*)(paint);
+        if(gradient->nstops == 0)
+            return;
+        plutovg_array_clear(canvas->stops_buffer);
+        plutovg_array_ensure(canvas->stops_buffer, 5 * gradient->nstops);
+        if(!pipeline_append_gradient(&pipeline, gradient, state, &matrix, &linear, &radial, &stops, canvas->stops_buffer.data)) {
+            return;
+        }
+    } else {
+        const plutovg_texture_paint_t* texture_paint = (const plutovg_texture_paint_t*)(paint);
+        if(texture_paint->surface == NULL)
+            return;
+        plutovg_matrix_multiply(&matrix, &texture_paint->matrix, &state->matrix);
+        if(!plutovg_matrix_invert(&matrix, &matrix))
+            return;
+        coverage_scale = state->opacity * texture_paint->opacity;
+        mipmap = plutovg_surface_select_level(texture_paint->surface, texture_paint->type, &matrix, &level);
+        if(level.data == NULL)
+            return;
+        pipeline_append_texture(&pipeline, texture_paint, &level, &matrix, &texture);
+    }
+
+    pipeline_stage_function_t load_dest = stage_load_dest;
+    pipeline_stage_function_t store = stage_store;
+    switch(surface->format) {
+    case PLUTOVG_FORMAT_A8:
+        load_dest = stage_load_dest_a8;
+        store = stage_store_a8;
+        break;
+    case PLUTOVG_FORMAT_XRGB32:
+        load_dest = stage_load_dest_xrgb;
+        break;
+    case PLUTOVG_FORMAT_RGB565:
+        load_dest = stage_load_dest_rgb565;
+        store = stage_store_rgb565;
+        break;
+    default:
+        break;
+    }
+
+    pipeline_append(&pipeline, load_dest, NULL);
+    pipeline_append(&pipeline, blend_stage_table[state->op], NULL);
+    pipeline_append(&pipeline, stage_lerp_coverage, NULL);
+    pipeline_append(&pipeline, store, NULL);
+    pipeline_run(&pipeline, surface, coverage_scale, span_buffer);
+    plutovg_mipmap_destroy(mipmap);
+}
@@ -14,6 +14,10 @@ typedef LONG plutovg_ref_count_t;
 #define plutovg_destroy_reference(ob) (ob && InterlockedDecrement(&(ob)->ref_count) == 0)
 #define plutovg_get_reference_count(ob) ((ob) ? InterlockedCompareExchange((LONG*)&(ob)->ref_count, 0, 0) : 0)
 
+#define PLUTOVG_ATOMIC(type) type volatile
+#define plutovg_atomic_load(ptr) (*(ptr))
+#define plutovg_atomic_store(ptr, value) (*(ptr) = (value))
+
 #elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
 
 #include <stdatomic.h>
@@ -25,6 +29,10 @@ typedef atomic_int plutovg_ref_count_t;
 #define plutovg_destroy_reference(ob) (ob && atomic_fetch_sub(&(ob)->ref_count, 1) == 1)
 #define plutovg_get_reference_count(ob) ((ob) ? atomic_load(&(ob)->ref_count) : 0)
 
+#define PLUTOVG_ATOMIC(type) _Atomic(type)
+#define plutovg_atomic_load(ptr) atomic_load_explicit(ptr, memory_order_acquire)
+#define plutovg_atomic_store(ptr, value) atomic_store_explicit(ptr, value, memory_order_release)
+
 #else
 
 typedef int plutovg_ref_count_t;
@@ -34,16 +42,133 @@ typedef int plutovg_ref_count_t;
 #define plutovg_destroy_reference(ob) (ob && --(ob)->ref_count == 0)
 #define plutovg_get_reference_count(ob) ((ob) ? (ob)->ref_count : 0)
 
+#define PLUTOVG_ATOMIC(type) type
+#define plutovg_atomic_load(ptr) (*(ptr))
+#define plutovg_atomic_store(ptr, value) (*(ptr) = (value))
+
 #endif
 
+#if defined(_WIN32)
+
+typedef CRITICAL_SECTION plutovg_mutex_t;
+
+#define plutovg_mutex_init(mutex) InitializeCriticalSection(mutex)
+#define plutovg_mutex_lock(mutex) EnterCriticalSection(mutex)
+#define plutovg_mutex_unlock(mutex) LeaveCriticalSection(mutex)
+#define plutovg_mutex_destroy(mutex) DeleteCriticalSection(mutex)
+
+typedef HANDLE plutovg_thread_t;
+
+#define PLUTOVG_THREAD_ROUTINE(name, arg) DWORD WINAPI name(LPVOID arg)
+#define plutovg_thread_create(thread, routine, arg) ((*(thread) = CreateThread(NULL, 0, routine, arg, 0, NULL)) != NULL)
+#define plutovg_thread_join(thread) (WaitForSingleObject(thread, INFINITE), CloseHandle(thread))
+
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && defined(HAVE_THREADS_H) && !defined(__STDC_NO_THREADS__)
+
+#include <threads.h>
+
+typedef mtx_t plutovg_mutex_t;
+
+#define plutovg_mutex_init(mutex) mtx_init(mutex, mtx_plain | mtx_recursive)
+#define plutovg_mutex_lock(mutex) mtx_lock(mutex)
+#define plutovg_mutex_unlock(mutex) mtx_unlock(mutex)
+#define plutovg_mutex_destroy(mutex) mtx_destroy(mutex)
+
+typedef thrd_t plutovg_thread_t;
+
+#define PLUTOVG_THREAD_ROUTINE(name, arg) int name(void* arg)
+#define plutovg_thread_create(thread, routine, arg) (thrd_create(thread, routine, arg) == thrd_success)
+#define plutovg_thread_join(thread) thrd_join(thread, NULL)
+
+#else
+
+typedef int plutovg_mutex_t;
+
+#define plutovg_mutex_init(mutex) ((void)(mutex))
+#define plutovg_mutex_lock(mutex) ((void)(mutex))
+#define plutovg_mutex_unlock(mutex) ((void)(mutex))
+#define plutovg_mutex_destroy(mutex) ((void)(mutex))
+
+typedef int plutovg_thread_t;
+
+#define PLUTOVG_THREAD_ROUTINE(name, arg) int name(void* arg)
+#define plutovg_thread_create(thread, routine, arg) ((void)(thread), (void)(routine), (void)(arg), false)
+#define plutovg_thread_join(thread) ((void)(thread))
+
+#endif
+
+typedef struct plutovg_mipmap plutovg_mipmap_t;
+
 struct plutovg_surface {
     plutovg_ref_count_t ref_count;
     int width;
     int height;
     int stride;
+    int origin_x;
+    int origin_y;
+    plutovg_format_t format;
     unsigned char* data;
+    size_t mapped_size;
+    bool sparse;
+    plutovg_surface_t* parent;
+    unsigned int generation;
+    bool opaque;
+    bool external_data;
+    bool data_exposed;
+    bool mipmap_enabled;
+    plutovg_mutex_t mutex;
+    plutovg_mipmap_t* mipmap;
 };
 
+static inline int plutovg_format_bytes_per_pixel(plutovg_format_t format)
+{
+    switch(format) {
+    case PLUTOVG_FORMAT_A8:
+        return 1;
+    case PLUTOVG_FORMAT_RGB565:
+        return 2;
+    default:
+        return 4;
+    }
+}
+
+static inline bool plutovg_format_is_opaque(plutovg_format_t format)
+{
+    return format == PLUTOVG_FORMAT_XRGB32 || format == PLUTOVG_FORMAT_RGB565;
+}
+
+/*
+ * Group layers cover a rectangle of the canvas but keep canvas coordinates, so a destination
+ * surface may start at a pixel origin other than (0, 0). Only the addressing is offset;
+ * spans and paints stay in canvas space.
+ */
+static inline unsigned char* plutovg_surface_address(const plutovg_surface_t* surface, int x, int y)
+{
+    return surface->data + (ptrdiff_t)(y - surface->origin_y) * surface->stride + (ptrdiff_t)(x - surface->origin_x) * plutovg_format_bytes_per_pixel(surface->format);
+}
+
+/*
+ * Whether the pixels may change without the surface being told: the caller owns the buffer,
+ * or holds a writable pointer from plutovg_surface_get_data() and has not called
+ * plutovg_surface_mark_dirty() since. The opaque flag and caches derived from the pixels
+ * are not trusted for such surfaces, nor for views of them.
+ */
+static inline bool plutovg_surface_is_volatile(const plutovg_surface_t* surface)
+{
+    for(; surface; surface = surface->parent) {
+        if(surface->external_data || surface->data_exposed) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static inline bool plutovg_surface_is_opaque(const plutovg_surface_t* surface)
+{
+    return surface->opaque && !plutovg_surface_is_volatile(surface);
+}
+
 struct plutovg_path {
     plutovg_ref_count_t ref_count;
     int num_points;
@@ -78,6 +203,9 @@ typedef enum {
     PLUTOVG_GRADIENT_TYPE_RADIAL
 } plutovg_gradient_type_t;
 
+typedef struct plutovg_color_table plutovg_color_table_t;
+typedef struct plutovg_tile_cache plutovg_tile_cache_t;
+
 typedef struct {
     plutovg_paint_t base;
     plutovg_gradient_type_t type;
@@ -86,14 +214,26 @@ typedef struct {
     plutovg_gradient_stop_t* stops;
     int nstops;
     float values[6];
+    plutovg_mutex_t mutex;
+    plutovg_color_table_t* colortable;
 } plutovg_gradient_paint_t;
 
+typedef struct {
+    unsigned char* data;
+    int width;
+    int height;
+    int stride;
+    bool opaque;
+} plutovg_texture_level_t;
+
 typedef struct {
     plutovg_paint_t base;
     plutovg_texture_type_t type;
     float opacity;
     plutovg_matrix_t matrix;
     plutovg_surface_t* surface;
+    plutovg_mutex_t mutex;
+    plutovg_tile_cache_t* tilecache;
 } plutovg_texture_paint_t;
 
 typedef struct {
@@ -152,20 +292,113 @@ typedef struct plutovg_state {
     struct plutovg_state* next;
 } plutovg_state_t;
 
+typedef enum {
+    PLUTOVG_COMMAND_TYPE_SAVE,
+    PLUTOVG_COMMAND_TYPE_RESTORE,
+    PLUTOVG_COMMAND_TYPE_FILL,
+    PLUTOVG_COMMAND_TYPE_STROKE,
+    PLUTOVG_COMMAND_TYPE_CLIP,
+    PLUTOVG_COMMAND_TYPE_PAINT,
+    PLUTOVG_COMMAND_TYPE_MASK,
+    PLUTOVG_COMMAND_TYPE_PUSH_GROUP,
+    PLUTOVG_COMMAND_TYPE_POP_GROUP
+} plutovg_command_type_t;
+
+typedef struct {
+    plutovg_stroke_style_t style;
+    float dash_offset;
+    int dash_index;
+    int dash_count;
+} plutovg_command_stroke_t;
+
+typedef struct {
+    plutovg_command_type_t type;
+    plutovg_operator_t op;
+    plutovg_fill_rule_t winding;
+    float opacity;
+    plutovg_color_t color;
+    plutovg_paint_t* paint;
+    plutovg_path_t* path;
+    plutovg_surface_t* mask;
+    plutovg_matrix_t matrix;
+    plutovg_point_t offset;
+    int stroke;
+} plutovg_command_t;
+
+struct plutovg_display_list {
+    plutovg_ref_count_t ref_count;
+    int width;
+    int height;
+    struct {
+        plutovg_command_t* data;
+        int size;
+        int capacity;
+    } commands;
+
+    struct {
+        plutovg_command_stroke_t* data;
+        int size;
+        int capacity;
+    } strokes;
+
+    struct {
+        float* data;
+        int size;
+        int capacity;
+    } dashes;
+};
+
+typedef struct plutovg_rasterizer plutovg_rasterizer_t;
+
+typedef struct plutovg_layer {
+    plutovg_surface_t* surface;
+    plutovg_paint_t* paint;
+    size_t capacity;
+    plutovg_surface_t* target;
+    plutovg_state_t* state;
+    struct plutovg_layer* next;
+} plutovg_layer_t;
+
 struct plutovg_canvas {
     plutovg_ref_count_t ref_count;
     plutovg_surface_t* surface;
     plutovg_path_t* path;
     plutovg_state_t* state;
     plutovg_state_t* freed_state;
+    plutovg_layer_t* layer;
+    plutovg_layer_t* freed_layer;
+    plutovg_display_list_t* recording;
     plutovg_font_face_cache_t* face_cache;
     plutovg_rect_t clip_rect;
+    plutovg_rect_t tile_rect;
+    plutovg_rect_t damage_rects[PLUTOVG_MAX_DAMAGE_RECTS];
+    int num_damage_rects;
     plutovg_span_buffer_t clip_spans;
     plutovg_span_buffer_t fill_spans;
+    plutovg_rasterizer_t* rasterizer;
+
+    struct {
+        float* data;
+        int size;
+        int capacity;
+    } stops_buffer;
+
+    struct {
+        unsigned int* data;
+        int size;
+        int capacity;
+    } staging_buffer;
+
+    struct {
+        unsigned int* data;
+        int size;
+        int capacity;
+    } row_buffer;
 };
 
 void plutovg_span_buffer_init(plutovg_span_buffer_t* span_buffer);
 void plutovg_span_buffer_init_rect(plutovg_span_buffer_t* span_buffer, int x, int y, int width, int height);
+void plutovg_span_buffer_init_mask(plutovg_span_buffer_t* span_buffer, const plutovg_surface_t* mask, const plutovg_matrix_t* matrix, const plutovg_rect_t* clip_rect);
 void plutovg_span_buffer_reset(plutovg_span_buffer_t* span_buffer);
 void plutovg_span_buffer_destroy(plutovg_span_buffer_t* span_buffer);
 void plutovg_span_buffer_copy(plutovg_span_buffer_t* span_buffer, const plutovg_span_buffer_t* source);
@@ -173,8 +406,23 @@ bool plutovg_span_buffer_contains(const plutovg_span_buffer_t* span_buffer, floa
 void plutovg_span_buffer_extents(plutovg_span_buffer_t* span_buffer, plutovg_rect_t* extents);
 void plutovg_span_buffer_intersect(plutovg_span_buffer_t* span_buffer, const plutovg_span_buffer_t* a, const plutovg_span_buffer_t* b);
 
-void plutovg_rasterize(plutovg_span_buffer_t* span_buffer, const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_rect_t* clip_rect, const plutovg_stroke_data_t* stroke_data, plutovg_fill_rule_t winding);
+plutovg_rasterizer_t* plutovg_rasterizer_create(void);
+void plutovg_rasterizer_destroy(plutovg_rasterizer_t* rasterizer);
+void plutovg_rasterize(plutovg_rasterizer_t* rasterizer, plutovg_span_buffer_t* span_buffer, const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_rect_t* clip_rect, const plutovg_rect_t* tile_rect, const plutovg_stroke_data_t* stroke_data, plutovg_fill_rule_t winding);
+void plutovg_canvas_add_damage(plutovg_canvas_t* canvas, const plutovg_span_buffer_t* span_buffer);
 void plutovg_blend(plutovg_canvas_t* canvas, const plutovg_span_buffer_t* span_buffer);
+void plutovg_pipeline_blend(plutovg_canvas_t* canvas, plutovg_surface_t* surface, const plutovg_span_buffer_t* span_buffer);
+void plutovg_path_dash(plutovg_path_t* dashed, const plutovg_path_t* path, float offset, const float* dashes, int ndashes);
+plutovg_display_list_t* plutovg_display_list_create(int width, int height);
+void plutovg_display_list_clear(plutovg_display_list_t* display_list);
+plutovg_command_t* plutovg_display_list_add(plutovg_display_list_t* display_list, plutovg_command_type_t type, const plutovg_canvas_t* canvas);
+
 void plutovg_memfill32(unsigned int* dest, int length, unsigned int value);
+void plutovg_memfill32_stream(unsigned int* dest, int length, unsigned int value);
+void plutovg_color_table_destroy(plutovg_color_table_t* colortable);
+void plutovg_tile_cache_destroy(plutovg_tile_cache_t* tilecache);
+void plutovg_surface_invalidate(plutovg_surface_t* surface);
+plutovg_mipmap_t* plutovg_surface_select_level(plutovg_surface_t* surface, plutovg_texture_type_t type, plutovg_matrix_t* matrix, plutovg_texture_level_t* level);
+void plutovg_mipmap_destroy(plutovg_mipmap_t* mipmap);
 
 #endif // PLUTOVG_PRIVATE_H
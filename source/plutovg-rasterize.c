@@ -31,6 +31,64 @@ void plutovg_span_buffer_init_rect(plutovg_span_buffer_t* span_buffer, int x, in
     span_buffer->spans.size = height;
 }
 
+static inline int plutovg_mask_alpha(const plutovg_surface_t* mask, int x, int y)
+{
+    if(x < 0 || y < 0 || x >= mask->width || y >= mask->height)
+        return 0;
+    const unsigned char* row = mask->data + (ptrdiff_t)y * mask->stride;
+    switch(mask->format) {
+    case PLUTOVG_FORMAT_A8:
+        return row[x];
+    case PLUTOVG_FORMAT_ARGB32:
+        return plutovg_alpha(((const uint32_t*)(row))[x]);
+    default:
+        return 255;
+    }
+}
+
+void plutovg_span_buffer_init_mask(plutovg_span_buffer_t* span_buffer, const plutovg_surface_t* mask, const plutovg_matrix_t* matrix, const plutovg_rect_t* clip_rect)
+{
+    plutovg_span_buffer_reset(span_buffer);
+    plutovg_matrix_t inverse;
+    if(!plutovg_matrix_invert(matrix, &inverse))
+        return;
+    plutovg_rect_t extents = {0, 0, mask->width, mask->height};
+    plutovg_matrix_map_rect(matrix, &extents, &extents);
+
+    int x1 = (int)floorf(plutovg_max(extents.x, clip_rect->x));
+    int y1 = (int)floorf(plutovg_max(extents.y, clip_rect->y));
+    int x2 = (int)ceilf(plutovg_min(extents.x + extents.w, clip_rect->x + clip_rect->w));
+    int y2 = (int)ceilf(plutovg_min(extents.y + extents.h, clip_rect->y + clip_rect->h));
+    for(int y = y1; y < y2; y++) {
+        float fx = inverse.a * (x1 + 0.5f) + inverse.c * (y + 0.5f) + inverse.e;
+        float fy = inverse.b * (x1 + 0.5f) + inverse.d * (y + 0.5f) + inverse.f;
+        int start = x1;
+        int coverage = 0;
+        for(int x = x1; x <= x2; x++) {
+            int alpha = 0;
+            if(x < x2)
+                alpha = plutovg_mask_alpha(mask, (int)floorf(fx), (int)floorf(fy));
+            if(alpha != coverage) {
+                if(coverage > 0) {
+                    plutovg_array_ensure(span_buffer->spans, 1);
+                    plutovg_span_t* span = span_buffer->spans.data + span_buffer->spans.size;
+                    span->x = start;
+                    span->len = x - start;
+                    span->y = y;
+                    span->coverage = coverage;
+                    span_buffer->spans.size += 1;
+                }
+
+                start = x;
+                coverage = alpha;
+            }
+
+            fx += inverse.a;
+            fy += inverse.b;
+        }
+    }
+}
+
 void plutovg_span_buffer_reset(plutovg_span_buffer_t* span_buffer)
 {
     plutovg_array_clear(span_buffer->spans);
@@ -164,14 +222,55 @@ void plutovg_span_buffer_intersect(plutovg_span_buffer_t* span_buffer, const plu
     }
 }
 
+struct plutovg_rasterizer {
+    PVG_FT_Outline* outline;
+    size_t outline_size;
+    PVG_FT_Outline* stroke_outline;
+    size_t stroke_outline_size;
+    PVG_FT_Stroker stroker;
+    plutovg_path_t* dashed;
+    PVG_FT_Raster_Pool pool;
+};
+
+plutovg_rasterizer_t* plutovg_rasterizer_create(void)
+{
+    plutovg_rasterizer_t* rasterizer = plutovg_malloc(sizeof(plutovg_rasterizer_t));
+    rasterizer->outline = NULL;
+    rasterizer->outline_size = 0;
+    rasterizer->stroke_outline = NULL;
+    rasterizer->stroke_outline_size = 0;
+    rasterizer->stroker = NULL;
+    rasterizer->dashed = NULL;
+    rasterizer->pool.buffer = NULL;
+    rasterizer->pool.size = 0;
+    return rasterizer;
+}
+
+void plutovg_rasterizer_destroy(plutovg_rasterizer_t* rasterizer)
+{
+    plutovg_free(rasterizer->outline);
+    plutovg_free(rasterizer->stroke_outline);
+    PVG_FT_Stroker_Done(rasterizer->stroker);
+    plutovg_path_destroy(rasterizer->dashed);
+    plutovg_free(rasterizer->pool.buffer);
+    plutovg_free(rasterizer);
+}
+
 #define ALIGN_SIZE(size) (((size) + 7ul) & ~7ul)
-static PVG_FT_Outline* ft_outline_create(int points, int contours)
+static PVG_FT_Outline* ft_outline_create(PVG_FT_Outline** storage, size_t* storage_size, int points, int contours)
 {
     size_t points_size = ALIGN_SIZE((points + contours) * sizeof(PVG_FT_Vector));
     size_t tags_size = ALIGN_SIZE((points + contours) * sizeof(char));
     size_t contours_size = ALIGN_SIZE(contours * sizeof(int));
     size_t contours_flag_size = ALIGN_SIZE(contours * sizeof(char));
-    PVG_FT_Outline* outline = malloc(points_size + tags_size + contours_size + contours_flag_size + sizeof(PVG_FT_Outline));
+    size_t size = points_size + tags_size + contours_size + contours_flag_size + sizeof(PVG_FT_Outline);
+    if(*storage_size < size) {
+        plutovg_free(*storage);
+        *storage = plutovg_malloc(size);
+        *storage_size = size;
+    }
+
+    PVG_FT_Outline* outline = *storage;
 
     PVG_FT_Byte* outline_data = (PVG_FT_Byte*)(outline + 1);
     outline->points = (PVG_FT_Vector*)(outline_data);
@@ -184,11 +283,6 @@ static PVG_FT_Outline* ft_outline_create(int points, int contours)
     return outline;
 }
 
-static void ft_outline_destroy(PVG_FT_Outline* outline)
-{
-    free(outline);
-}
-
 #define FT_COORD(x) (PVG_FT_Pos)(roundf(x * 64))
 static void ft_outline_move_to(PVG_FT_Outline* ft, float x, float y)
 {
@@ -250,19 +344,19 @@ static void ft_outline_end(PVG_FT_Outline* ft)
     }
 }
 
-static PVG_FT_Outline* ft_outline_convert_stroke(const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_stroke_data_t* stroke_data);
+static PVG_FT_Outline* ft_outline_convert_stroke(plutovg_rasterizer_t* rasterizer, const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_stroke_data_t* stroke_data);
 
-static PVG_FT_Outline* ft_outline_convert(const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_stroke_data_t* stroke_data)
+static PVG_FT_Outline* ft_outline_convert(plutovg_rasterizer_t* rasterizer, const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_stroke_data_t* stroke_data)
 {
     if(stroke_data) {
-        return ft_outline_convert_stroke(path, matrix, stroke_data);
+        return ft_outline_convert_stroke(rasterizer, path, matrix, stroke_data);
     }
 
     plutovg_path_iterator_t it;
     plutovg_path_iterator_init(&it, path);
 
     plutovg_point_t points[3];
-    PVG_FT_Outline* outline = ft_outline_create(path->num_points, path->num_contours);
+    PVG_FT_Outline* outline = ft_outline_create(&rasterizer->outline, &rasterizer->outline_size, path->num_points, path->num_contours);
     while(plutovg_path_iterator_has_next(&it)) {
         switch(plutovg_path_iterator_next(&it, points)) {
         case PLUTOVG_PATH_COMMAND_MOVE_TO:
@@ -287,17 +381,17 @@ static PVG_FT_Outline* ft_outline_convert(const plutovg_path_t* path, const plut
     return outline;
 }
 
-static PVG_FT_Outline* ft_outline_convert_dash(const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_stroke_dash_t* stroke_dash)
+static PVG_FT_Outline* ft_outline_convert_dash(plutovg_rasterizer_t* rasterizer, const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_stroke_dash_t* stroke_dash)
 {
     if(stroke_dash->array.size == 0)
-        return ft_outline_convert(path, matrix, NULL);
-    plutovg_path_t* dashed = plutovg_path_clone_dashed(path, stroke_dash->offset, stroke_dash->array.data, stroke_dash->array.size);
-    PVG_FT_Outline* outline = ft_outline_convert(dashed, matrix, NULL);
-    plutovg_path_destroy(dashed);
-    return outline;
+        return ft_outline_convert(rasterizer, path, matrix, NULL);
+    if(rasterizer->dashed == NULL)
+        rasterizer->dashed = plutovg_path_create();
+    plutovg_path_dash(rasterizer->dashed, path, stroke_dash->offset, stroke_dash->array.data, stroke_dash->array.size);
+    return ft_outline_convert(rasterizer, rasterizer->dashed, matrix, NULL);
 }
 
-static PVG_FT_Outline* ft_outline_convert_stroke(const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_stroke_data_t* stroke_data)
+static PVG_FT_Outline* ft_outline_convert_stroke(plutovg_rasterizer_t* rasterizer, const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_stroke_data_t* stroke_data)
 {
     double scale_x = sqrt(matrix->a * matrix->a + matrix->b * matrix->b);
     double scale_y = sqrt(matrix->c * matrix->c + matrix->d * matrix->d);
@@ -334,22 +428,20 @@ static PVG_FT_Outline* ft_outline_convert_stroke(const plutovg_path_t* path, con
         break;
     }
 
-    PVG_FT_Stroker stroker;
-    PVG_FT_Stroker_New(&stroker);
+    if(rasterizer->stroker == NULL)
+        PVG_FT_Stroker_New(&rasterizer->stroker);
+    PVG_FT_Stroker stroker = rasterizer->stroker;
     PVG_FT_Stroker_Set(stroker, ftWidth, ftCap, ftJoin, ftMiterLimit);
 
-    PVG_FT_Outline* outline = ft_outline_convert_dash(path, matrix, &stroke_data->dash);
+    PVG_FT_Outline* outline = ft_outline_convert_dash(rasterizer, path, matrix, &stroke_data->dash);
     PVG_FT_Stroker_ParseOutline(stroker, outline);
 
     PVG_FT_UInt points;
     PVG_FT_UInt contours;
     PVG_FT_Stroker_GetCounts(stroker, &points, &contours);
 
-    PVG_FT_Outline* stroke_outline = ft_outline_create(points, contours);
+    PVG_FT_Outline* stroke_outline = ft_outline_create(&rasterizer->stroke_outline, &rasterizer->stroke_outline_size, points, contours);
     PVG_FT_Stroker_Export(stroker, stroke_outline);
-
-    PVG_FT_Stroker_Done(stroker);
-    ft_outline_destroy(outline);
     return stroke_outline;
 }
 
@@ -359,9 +451,9 @@ static void spans_generation_callback(int count, const PVG_FT_Span* spans, void*
     plutovg_array_append_data(span_buffer->spans, spans, count);
 }
 
-void plutovg_rasterize(plutovg_span_buffer_t* span_buffer, const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_rect_t* clip_rect, const plutovg_stroke_data_t* stroke_data, plutovg_fill_rule_t winding)
+void plutovg_rasterize(plutovg_rasterizer_t* rasterizer, plutovg_span_buffer_t* span_buffer, const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_rect_t* clip_rect, const plutovg_rect_t* tile_rect, const plutovg_stroke_data_t* stroke_data, plutovg_fill_rule_t winding)
 {
-    PVG_FT_Outline* outline = ft_outline_convert(path, matrix, stroke_data);
+    PVG_FT_Outline* outline = ft_outline_convert(rasterizer, path, matrix, stroke_data);
     if(stroke_data) {
         outline->flags = PVG_FT_OUTLINE_NONE;
     } else {
@@ -388,7 +480,12 @@ void plutovg_rasterize(plutovg_span_buffer_t* span_buffer, const plutovg_path_t*
         params.clip_box.yMax = (PVG_FT_Pos)(clip_rect->y + clip_rect->h);
     }
 
+    if(tile_rect) {
+        params.flags |= PVG_FT_RASTER_FLAG_BAND;
+        params.band_min = (PVG_FT_Pos)tile_rect->y;
+        params.band_max = (PVG_FT_Pos)(tile_rect->y + tile_rect->h);
+    }
+
     plutovg_span_buffer_reset(span_buffer);
-    PVG_FT_Raster_Render(&params);
-    ft_outline_destroy(outline);
+    PVG_FT_Raster_Render(&params, &rasterizer->pool);
 }
@@ -0,0 +1,420 @@
+#include "plutovg-private.h"
+#include "plutovg-utils.h"
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__APPLE__))
+#include <unistd.h>
+#endif
+
+plutovg_display_list_t* plutovg_display_list_create(int width, int height)
+{
+    plutovg_display_list_t* display_list = plutovg_malloc(sizeof(plutovg_display_list_t));
+    plutovg_init_reference(display_list);
+    display_list->width = width;
+    display_list->height = height;
+    plutovg_array_init(display_list->commands);
+    plutovg_array_init(display_list->strokes);
+    plutovg_array_init(display_list->dashes);
+    return display_list;
+}
+
+plutovg_display_list_t* plutovg_display_list_reference(plutovg_display_list_t* display_list)
+{
+    plutovg_increment_reference(display_list);
+    return display_list;
+}
+
+void plutovg_display_list_clear(plutovg_display_list_t* display_list)
+{
+    for(int i = 0; i < display_list->commands.size; i++) {
+        plutovg_command_t* command = &display_list->commands.data[i];
+        plutovg_paint_destroy(command->paint);
+        plutovg_path_destroy(command->path);
+        plutovg_surface_destroy(command->mask);
+    }
+
+    plutovg_array_clear(display_list->commands);
+    plutovg_array_clear(display_list->strokes);
+    plutovg_array_clear(display_list->dashes);
+}
+
+void plutovg_display_list_destroy(plutovg_display_list_t* display_list)
+{
+    if(plutovg_destroy_reference(display_list)) {
+        plutovg_display_list_clear(display_list);
+        plutovg_array_destroy(display_list->commands);
+        plutovg_array_destroy(display_list->strokes);
+        plutovg_array_destroy(display_list->dashes);
+        plutovg_free(display_list);
+    }
+}
+
+int plutovg_display_list_get_reference_count(const plutovg_display_list_t* display_list)
+{
+    return plutovg_get_reference_count(display_list);
+}
+
+void plutovg_display_list_get_size(const plutovg_display_list_t* display_list, int* width, int* height)
+{
+    if(width) *width = display_list->width;
+    if(height) *height = display_list->height;
+}
+
+static bool plutovg_path_equal(const plutovg_path_t* a, const plutovg_path_t* b)
+{
+    if(a->num_points != b->num_points || a->num_contours != b->num_contours || a->num_curves != b->num_curves)
+        return false;
+    if(a->elements.size != b->elements.size)
+        return false;
+    return memcmp(a->elements.data, b->elements.data, a->elements.size * sizeof(plutovg_path_element_t)) == 0;
+}
+
+/*
+ * Filling and then stroking the same path is the common case, so a path that matches
+ * the one recorded by the previous command is shared instead of copied again.
+ */
+static plutovg_path_t* plutovg_display_list_add_path(plutovg_display_list_t* display_list, const plutovg_path_t* path)
+{
+    if(display_list->commands.size > 1) {
+        plutovg_path_t* last_path = display_list->commands.data[display_list->commands.size - 2].path;
+        if(last_path && plutovg_path_equal(last_path, path)) {
+            return plutovg_path_reference(last_path);
+        }
+    }
+
+    return plutovg_path_clone(path);
+}
+
+static int plutovg_display_list_add_stroke(plutovg_display_list_t* display_list, const plutovg_stroke_data_t* stroke)
+{
+    if(display_list->strokes.size > 0) {
+        const plutovg_command_stroke_t* last_stroke = &display_list->strokes.data[display_list->strokes.size - 1];
+        if(memcmp(&last_stroke->style, &stroke->style, sizeof(plutovg_stroke_style_t)) == 0
+            && last_stroke->dash_offset == stroke->dash.offset
+            && last_stroke->dash_count == stroke->dash.array.size
+            && (stroke->dash.array.size == 0 || memcmp(display_list->dashes.data + last_stroke->dash_index, stroke->dash.array.data, stroke->dash.array.size * sizeof(float)) == 0)) {
+            return display_list->strokes.size - 1;
+        }
+    }
+
+    plutovg_array_ensure(display_list->strokes, 1);
+    plutovg_command_stroke_t* command_stroke = &display_list->strokes.data[display_list->strokes.size];
+    command_stroke->style = stroke->style;
+    command_stroke->dash_offset = stroke->dash.offset;
+    command_stroke->dash_index = display_list->dashes.size;
+    command_stroke->dash_count = stroke->dash.array.size;
+    plutovg_array_append(display_list->dashes, stroke->dash.array);
+    return display_list->strokes.size++;
+}
+
+plutovg_command_t* plutovg_display_list_add(plutovg_display_list_t* display_list, plutovg_command_type_t type, const plutovg_canvas_t* canvas)
+{
+    const plutovg_state_t* state = canvas->state;
+    plutovg_array_ensure(display_list->commands, 1);
+    plutovg_command_t* command = &display_list->commands.data[display_list->commands.size++];
+    command->type = type;
+    command->op = state->op;
+    command->winding = state->winding;
+    command->opacity = state->opacity;
+    command->color = state->color;
+    command->paint = NULL;
+    command->path = NULL;
+    command->mask = NULL;
+    command->offset = PLUTOVG_EMPTY_POINT;
+    command->stroke = -1;
+    plutovg_canvas_get_matrix(canvas, &command->matrix);
+    switch(type) {
+    case PLUTOVG_COMMAND_TYPE_STROKE:
+        command->stroke = plutovg_display_list_add_stroke(display_list, &state->stroke);
+        command->path = plutovg_display_list_add_path(display_list, canvas->path);
+        command->paint = plutovg_paint_reference(state->paint);
+        break;
+    case PLUTOVG_COMMAND_TYPE_FILL:
+        command->path = plutovg_display_list_add_path(display_list, canvas->path);
+        command->paint = plutovg_paint_reference(state->paint);
+        break;
+    case PLUTOVG_COMMAND_TYPE_CLIP:
+        command->path = plutovg_display_list_add_path(display_list, canvas->path);
+        break;
+    case PLUTOVG_COMMAND_TYPE_PAINT:
+    case PLUTOVG_COMMAND_TYPE_MASK:
+        command->paint = plutovg_paint_reference(state->paint);
+        break;
+    default:
+        break;
+    }
+
+    return command;
+}
+
+plutovg_display_list_t* plutovg_canvas_finish_recording(plutovg_canvas_t* canvas)
+{
+    if(canvas->recording == NULL)
+        return NULL;
+    while(canvas->layer)
+        plutovg_canvas_pop_group(canvas, 1.f, PLUTOVG_OPERATOR_SRC_OVER);
+    while(canvas->state->next)
+        plutovg_canvas_restore(canvas);
+    plutovg_display_list_t* display_list = canvas->recording;
+    canvas->recording = plutovg_display_list_create(display_list->width, display_list->height);
+    return display_list;
+}
+
+static void plutovg_canvas_apply_command(plutovg_canvas_t* canvas, const plutovg_display_list_t* display_list, const plutovg_command_t* command, const plutovg_matrix_t* transform)
+{
+    plutovg_matrix_t matrix;
+    plutovg_matrix_multiply(&matrix, &command->matrix, transform);
+    plutovg_canvas_set_matrix(canvas, &matrix);
+    plutovg_canvas_set_fill_rule(canvas, command->winding);
+    if(command->type == PLUTOVG_COMMAND_TYPE_CLIP)
+        return;
+    if(command->paint) {
+        plutovg_canvas_set_paint(canvas, command->paint);
+    } else {
+        plutovg_canvas_set_color(canvas, &command->color);
+    }
+
+    plutovg_canvas_set_operator(canvas, command->op);
+    plutovg_canvas_set_opacity(canvas, command->opacity);
+    if(command->stroke != -1) {
+        const plutovg_command_stroke_t* stroke = &display_list->strokes.data[command->stroke];
+        plutovg_canvas_set_line_width(canvas, stroke->style.width);
+        plutovg_canvas_set_line_cap(canvas, stroke->style.cap);
+        plutovg_canvas_set_line_join(canvas, stroke->style.join);
+        plutovg_canvas_set_miter_limit(canvas, stroke->style.miter_limit);
+        plutovg_canvas_set_dash(canvas, stroke->dash_offset, display_list->dashes.data + stroke->dash_index, stroke->dash_count);
+    }
+}
+
+static bool plutovg_rect_intersects(const plutovg_rect_t* a, const plutovg_rect_t* b)
+{
+    return a->x < b->x + b->w && a->x + a->w > b->x && a->y < b->y + b->h && a->y + a->h > b->y;
+}
+
+static void plutovg_canvas_replay(plutovg_canvas_t* canvas, const plutovg_display_list_t* display_list, const plutovg_matrix_t* transform, const plutovg_rect_t* extents, const plutovg_rect_t* clip_rect)
+{
+    plutovg_canvas_save(canvas);
+
+    /*
+     * Recorded paths are immutable, so they are drawn by pointing the canvas path at them
+     * for the duration of each operation instead of copying them into the current path.
+     */
+    plutovg_path_t* path = canvas->path;
+    for(int i = 0; i < display_list->commands.size; i++) {
+        const plutovg_command_t* command = &display_list->commands.data[i];
+        switch(command->type) {
+        case PLUTOVG_COMMAND_TYPE_SAVE:
+            plutovg_canvas_save(canvas);
+            break;
+        case PLUTOVG_COMMAND_TYPE_RESTORE:
+            plutovg_canvas_restore(canvas);
+            break;
+        case PLUTOVG_COMMAND_TYPE_PUSH_GROUP:
+            plutovg_canvas_push_group(canvas);
+            break;
+        case PLUTOVG_COMMAND_TYPE_POP_GROUP:
+            plutovg_canvas_pop_group(canvas, command->opacity, command->op);
+            break;
+        case PLUTOVG_COMMAND_TYPE_FILL:
+            if(extents && !plutovg_rect_intersects(&extents[i], clip_rect))
+                break;
+            plutovg_canvas_apply_command(canvas, display_list, command, transform);
+            canvas->path = command->path;
+            plutovg_canvas_fill_preserve(canvas);
+            break;
+        case PLUTOVG_COMMAND_TYPE_STROKE:
+            if(extents && !plutovg_rect_intersects(&extents[i], clip_rect))
+                break;
+            plutovg_canvas_apply_command(canvas, display_list, command, transform);
+            canvas->path = command->path;
+            plutovg_canvas_stroke_preserve(canvas);
+            break;
+        case PLUTOVG_COMMAND_TYPE_CLIP:
+            plutovg_canvas_apply_command(canvas, display_list, command, transform);
+            canvas->path = command->path;
+            plutovg_canvas_clip_preserve(canvas);
+            break;
+        case PLUTOVG_COMMAND_TYPE_PAINT:
+            plutovg_canvas_apply_command(canvas, display_list, command, transform);
+            plutovg_canvas_paint(canvas);
+            break;
+        case PLUTOVG_COMMAND_TYPE_MASK:
+            if(extents && !plutovg_rect_intersects(&extents[i], clip_rect))
+                break;
+            plutovg_canvas_apply_command(canvas, display_list, command, transform);
+            plutovg_canvas_mask_surface(canvas, command->mask, command->offset.x, command->offset.y);
+            break;
+        }
+
+        canvas->path = path;
+    }
+
+    plutovg_canvas_restore(canvas);
+}
+
+void plutovg_canvas_draw_display_list(plutovg_canvas_t* canvas, const plutovg_display_list_t* display_list, const plutovg_matrix_t* matrix)
+{
+    plutovg_matrix_t transform;
+    plutovg_canvas_get_matrix(canvas, &transform);
+    if(matrix)
+        plutovg_matrix_multiply(&transform, matrix, &transform);
+    plutovg_canvas_replay(canvas, display_list, &transform, NULL, NULL);
+}
+
+/*
+ * Device bounds of the operations that only touch the pixels they cover. They are conservative:
+ * strokes grow by the widest join or cap, and every bound gets a pixel of antialiasing margin.
+ */
+static void plutovg_command_extents(const plutovg_display_list_t* display_list, const plutovg_command_t* command, const plutovg_matrix_t* transform, plutovg_rect_t* extents)
+{
+    plutovg_matrix_t matrix;
+    plutovg_matrix_multiply(&matrix, &command->matrix, transform);
+
+    plutovg_rect_t rect;
+    if(command->type == PLUTOVG_COMMAND_TYPE_MASK) {
+        rect = PLUTOVG_MAKE_RECT(command->offset.x, command->offset.y, command->mask->width, command->mask->height);
+    } else {
+        plutovg_path_extents(command->path, &rect, false);
+        if(command->type == PLUTOVG_COMMAND_TYPE_STROKE) {
+            const plutovg_stroke_style_t* style = &display_list->strokes.data[command->stroke].style;
+            float radius = style->width / 2.f;
+            if(style->join == PLUTOVG_LINE_JOIN_MITER) {
+                radius *= plutovg_max(style->miter_limit, PLUTOVG_SQRT2);
+            } else {
+                radius *= PLUTOVG_SQRT2;
+            }
+
+            rect.x -= radius;
+            rect.y -= radius;
+            rect.w += radius * 2.f;
+            rect.h += radius * 2.f;
+        }
+    }
+
+    plutovg_matrix_map_rect(&matrix, &rect, extents);
+    extents->x -= 1.f;
+    extents->y -= 1.f;
+    extents->w += 2.f;
+    extents->h += 2.f;
+}
+
+#define MAX_TILE_HEIGHT 256
+#define MIN_TILE_HEIGHT 16
+#define MAX_THREADS 64
+
+typedef struct {
+    plutovg_surface_t* surface;
+    const plutovg_display_list_t* display_list;
+    const plutovg_matrix_t* transform;
+    const plutovg_rect_t* extents;
+    int tile_height;
+    int num_tiles;
+    int next_tile;
+    bool opaque;
+    plutovg_mutex_t mutex;
+} plutovg_tile_context_t;
+
+/*
+ * Every worker draws through its own canvas, so span buffers, layers and raster state are
+ * never shared. The canvas sits on a private view of the target, which keeps the
+ * generation and opacity bookkeeping of the target out of the hot path.
+ * Tiles are handed out from a shared counter, so idle workers pick up whatever is left.
+ * A worker that cannot allocate its view or canvas returns before claiming a tile, and
+ * the others, including the one run on the calling thread, draw its share.
+ *
+ * Tiles span the full width of the surface: the canvas keeps clipping paths against the
+ * whole surface and only the rows of the tile are rasterized and blended, so every span
+ * is produced exactly as it would be without tiling.
+ */
+static PLUTOVG_THREAD_ROUTINE(plutovg_tile_worker, arg)
+{
+    plutovg_tile_context_t* context = arg;
+    plutovg_surface_t* target = context->surface;
+    plutovg_surface_t* surface = plutovg_surface_create_sub(target, 0, 0, target->width, target->height);
+    if(surface == NULL)
+        return 0;
+    plutovg_canvas_t* canvas = plutovg_canvas_create(surface);
+    if(canvas == NULL) {
+        plutovg_surface_destroy(surface);
+        return 0;
+    }
+
+    while(true) {
+        plutovg_mutex_lock(&context->mutex);
+        int tile = context->next_tile++;
+        plutovg_mutex_unlock(&context->mutex);
+        if(tile >= context->num_tiles)
+            break;
+        int y = tile * context->tile_height;
+        canvas->tile_rect = PLUTOVG_MAKE_RECT(0, y, surface->width, plutovg_min(context->tile_height, surface->height - y));
+        plutovg_canvas_replay(canvas, context->display_list, context->transform, context->extents, &canvas->tile_rect);
+    }
+
+    plutovg_mutex_lock(&context->mutex);
+    context->opaque = context->opaque && surface->opaque;
+    plutovg_mutex_unlock(&context->mutex);
+    plutovg_canvas_destroy(canvas);
+    plutovg_surface_destroy(surface);
+    return 0;
+}
+
+static int plutovg_processor_count(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#else
+    return 1;
+#endif
+}
+
+void plutovg_surface_draw_display_list(plutovg_surface_t* surface, const plutovg_display_list_t* display_list, const plutovg_matrix_t* matrix, int num_threads)
+{
+    plutovg_matrix_t transform = matrix ? *matrix : PLUTOVG_IDENTITY_MATRIX;
+    plutovg_rect_t* extents = plutovg_malloc(display_list->commands.size * sizeof(plutovg_rect_t));
+    for(int i = 0; i < display_list->commands.size; i++) {
+        const plutovg_command_t* command = &display_list->commands.data[i];
+        if(command->type == PLUTOVG_COMMAND_TYPE_FILL || command->type == PLUTOVG_COMMAND_TYPE_STROKE || command->type == PLUTOVG_COMMAND_TYPE_MASK) {
+            plutovg_command_extents(display_list, command, &transform, &extents[i]);
+        }
+    }
+
+    plutovg_tile_context_t context;
+    context.surface = surface;
+    context.display_list = display_list;
+    context.transform = &transform;
+    context.extents = extents;
+    context.next_tile = 0;
+    context.opaque = true;
+    plutovg_mutex_init(&context.mutex);
+
+    if(num_threads < 1)
+        num_threads = plutovg_processor_count();
+    num_threads = plutovg_clamp(num_threads, 1, MAX_THREADS);
+
+    /*
+     * Aim for a few tiles per thread so that uneven tiles still balance out.
+     */
+    context.tile_height = plutovg_clamp(surface->height / (num_threads * 4), MIN_TILE_HEIGHT, MAX_TILE_HEIGHT);
+    context.num_tiles = (surface->height + context.tile_height - 1) / context.tile_height;
+    num_threads = plutovg_min(num_threads, context.num_tiles);
+
+    plutovg_thread_t threads[MAX_THREADS];
+    int num_started = 0;
+    while(num_started < num_threads - 1 && plutovg_thread_create(&threads[num_started], plutovg_tile_worker, &context))
+        num_started++;
+    plutovg_tile_worker(&context);
+    for(int i = 0; i < num_started; i++)
+        plutovg_thread_join(threads[i]);
+    plutovg_mutex_destroy(&context.mutex);
+    plutovg_free(extents);
+
+    bool opaque = surface->opaque && context.opaque;
+    plutovg_surface_invalidate(surface);
+    if(opaque) {
+        surface->opaque = true;
+    }
+}
@@ -2,54 +2,260 @@
 #include "plutovg-utils.h"
 
 #define STB_IMAGE_WRITE_STATIC
+#define STBIW_MALLOC(size) plutovg_malloc(size)
+#define STBIW_REALLOC(ptr, size) plutovg_realloc(ptr, size)
+#define STBIW_FREE(ptr) plutovg_free(ptr)
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "plutovg-stb-image-write.h"
 
 #define STB_IMAGE_STATIC
+#define STBI_MALLOC(size) plutovg_malloc(size)
+#define STBI_REALLOC(ptr, size) plutovg_realloc(ptr, size)
+#define STBI_FREE(ptr) plutovg_free(ptr)
 #define STB_IMAGE_IMPLEMENTATION
 #include "plutovg-stb-image.h"
 
-static plutovg_surface_t* plutovg_surface_create_uninitialized(int width, int height)
+#include <limits.h>
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__APPLE__))
+#include <sys/mman.h>
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+
+#define PLUTOVG_SURFACE_ALIGNMENT 64
+
+/*
+ * Pixel buffers at least this large are mapped directly from the system instead of going
+ * through the allocator, so they come back page aligned and zero filled, and on Linux they
+ * are eligible for transparent huge pages. Define it to 0 to always use the allocator.
+ */
+#ifndef PLUTOVG_SURFACE_MMAP_THRESHOLD
+#define PLUTOVG_SURFACE_MMAP_THRESHOLD (4 * 1024 * 1024)
+#endif
+
+/*
+ * Sparse mappings only reserve address space: the system commits and zeroes each page the
+ * first time it is written, so memory is only spent where something is drawn. They skip the
+ * huge page advice, which would commit memory in much coarser chunks. Windows charges every
+ * committed page up front and only commits reserved pages on explicit request, so sparse
+ * mappings are not available there.
+ */
+static unsigned char* plutovg_surface_map(size_t size, bool sparse)
 {
-    static const int kMaxSize = 1 << 15;
-    if(width <= 0 || height <= 0 || width >= kMaxSize || height >= kMaxSize)
+#if defined(_WIN32)
+    if(sparse)
         return NULL;
-    const size_t size = width * height * 4;
-    plutovg_surface_t* surface = malloc(size + sizeof(plutovg_surface_t));
-    if(surface == NULL)
+    return VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#elif defined(MAP_ANONYMOUS)
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_NORESERVE)
+    if(sparse)
+        flags |= MAP_NORESERVE;
+#endif
+    void* data = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if(data == MAP_FAILED)
+        return NULL;
+#if defined(MADV_HUGEPAGE)
+    if(!sparse)
+        madvise(data, size, MADV_HUGEPAGE);
+#endif
+    return data;
+#else
+    return NULL;
+#endif
+}
+
+static void plutovg_surface_unmap(unsigned char* data, size_t size)
+{
+#if defined(_WIN32)
+    VirtualFree(data, 0, MEM_RELEASE);
+#elif defined(MAP_ANONYMOUS)
+    munmap(data, size);
+#endif
+}
+
+/*
+ * Zeroes the whole pixel buffer. Sparse buffers hand their pages back to the system where
+ * it guarantees they read back as zero, which keeps cleared virtual surfaces sparse; any
+ * other buffer is filled in place, so it keeps its committed and huge pages.
+ */
+static void plutovg_surface_zero(plutovg_surface_t* surface)
+{
+#if defined(__linux__) && defined(MADV_DONTNEED)
+    if(surface->sparse && madvise(surface->data, surface->mapped_size, MADV_DONTNEED) == 0)
+        return;
+#endif
+    const size_t size = (size_t)surface->stride * surface->height;
+    void(*memfill32)(unsigned int*, int, unsigned int) = plutovg_memfill32;
+    if(size >= plutovg_get_nontemporal_threshold())
+        memfill32 = plutovg_memfill32_stream;
+    for(int y = 0; y < surface->height; y++) {
+        memfill32((unsigned int*)(surface->data + (ptrdiff_t)surface->stride * y), surface->stride / 4, 0);
+    }
+}
+
+static plutovg_surface_t* plutovg_surface_create_internal(int width, int height, plutovg_format_t format, bool sparse)
+{
+    /*
+     * Rows start on a cache line boundary: the buffer is 64-byte aligned and the stride is
+     * padded to a multiple of 64 bytes, so no row shares a cache line with its neighbours.
+     * Sizes are only bounded by the stride fitting in an int and the buffer in a size_t.
+     */
+    const int bpp = plutovg_format_bytes_per_pixel(format);
+    if(width <= 0 || height <= 0 || width > (INT_MAX - PLUTOVG_SURFACE_ALIGNMENT) / bpp)
+        return NULL;
+    const int stride = (width * bpp + PLUTOVG_SURFACE_ALIGNMENT - 1) & ~(PLUTOVG_SURFACE_ALIGNMENT - 1);
+    if((size_t)height > (SIZE_MAX - sizeof(plutovg_surface_t) - PLUTOVG_SURFACE_ALIGNMENT) / stride)
         return NULL;
+    const size_t size = (size_t)stride * height;
+    unsigned char* data = NULL;
+    size_t mapped_size = 0;
+    if(sparse || (PLUTOVG_SURFACE_MMAP_THRESHOLD > 0 && size >= PLUTOVG_SURFACE_MMAP_THRESHOLD && plutovg_allocator_is_default())) {
+        if((data = plutovg_surface_map(size, sparse)) != NULL) {
+            mapped_size = size;
+        } else if(sparse) {
+            return NULL;
+        }
+    }
+
+    plutovg_surface_t* surface;
+    if(data == NULL) {
+        surface = plutovg_malloc(sizeof(plutovg_surface_t) + PLUTOVG_SURFACE_ALIGNMENT - 1 + size);
+        if(surface == NULL)
+            return NULL;
+        uintptr_t address = (uintptr_t)(surface + 1);
+        data = (unsigned char*)((address + PLUTOVG_SURFACE_ALIGNMENT - 1) & ~(uintptr_t)(PLUTOVG_SURFACE_ALIGNMENT - 1));
+    } else {
+        surface = plutovg_malloc(sizeof(plutovg_surface_t));
+        if(surface == NULL) {
+            plutovg_surface_unmap(data, mapped_size);
+            return NULL;
+        }
+    }
+
     plutovg_init_reference(surface);
     surface->width = width;
     surface->height = height;
-    surface->stride = width * 4;
-    surface->data = (uint8_t*)(surface + 1);
+    surface->stride = stride;
+    surface->origin_x = 0;
+    surface->origin_y = 0;
+    surface->format = format;
+    surface->data = data;
+    surface->mapped_size = mapped_size;
+    surface->sparse = sparse;
+    surface->parent = NULL;
+    surface->generation = 0;
+    surface->opaque = plutovg_format_is_opaque(format);
+    surface->external_data = false;
+    surface->data_exposed = false;
+    surface->mipmap_enabled = false;
+    surface->mipmap = NULL;
+    plutovg_mutex_init(&surface->mutex);
     return surface;
 }
 
+static plutovg_surface_t* plutovg_surface_create_uninitialized(int width, int height, plutovg_format_t format)
+{
+    return plutovg_surface_create_internal(width, height, format, false);
+}
+
 plutovg_surface_t* plutovg_surface_create(int width, int height)
 {
-    plutovg_surface_t* surface = plutovg_surface_create_uninitialized(width, height);
-    if(surface)
-        memset(surface->data, 0, surface->height * surface->stride);
+    return plutovg_surface_create_with_format(width, height, PLUTOVG_FORMAT_ARGB32);
+}
+
+plutovg_surface_t* plutovg_surface_create_with_format(int width, int height, plutovg_format_t format)
+{
+    plutovg_surface_t* surface = plutovg_surface_create_uninitialized(width, height, format);
+    if(surface && surface->mapped_size == 0)
+        memset(surface->data, 0, (size_t)surface->height * surface->stride);
     return surface;
 }
 
+plutovg_surface_t* plutovg_surface_create_virtual(int width, int height, plutovg_format_t format)
+{
+    return plutovg_surface_create_internal(width, height, format, true);
+}
+
 plutovg_surface_t* plutovg_surface_create_for_data(unsigned char* data, int width, int height, int stride)
 {
-    plutovg_surface_t* surface = malloc(sizeof(plutovg_surface_t));
+    return plutovg_surface_create_for_data_with_format(data, width, height, stride, PLUTOVG_FORMAT_ARGB32);
+}
+
+static plutovg_surface_t* plutovg_surface_create_view(unsigned char* data, int width, int height, int stride, plutovg_format_t format)
+{
+    plutovg_surface_t* surface = plutovg_malloc(sizeof(plutovg_surface_t));
+    if(surface == NULL)
+        return NULL;
     plutovg_init_reference(surface);
     surface->width = width;
     surface->height = height;
     surface->stride = stride;
+    surface->origin_x = 0;
+    surface->origin_y = 0;
+    surface->format = format;
     surface->data = data;
+    surface->mapped_size = 0;
+    surface->sparse = false;
+    surface->parent = NULL;
+    surface->generation = 0;
+    surface->opaque = plutovg_format_is_opaque(format);
+    surface->external_data = false;
+    surface->data_exposed = false;
+    surface->mipmap_enabled = false;
+    surface->mipmap = NULL;
+    plutovg_mutex_init(&surface->mutex);
     return surface;
 }
 
-static plutovg_surface_t* plutovg_surface_load_from_image(stbi_uc* image, int width, int height)
+plutovg_surface_t* plutovg_surface_create_for_data_with_format(unsigned char* data, int width, int height, int stride, plutovg_format_t format)
 {
-    plutovg_surface_t* surface = plutovg_surface_create_uninitialized(width, height);
+    plutovg_surface_t* surface = plutovg_surface_create_view(data, width, height, stride, format);
     if(surface)
-        plutovg_convert_rgba_to_argb(surface->data, image, surface->width, surface->height, surface->stride);
+        surface->external_data = true;
+    return surface;
+}
+
+plutovg_surface_t* plutovg_surface_create_sub(plutovg_surface_t* parent, int x, int y, int width, int height)
+{
+    if(width <= 0 || height <= 0 || x < 0 || y < 0 || x > parent->width - width || y > parent->height - height)
+        return NULL;
+    unsigned char* data = parent->data + (ptrdiff_t)parent->stride * y + (ptrdiff_t)x * plutovg_format_bytes_per_pixel(parent->format);
+    plutovg_surface_t* surface = plutovg_surface_create_view(data, width, height, parent->stride, parent->format);
+    if(surface == NULL)
+        return NULL;
+    surface->parent = plutovg_surface_reference(parent);
+    surface->opaque = parent->opaque;
+    return surface;
+}
+
+static bool plutovg_image_is_opaque(const stbi_uc* image, int width, int height, int channels)
+{
+    if(channels == 1 || channels == 3)
+        return true;
+    const stbi_uc* end = image + (size_t)width * height * 4;
+    for(const stbi_uc* pixel = image; pixel < end; pixel += 4) {
+        if(pixel[3] != 255) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static plutovg_surface_t* plutovg_surface_load_from_image(stbi_uc* image, int width, int height, int channels)
+{
+    plutovg_surface_t* surface = plutovg_surface_create_uninitialized(width, height, PLUTOVG_FORMAT_ARGB32);
+    if(surface) {
+        for(int y = 0; y < height; y++) {
+            plutovg_convert_rgba_to_argb(surface->data + (ptrdiff_t)surface->stride * y, image + (ptrdiff_t)width * 4 * y, width, 1, 0);
+        }
+
+        surface->opaque = plutovg_image_is_opaque(image, width, height, channels);
+    }
+
     stbi_image_free(image);
     return surface;
 }
@@ -60,7 +266,7 @@ plutovg_surface_t* plutovg_surface_load_from_image_file(const char* filename)
     stbi_uc* image = stbi_load(filename, &width, &height, &channels, STBI_rgb_alpha);
     if(image == NULL)
         return NULL;
-    return plutovg_surface_load_from_image(image, width, height);
+    return plutovg_surface_load_from_image(image, width, height, channels);
 }
 
 plutovg_surface_t* plutovg_surface_load_from_image_data(const void* data, int length)
@@ -69,7 +275,7 @@ plutovg_surface_t* plutovg_surface_load_from_image_data(const void* data, int le
     stbi_uc* image = stbi_load_from_memory(data, length, &width, &height, &channels, STBI_rgb_alpha);
     if(image == NULL)
         return NULL;
-    return plutovg_surface_load_from_image(image, width, height);
+    return plutovg_surface_load_from_image(image, width, height, channels);
 }
 
 static const uint8_t base64_table[128] = {
@@ -103,7 +309,7 @@ plutovg_surface_t* plutovg_surface_load_from_image_base64(const char* data, int
 
     if(length == -1)
         length = strlen(data);
-    output_data = malloc(length);
+    output_data = plutovg_malloc(length);
     if(output_data == NULL)
         return NULL;
     for(int i = 0; i < length; ++i) {
@@ -144,7 +350,7 @@ plutovg_surface_t* plutovg_surface_load_from_image_base64(const char* data, int
 
     surface = plutovg_surface_load_from_image_data(output_data, output_length);
 cleanup:
-    free(output_data);
+    plutovg_free(output_data);
     return surface;
 }
 
@@ -157,7 +363,12 @@ plutovg_surface_t* plutovg_surface_reference(plutovg_surface_t* surface)
 void plutovg_surface_destroy(plutovg_surface_t* surface)
 {
     if(plutovg_destroy_reference(surface)) {
-        free(surface);
+        plutovg_mipmap_destroy(surface->mipmap);
+        plutovg_mutex_destroy(&surface->mutex);
+        if(surface->mapped_size > 0)
+            plutovg_surface_unmap(surface->data, surface->mapped_size);
+        plutovg_surface_destroy(surface->parent);
+        plutovg_free(surface);
     }
 }
 
@@ -168,6 +379,11 @@ int plutovg_surface_get_reference_count(const plutovg_surface_t* surface)
 
 unsigned char* plutovg_surface_get_data(const plutovg_surface_t* surface)
 {
+    /*
+     * The caller may write through the returned pointer, so nothing derived from the
+     * pixels is trusted until plutovg_surface_mark_dirty() says they are up to date.
+     */
+    ((plutovg_surface_t*)(surface))->data_exposed = true;
     return surface->data;
 }
 
@@ -186,13 +402,93 @@ int plutovg_surface_get_stride(const plutovg_surface_t* surface)
     return surface->stride;
 }
 
+plutovg_format_t plutovg_surface_get_format(const plutovg_surface_t* surface)
+{
+    return surface->format;
+}
+
 void plutovg_surface_clear(plutovg_surface_t* surface, const plutovg_color_t* color)
 {
     uint32_t pixel = plutovg_premultiply_argb(plutovg_color_to_argb32(color));
+    if(pixel == 0 && surface->sparse && (surface->format == PLUTOVG_FORMAT_ARGB32 || surface->format == PLUTOVG_FORMAT_A8)) {
+        plutovg_surface_zero(surface);
+        plutovg_surface_invalidate(surface);
+        return;
+    }
+
+    if(surface->format == PLUTOVG_FORMAT_A8) {
+        if(surface->stride == surface->width) {
+            memset(surface->data, plutovg_alpha(pixel), (size_t)surface->stride * surface->height);
+        } else {
+            for(int y = 0; y < surface->height; y++) {
+                memset(surface->data + (ptrdiff_t)surface->stride * y, plutovg_alpha(pixel), surface->width);
+            }
+        }
+
+        plutovg_surface_invalidate(surface);
+        surface->opaque = plutovg_alpha(pixel) == 255;
+        return;
+    }
+
+    if(surface->format == PLUTOVG_FORMAT_RGB565) {
+        for(int y = 0; y < surface->height; y++) {
+            uint16_t* pixels = (uint16_t*)(surface->data + (ptrdiff_t)surface->stride * y);
+            uint16_t pattern[4];
+            for(int x = 0; x < 4; x++)
+                pattern[x] = plutovg_argb_to_rgb565(pixel, plutovg_rgb565_dither(x, y));
+            for(int x = 0; x < surface->width; x++) {
+                pixels[x] = pattern[x & 3];
+            }
+        }
+
+        plutovg_surface_invalidate(surface);
+        return;
+    }
+
+    if(surface->format == PLUTOVG_FORMAT_XRGB32)
+        pixel |= 0xff000000;
+    size_t size = (size_t)surface->stride * surface->height;
+    void(*memfill32)(unsigned int*, int, unsigned int) = plutovg_memfill32;
+    if(size >= plutovg_get_nontemporal_threshold())
+        memfill32 = plutovg_memfill32_stream;
     for(int y = 0; y < surface->height; y++) {
-        uint32_t* pixels = (uint32_t*)(surface->data + surface->stride * y);
-        plutovg_memfill32(pixels, surface->width, pixel);
+        uint32_t* pixels = (uint32_t*)(surface->data + (ptrdiff_t)surface->stride * y);
+        memfill32(pixels, surface->width, pixel);
+    }
+
+    plutovg_surface_invalidate(surface);
+    if(plutovg_alpha(pixel) == 255) {
+        surface->opaque = true;
+    }
+}
+
+void plutovg_surface_set_mipmap_enabled(plutovg_surface_t* surface, bool enabled)
+{
+    plutovg_mutex_lock(&surface->mutex);
+    if(surface->mipmap_enabled != enabled) {
+        plutovg_mipmap_destroy(surface->mipmap);
+        surface->mipmap = NULL;
     }
+
+    surface->mipmap_enabled = enabled;
+    plutovg_mutex_unlock(&surface->mutex);
+}
+
+bool plutovg_surface_get_mipmap_enabled(const plutovg_surface_t* surface)
+{
+    return surface->mipmap_enabled;
+}
+
+void plutovg_surface_invalidate(plutovg_surface_t* surface)
+{
+    surface->generation++;
+    surface->opaque = plutovg_format_is_opaque(surface->format);
+}
+
+void plutovg_surface_mark_dirty(plutovg_surface_t* surface)
+{
+    plutovg_surface_invalidate(surface);
+    surface->data_exposed = false;
 }
 
 static void plutovg_surface_write_begin(const plutovg_surface_t* surface)
@@ -205,8 +501,111 @@ static void plutovg_surface_write_end(const plutovg_surface_t* surface)
     plutovg_convert_rgba_to_argb(surface->data, surface->data, surface->width, surface->height, surface->stride);
 }
 
+/*
+ * Non-ARGB surfaces are written from a tightly packed copy: alpha-only surfaces as
+ * single-channel grayscale images and opaque formats as RGB images.
+ */
+static unsigned char* plutovg_surface_pack(const plutovg_surface_t* surface, int* channels)
+{
+    *channels = surface->format == PLUTOVG_FORMAT_A8 ? 1 : 3;
+    if(surface->format == PLUTOVG_FORMAT_A8 && surface->stride == surface->width)
+        return surface->data;
+    unsigned char* data = plutovg_malloc((size_t)surface->width * surface->height * *channels);
+    if(data == NULL)
+        return NULL;
+    unsigned char* dest = data;
+    for(int y = 0; y < surface->height; y++) {
+        const unsigned char* row = surface->data + (ptrdiff_t)surface->stride * y;
+        if(surface->format == PLUTOVG_FORMAT_A8) {
+            memcpy(dest, row, surface->width);
+            dest += surface->width;
+            continue;
+        }
+
+        for(int x = 0; x < surface->width; x++) {
+            uint32_t pixel;
+            if(surface->format == PLUTOVG_FORMAT_RGB565) {
+                pixel = plutovg_rgb565_to_argb(((const uint16_t*)(row))[x]);
+            } else {
+                pixel = ((const uint32_t*)(row))[x];
+            }
+
+            *dest++ = plutovg_red(pixel);
+            *dest++ = plutovg_green(pixel);
+            *dest++ = plutovg_blue(pixel);
+        }
+    }
+
+    return data;
+}
+
+static bool plutovg_surface_write_packed(const plutovg_surface_t* surface, plutovg_write_func_t write_func, void* closure, const char* filename, bool jpg, int quality)
+{
+    int channels;
+    unsigned char* data = plutovg_surface_pack(surface, &channels);
+    if(data == NULL)
+        return false;
+    const int stride = surface->width * channels;
+    int success;
+    if(!jpg) {
+        if(write_func) {
+            success = stbi_write_png_to_func(write_func, closure, surface->width, surface->height, channels, data, stride);
+        } else {
+            success = stbi_write_png(filename, surface->width, surface->height, channels, data, stride);
+        }
+    } else if(write_func) {
+        success = stbi_write_jpg_to_func(write_func, closure, surface->width, surface->height, channels, data, quality);
+    } else {
+        success = stbi_write_jpg(filename, surface->width, surface->height, channels, data, quality);
+    }
+
+    if(data != surface->data)
+        plutovg_free(data);
+    return success;
+}
+
+/*
+ * The JPEG writer takes no stride, so surfaces with padded rows are written from a tightly
+ * packed RGBA copy instead of being converted in place.
+ */
+static bool plutovg_surface_write_jpg(const plutovg_surface_t* surface, plutovg_write_func_t write_func, void* closure, const char* filename, int quality)
+{
+    const int stride = surface->width * 4;
+    if(surface->stride == stride) {
+        plutovg_surface_write_begin(surface);
+        int success;
+        if(write_func) {
+            success = stbi_write_jpg_to_func(write_func, closure, surface->width, surface->height, 4, surface->data, quality);
+        } else {
+            success = stbi_write_jpg(filename, surface->width, surface->height, 4, surface->data, quality);
+        }
+
+        plutovg_surface_write_end(surface);
+        return success;
+    }
+
+    unsigned char* data = plutovg_malloc((size_t)stride * surface->height);
+    if(data == NULL)
+        return false;
+    for(int y = 0; y < surface->height; y++) {
+        plutovg_convert_argb_to_rgba(data + (ptrdiff_t)stride * y, surface->data + (ptrdiff_t)surface->stride * y, surface->width, 1, stride);
+    }
+
+    int success;
+    if(write_func) {
+        success = stbi_write_jpg_to_func(write_func, closure, surface->width, surface->height, 4, data, quality);
+    } else {
+        success = stbi_write_jpg(filename, surface->width, surface->height, 4, data, quality);
+    }
+
+    plutovg_free(data);
+    return success;
+}
+
 bool plutovg_surface_write_to_png(const plutovg_surface_t* surface, const char* filename)
 {
+    if(surface->format != PLUTOVG_FORMAT_ARGB32)
+        return plutovg_surface_write_packed(surface, NULL, NULL, filename, false, 0);
     plutovg_surface_write_begin(surface);
     int success = stbi_write_png(filename, surface->width, surface->height, 4, surface->data, surface->stride);
     plutovg_surface_write_end(surface);
@@ -215,14 +614,15 @@ bool plutovg_surface_write_to_png(const plutovg_surface_t* surface, const char*
 
 bool plutovg_surface_write_to_jpg(const plutovg_surface_t* surface, const char* filename, int quality)
 {
-    plutovg_surface_write_begin(surface);
-    int success = stbi_write_jpg(filename, surface->width, surface->height, 4, surface->data, quality);
-    plutovg_surface_write_end(surface);
-    return success;
+    if(surface->format != PLUTOVG_FORMAT_ARGB32)
+        return plutovg_surface_write_packed(surface, NULL, NULL, filename, true, quality);
+    return plutovg_surface_write_jpg(surface, NULL, NULL, filename, quality);
 }
 
 bool plutovg_surface_write_to_png_stream(const plutovg_surface_t* surface, plutovg_write_func_t write_func, void* closure)
 {
+    if(surface->format != PLUTOVG_FORMAT_ARGB32)
+        return plutovg_surface_write_packed(surface, write_func, closure, NULL, false, 0);
     plutovg_surface_write_begin(surface);
     int success = stbi_write_png_to_func(write_func, closure, surface->width, surface->height, 4, surface->data, surface->stride);
     plutovg_surface_write_end(surface);
@@ -231,17 +631,186 @@ bool plutovg_surface_write_to_png_stream(const plutovg_surface_t* surface, pluto
 
 bool plutovg_surface_write_to_jpg_stream(const plutovg_surface_t* surface, plutovg_write_func_t write_func, void* closure, int quality)
 {
-    plutovg_surface_write_begin(surface);
-    int success = stbi_write_jpg_to_func(write_func, closure, surface->width, surface->height, 4, surface->data, quality);
-    plutovg_surface_write_end(surface);
-    return success;
+    if(surface->format != PLUTOVG_FORMAT_ARGB32)
+        return plutovg_surface_write_packed(surface, write_func, closure, NULL, true, quality);
+    return plutovg_surface_write_jpg(surface, write_func, closure, NULL, quality);
+}
+
+struct plutovg_surface_pool {
+    plutovg_ref_count_t ref_count;
+    plutovg_mutex_t mutex;
+    struct {
+        plutovg_surface_t** data;
+        int size;
+        int capacity;
+    } surfaces;
+
+    size_t size;
+    size_t limit;
+};
+
+static size_t plutovg_surface_pool_bytes(const plutovg_surface_t* surface)
+{
+    return (size_t)surface->stride * surface->height;
+}
+
+/*
+ * Only surfaces whose pixel memory was allocated along with them can be recycled;
+ * anything wrapping caller-provided memory is released instead.
+ */
+static bool plutovg_surface_owns_data(const plutovg_surface_t* surface)
+{
+    if(surface->mapped_size > 0)
+        return true;
+    uintptr_t address = (uintptr_t)(surface + 1);
+    address = (address + PLUTOVG_SURFACE_ALIGNMENT - 1) & ~(uintptr_t)(PLUTOVG_SURFACE_ALIGNMENT - 1);
+    return surface->data == (unsigned char*)address;
+}
+
+static void plutovg_surface_pool_trim_locked(plutovg_surface_pool_t* pool, size_t size)
+{
+    int count = 0;
+    while(count < pool->surfaces.size && pool->size > size) {
+        plutovg_surface_t* surface = pool->surfaces.data[count++];
+        pool->size -= plutovg_surface_pool_bytes(surface);
+        plutovg_surface_destroy(surface);
+    }
+
+    if(count > 0) {
+        pool->surfaces.size -= count;
+        memmove(pool->surfaces.data, pool->surfaces.data + count, pool->surfaces.size * sizeof(plutovg_surface_t*));
+    }
+}
+
+plutovg_surface_pool_t* plutovg_surface_pool_create(size_t limit)
+{
+    plutovg_surface_pool_t* pool = plutovg_malloc(sizeof(plutovg_surface_pool_t));
+    plutovg_init_reference(pool);
+    plutovg_mutex_init(&pool->mutex);
+    plutovg_array_init(pool->surfaces);
+    pool->size = 0;
+    pool->limit = limit;
+    return pool;
+}
+
+plutovg_surface_pool_t* plutovg_surface_pool_reference(plutovg_surface_pool_t* pool)
+{
+    plutovg_increment_reference(pool);
+    return pool;
+}
+
+void plutovg_surface_pool_destroy(plutovg_surface_pool_t* pool)
+{
+    if(plutovg_destroy_reference(pool)) {
+        plutovg_surface_pool_trim_locked(pool, 0);
+        plutovg_array_destroy(pool->surfaces);
+        plutovg_mutex_destroy(&pool->mutex);
+        plutovg_free(pool);
+    }
+}
+
+int plutovg_surface_pool_get_reference_count(const plutovg_surface_pool_t* pool)
+{
+    return plutovg_get_reference_count(pool);
+}
+
+plutovg_surface_t* plutovg_surface_pool_acquire(plutovg_surface_pool_t* pool, int width, int height, plutovg_format_t format, bool clear)
+{
+    plutovg_surface_t* surface = NULL;
+    plutovg_mutex_lock(&pool->mutex);
+    for(int i = pool->surfaces.size - 1; i >= 0; i--) {
+        plutovg_surface_t* candidate = pool->surfaces.data[i];
+        if(candidate->width == width && candidate->height == height && candidate->format == format) {
+            pool->surfaces.size -= 1;
+            memmove(pool->surfaces.data + i, pool->surfaces.data + i + 1, (pool->surfaces.size - i) * sizeof(plutovg_surface_t*));
+            pool->size -= plutovg_surface_pool_bytes(candidate);
+            surface = candidate;
+            break;
+        }
+    }
+
+    plutovg_mutex_unlock(&pool->mutex);
+    if(surface == NULL) {
+        if(clear)
+            return plutovg_surface_create_with_format(width, height, format);
+        return plutovg_surface_create_uninitialized(width, height, format);
+    }
+
+    if(clear) {
+        plutovg_surface_zero(surface);
+        plutovg_surface_mark_dirty(surface);
+    }
+
+    return surface;
+}
+
+void plutovg_surface_pool_release(plutovg_surface_pool_t* pool, plutovg_surface_t* surface)
+{
+    if(surface == NULL)
+        return;
+    if(plutovg_get_reference_count(surface) != 1 || !plutovg_surface_owns_data(surface)) {
+        plutovg_surface_destroy(surface);
+        return;
+    }
+
+    /*
+     * Bumping the generation makes any cache keyed on this surface treat the next
+     * user's pixels as new content.
+     */
+    plutovg_surface_set_mipmap_enabled(surface, false);
+    plutovg_surface_mark_dirty(surface);
+
+    const size_t bytes = plutovg_surface_pool_bytes(surface);
+    plutovg_mutex_lock(&pool->mutex);
+    if(bytes > pool->limit) {
+        plutovg_mutex_unlock(&pool->mutex);
+        plutovg_surface_destroy(surface);
+        return;
+    }
+
+    plutovg_surface_pool_trim_locked(pool, pool->limit - bytes);
+    plutovg_array_ensure(pool->surfaces, 1);
+    pool->surfaces.data[pool->surfaces.size++] = surface;
+    pool->size += bytes;
+    plutovg_mutex_unlock(&pool->mutex);
+}
+
+void plutovg_surface_pool_trim(plutovg_surface_pool_t* pool, size_t size)
+{
+    plutovg_mutex_lock(&pool->mutex);
+    plutovg_surface_pool_trim_locked(pool, size);
+    plutovg_mutex_unlock(&pool->mutex);
+}
+
+void plutovg_surface_pool_set_limit(plutovg_surface_pool_t* pool, size_t limit)
+{
+    plutovg_mutex_lock(&pool->mutex);
+    pool->limit = limit;
+    plutovg_surface_pool_trim_locked(pool, limit);
+    plutovg_mutex_unlock(&pool->mutex);
+}
+
+size_t plutovg_surface_pool_get_limit(const plutovg_surface_pool_t* pool)
+{
+    plutovg_mutex_lock((plutovg_mutex_t*)&pool->mutex);
+    size_t limit = pool->limit;
+    plutovg_mutex_unlock((plutovg_mutex_t*)&pool->mutex);
+    return limit;
+}
+
+size_t plutovg_surface_pool_get_size(const plutovg_surface_pool_t* pool)
+{
+    plutovg_mutex_lock((plutovg_mutex_t*)&pool->mutex);
+    size_t size = pool->size;
+    plutovg_mutex_unlock((plutovg_mutex_t*)&pool->mutex);
+    return size;
 }
 
 void plutovg_convert_argb_to_rgba(unsigned char* dst, const unsigned char* src, int width, int height, int stride)
 {
     for(int y = 0; y < height; y++) {
-        const uint32_t* src_row = (const uint32_t*)(src + stride * y);
-        unsigned char* dst_row = dst + stride * y;
+        const uint32_t* src_row = (const uint32_t*)(src + (ptrdiff_t)stride * y);
+        unsigned char* dst_row = dst + (ptrdiff_t)stride * y;
         for(int x = 0; x < width; x++) {
             uint32_t pixel = src_row[x];
             uint32_t a = (pixel >> 24) & 0xFF;
@@ -272,8 +841,8 @@ void plutovg_convert_argb_to_rgba(unsigned char* dst, const unsigned char* src,
 void plutovg_convert_rgba_to_argb(unsigned char* dst, const unsigned char* src, int width, int height, int stride)
 {
     for(int y = 0; y < height; y++) {
-        const unsigned char* src_row = src + stride * y;
-        uint32_t* dst_row = (uint32_t*)(dst + stride * y);
+        const unsigned char* src_row = src + (ptrdiff_t)stride * y;
+        uint32_t* dst_row = (uint32_t*)(dst + (ptrdiff_t)stride * y);
         for(int x = 0; x < width; x++) {
             uint32_t a = src_row[4 * x + 3];
             if(a == 0) {
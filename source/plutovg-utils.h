@@ -14,6 +14,12 @@
 #define PLUTOVG_IS_ALNUM(c) (PLUTOVG_IS_ALPHA(c) || PLUTOVG_IS_NUM(c))
 #define PLUTOVG_IS_WS(c) ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
 
+void* plutovg_malloc(size_t size);
+void* plutovg_calloc(size_t count, size_t size);
+void* plutovg_realloc(void* ptr, size_t size);
+void plutovg_free(void* ptr);
+bool plutovg_allocator_is_default(void);
+
 #define plutovg_min(a, b) ((a) < (b) ? (a) : (b))
 #define plutovg_max(a, b) ((a) > (b) ? (a) : (b))
 #define plutovg_clamp(v, lo, hi) ((v) < (lo) ? (lo) : ((v) > (hi) ? (hi) : (v)))
@@ -36,7 +42,7 @@
             int capacity = (array).size + (count); \
             int newcapacity = (array).capacity == 0 ? 8 : (array).capacity; \
             while(newcapacity < capacity) { newcapacity *= 2; } \
-            (array).data = realloc((array).data, newcapacity * sizeof((array).data[0])); \
+            (array).data = plutovg_realloc((array).data, newcapacity * sizeof((array).data[0])); \
             (array).capacity = newcapacity; \
         } \
     } while(0)
@@ -52,7 +58,7 @@
 
 #define plutovg_array_append(array, other) plutovg_array_append_data(array, (other).data, (other).size)
 #define plutovg_array_clear(array) ((array).size = 0)
-#define plutovg_array_destroy(array) free((array).data)
+#define plutovg_array_destroy(array) plutovg_free((array).data)
 
 static inline uint32_t plutovg_premultiply_argb(uint32_t color)
 {
@@ -69,6 +75,44 @@ static inline uint32_t plutovg_premultiply_argb(uint32_t color)
     return (a << 24) | (r << 16) | (g << 8) | (b);
 }
 
+static inline uint32_t plutovg_rgb565_to_argb(uint16_t pixel)
+{
+    uint32_t r = (pixel >> 11) & 0x1f;
+    uint32_t g = (pixel >> 5) & 0x3f;
+    uint32_t b = (pixel >> 0) & 0x1f;
+    r = (r << 3) | (r >> 2);
+    g = (g << 2) | (g >> 4);
+    b = (b << 3) | (b >> 2);
+    return 0xff000000 | (r << 16) | (g << 8) | (b);
+}
+
+/*
+ * Ordered dithering for RGB565 stores: `dither` is the 4x4 Bayer threshold (0-7) of the pixel.
+ * Subtracting the top bits first keeps every pixel expanded by plutovg_rgb565_to_argb unchanged.
+ */
+static inline uint32_t plutovg_rgb565_dither(int x, int y)
+{
+    static const uint8_t matrix[4][4] = {
+        {0, 4, 1, 5},
+        {6, 2, 7, 3},
+        {1, 5, 0, 4},
+        {7, 3, 6, 2}
+    };
+
+    return matrix[y & 3][x & 3];
+}
+
+static inline uint16_t plutovg_argb_to_rgb565(uint32_t pixel, uint32_t dither)
+{
+    uint32_t r = plutovg_red(pixel);
+    uint32_t g = plutovg_green(pixel);
+    uint32_t b = plutovg_blue(pixel);
+    r = (r + dither - (r >> 5)) >> 3;
+    g = (g + (dither >> 1) - (g >> 6)) >> 2;
+    b = (b + dither - (b >> 5)) >> 3;
+    return (uint16_t)((r << 11) | (g << 5) | (b));
+}
+
 static inline bool plutovg_parse_number(const char** begin, const char* end, float* number)
 {
     const char* it = *begin;
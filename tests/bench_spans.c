@@ -0,0 +1,117 @@
+/*
+ * Measures the cost of compositing short full-coverage spans for each paint kind, to
+ * back the SHORT_SPAN_LENGTH threshold in plutovg-blend.c: solid spans shorter than it
+ * are composited inline, longer ones by the dispatched kernels. To find the crossover,
+ * build the library with -DSHORT_SPAN_LENGTH=1 (kernels only) and with a large value
+ * (inline only) and compare the timings per span length. Gradients and textures show
+ * the kernels alone, for comparison with the solid column.
+ *
+ * Usage: bench_spans [iterations]
+ */
+
+#include <plutovg.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define SURFACE_SIZE 1024
+#define MAX_LENGTH 24
+
+typedef void(*set_paint_function_t)(plutovg_canvas_t* canvas, plutovg_surface_t* texture);
+
+static void set_solid(plutovg_canvas_t* canvas, plutovg_surface_t* texture)
+{
+    (void)texture;
+    plutovg_canvas_set_rgba(canvas, 0.2f, 0.5f, 0.8f, 0.6f);
+}
+
+static void set_gradient(plutovg_canvas_t* canvas, plutovg_surface_t* texture)
+{
+    static const plutovg_gradient_stop_t stops[] = {
+        {0.f, {1.f, 0.f, 0.f, 0.5f}},
+        {1.f, {0.f, 0.f, 1.f, 0.9f}}
+    };
+
+    (void)texture;
+    plutovg_canvas_set_linear_gradient(canvas, 0, 0, SURFACE_SIZE, SURFACE_SIZE, PLUTOVG_SPREAD_METHOD_PAD, stops, 2, NULL);
+}
+
+static void set_texture(plutovg_canvas_t* canvas, plutovg_surface_t* texture)
+{
+    plutovg_canvas_set_texture(canvas, texture, PLUTOVG_TEXTURE_TYPE_TILED, 1.f, NULL);
+}
+
+static void set_transformed_texture(plutovg_canvas_t* canvas, plutovg_surface_t* texture)
+{
+    plutovg_matrix_t matrix;
+    plutovg_matrix_init_scale(&matrix, 1.5f, 1.5f);
+    plutovg_canvas_set_texture(canvas, texture, PLUTOVG_TEXTURE_TYPE_TILED, 1.f, &matrix);
+}
+
+static const struct {
+    const char* name;
+    set_paint_function_t set_paint;
+} paints[] = {
+    {"solid", set_solid},
+    {"gradient", set_gradient},
+    {"texture", set_texture},
+    {"transformed", set_transformed_texture}
+};
+
+#define NUM_PAINTS (int)(sizeof(paints) / sizeof(paints[0]))
+
+int main(int argc, char* argv[])
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 20;
+    if(iterations < 1)
+        iterations = 1;
+
+    plutovg_surface_t* texture = plutovg_surface_create(256, 256);
+    plutovg_canvas_t* canvas = plutovg_canvas_create(texture);
+    plutovg_canvas_set_rgba(canvas, 0.9f, 0.4f, 0.1f, 0.7f);
+    plutovg_canvas_paint(canvas);
+    plutovg_canvas_destroy(canvas);
+
+    plutovg_surface_t* surface = plutovg_surface_create(SURFACE_SIZE, SURFACE_SIZE);
+    canvas = plutovg_canvas_create(surface);
+
+    printf("ns per span, SRC_OVER, full coverage\n%6s", "length");
+    for(int i = 0; i < NUM_PAINTS; i++)
+        printf(" %12s", paints[i].name);
+    printf("\n");
+
+    for(int length = 1; length <= MAX_LENGTH; length++) {
+        /*
+         * Clip to pixel-aligned columns `length` wide with a one pixel gap: every row of
+         * every column is one full-coverage span of exactly `length` pixels. Painting
+         * blends the clip spans directly, so rasterization stays out of the timings.
+         */
+        plutovg_canvas_save(canvas);
+        int columns = 0;
+        for(int x = 0; x + length <= SURFACE_SIZE; x += length + 1) {
+            plutovg_canvas_rect(canvas, x, 0, length, SURFACE_SIZE);
+            columns++;
+        }
+
+        plutovg_canvas_clip(canvas);
+
+        printf("%6d", length);
+        for(int i = 0; i < NUM_PAINTS; i++) {
+            paints[i].set_paint(canvas, texture);
+            clock_t start = clock();
+            for(int j = 0; j < iterations; j++)
+                plutovg_canvas_paint(canvas);
+            double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+            printf(" %12.2f", elapsed * 1e9 / ((double)iterations * columns * SURFACE_SIZE));
+        }
+
+        printf("\n");
+        plutovg_canvas_restore(canvas);
+    }
+
+    plutovg_canvas_destroy(canvas);
+    plutovg_surface_destroy(surface);
+    plutovg_surface_destroy(texture);
+    return 0;
+}
@@ -0,0 +1,68 @@
+#ifndef PLUTOVG_TEST_H
+#define PLUTOVG_TEST_H
+
+#include <plutovg.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int test_failures = 0;
+
+#define CHECK(expr) \
+    do { \
+        if(!(expr)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+            test_failures++; \
+        } \
+    } while(0)
+
+#define TEST_RESULT() (test_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE)
+
+static inline int bytes_per_pixel(plutovg_format_t format)
+{
+    switch(format) {
+    case PLUTOVG_FORMAT_A8:
+        return 1;
+    case PLUTOVG_FORMAT_RGB565:
+        return 2;
+    default:
+        return 4;
+    }
+}
+
+/* Returns true if both surfaces have the same size, format and pixels. */
+static inline bool same_pixels(const plutovg_surface_t* a, const plutovg_surface_t* b)
+{
+    const int width = plutovg_surface_get_width(a);
+    const int height = plutovg_surface_get_height(a);
+    const plutovg_format_t format = plutovg_surface_get_format(a);
+    if(plutovg_surface_get_format(b) != format || plutovg_surface_get_width(b) != width || plutovg_surface_get_height(b) != height)
+        return false;
+    for(int y = 0; y < height; y++) {
+        const unsigned char* row_a = plutovg_surface_get_data(a) + y * plutovg_surface_get_stride(a);
+        const unsigned char* row_b = plutovg_surface_get_data(b) + y * plutovg_surface_get_stride(b);
+        if(memcmp(row_a, row_b, width * bytes_per_pixel(format))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Fills an ARGB32 surface with opaque pixels that differ from their neighbours. */
+static inline void fill_pattern(plutovg_surface_t* surface)
+{
+    const int width = plutovg_surface_get_width(surface);
+    const int height = plutovg_surface_get_height(surface);
+    for(int y = 0; y < height; y++) {
+        unsigned int* row = (unsigned int*)(plutovg_surface_get_data(surface) + y * plutovg_surface_get_stride(surface));
+        for(int x = 0; x < width; x++) {
+            row[x] = 0xff000000 | ((x * 2654435761u + y * 40503u) >> 8);
+        }
+    }
+
+    plutovg_surface_mark_dirty(surface);
+}
+
+#endif // PLUTOVG_TEST_H
@@ -0,0 +1,118 @@
+#include "test.h"
+
+#include <string.h>
+
+typedef struct {
+    long allocations;
+    long frees;
+} allocation_counter_t;
+
+static void* counting_malloc(size_t size, void* user_data)
+{
+    allocation_counter_t* counter = user_data;
+    void* ptr = malloc(size);
+    if(ptr)
+        counter->allocations++;
+    return ptr;
+}
+
+static void* counting_realloc(void* ptr, size_t size, void* user_data)
+{
+    allocation_counter_t* counter = user_data;
+    void* newptr = realloc(ptr, size);
+    if(ptr == NULL && newptr)
+        counter->allocations++;
+    return newptr;
+}
+
+static void counting_free(void* ptr, void* user_data)
+{
+    allocation_counter_t* counter = user_data;
+    counter->frees++;
+    free(ptr);
+}
+
+static void draw_shapes(plutovg_canvas_t* canvas)
+{
+    static const float dashes[] = {6.f, 3.f};
+
+    plutovg_canvas_set_rgb(canvas, 0.2f, 0.4f, 0.8f);
+    plutovg_canvas_rect(canvas, 10, 10, 100, 80);
+    plutovg_canvas_fill(canvas);
+
+    plutovg_canvas_set_rgba(canvas, 0.9f, 0.1f, 0.1f, 0.7f);
+    plutovg_canvas_set_line_width(canvas, 4.f);
+    plutovg_canvas_circle(canvas, 128, 128, 60);
+    plutovg_canvas_stroke(canvas);
+
+    plutovg_canvas_set_dash_array(canvas, dashes, 2);
+    plutovg_canvas_move_to(canvas, 20, 200);
+    plutovg_canvas_cubic_to(canvas, 80, 120, 160, 280, 240, 200);
+    plutovg_canvas_stroke(canvas);
+    plutovg_canvas_set_dash_array(canvas, NULL, 0);
+
+    plutovg_canvas_save(canvas);
+    plutovg_canvas_rect(canvas, 40, 40, 160, 160);
+    plutovg_canvas_clip(canvas);
+    plutovg_canvas_set_rgba(canvas, 0.1f, 0.8f, 0.1f, 0.5f);
+    plutovg_canvas_ellipse(canvas, 128, 128, 90, 50);
+    plutovg_canvas_fill(canvas);
+    plutovg_canvas_restore(canvas);
+}
+
+static void draw_scene(plutovg_canvas_t* canvas)
+{
+    draw_shapes(canvas);
+    plutovg_canvas_save(canvas);
+    plutovg_canvas_rect(canvas, 40, 40, 160, 160);
+    plutovg_canvas_clip(canvas);
+    plutovg_canvas_set_linear_gradient(canvas, 0, 0, 256, 256, PLUTOVG_SPREAD_METHOD_PAD, (const plutovg_gradient_stop_t[]) {
+        {0.f, {1, 0, 0, 1}}, {1.f, {0, 0, 1, 0.5f}}
+    }, 2, NULL);
+    plutovg_canvas_ellipse(canvas, 128, 128, 90, 50);
+    plutovg_canvas_fill(canvas);
+    plutovg_canvas_restore(canvas);
+}
+
+/*
+ * Every allocation plutovg makes goes through the installed hooks and is released
+ * through them again, and warmed-up canvases draw without allocating at all.
+ */
+int main(void)
+{
+    allocation_counter_t counter = {0, 0};
+    const plutovg_allocator_t allocator = {counting_malloc, counting_realloc, counting_free, &counter};
+    plutovg_set_allocator(&allocator);
+
+    plutovg_surface_t* surface = plutovg_surface_create(256, 256);
+    plutovg_canvas_t* canvas = plutovg_canvas_create(surface);
+    draw_scene(canvas);
+    CHECK(counter.allocations > 0);
+
+    draw_shapes(canvas);
+    long allocations = counter.allocations;
+    draw_shapes(canvas);
+    CHECK(counter.allocations == allocations);
+
+    plutovg_canvas_t* recording = plutovg_canvas_create_recording(256, 256);
+    draw_scene(recording);
+    plutovg_canvas_push_group(recording);
+    draw_scene(recording);
+    plutovg_canvas_pop_group(recording, 0.5f, PLUTOVG_OPERATOR_SRC_OVER);
+    plutovg_display_list_t* display_list = plutovg_canvas_finish_recording(recording);
+    CHECK(display_list != NULL);
+
+    plutovg_canvas_draw_display_list(canvas, display_list, NULL);
+    plutovg_surface_draw_display_list(surface, display_list, NULL, 4);
+
+    plutovg_display_list_destroy(display_list);
+    plutovg_canvas_destroy(recording);
+    plutovg_canvas_destroy(canvas);
+    plutovg_surface_destroy(surface);
+
+    CHECK(counter.allocations == counter.frees);
+    plutovg_set_allocator(NULL);
+    if(counter.allocations != counter.frees)
+        fprintf(stderr, "%ld allocations, %ld frees\n", counter.allocations, counter.frees);
+    return TEST_RESULT();
+}
@@ -0,0 +1,187 @@
+#include "test.h"
+
+#define WIDTH 96
+#define HEIGHT 80
+
+/*
+ * The SIMD kernels compute radial gradients with vector float math whose rounding
+ * differs from the scalar code, so levels may disagree by one unit per channel; every
+ * other paint and operator is expected to match exactly.
+ */
+#define TOLERANCE 1
+
+/* Returns the largest per-channel difference, in the format's own channel units. */
+static int max_difference(const plutovg_surface_t* a, const plutovg_surface_t* b)
+{
+    static const int rgb565_shifts[3] = {11, 5, 0};
+    static const unsigned int rgb565_masks[3] = {0x1f, 0x3f, 0x1f};
+
+    const plutovg_format_t format = plutovg_surface_get_format(a);
+    int difference = 0;
+    for(int y = 0; y < HEIGHT; y++) {
+        const unsigned char* row_a = plutovg_surface_get_data(a) + y * plutovg_surface_get_stride(a);
+        const unsigned char* row_b = plutovg_surface_get_data(b) + y * plutovg_surface_get_stride(b);
+        for(int x = 0; x < WIDTH; x++) {
+            int channels[2][4];
+            int count = 0;
+            for(int i = 0; i < 2; i++) {
+                const unsigned char* row = i ? row_b : row_a;
+                if(format == PLUTOVG_FORMAT_A8) {
+                    channels[i][0] = row[x];
+                    count = 1;
+                } else if(format == PLUTOVG_FORMAT_RGB565) {
+                    unsigned int pixel = ((const unsigned short*)(row))[x];
+                    for(int c = 0; c < 3; c++)
+                        channels[i][c] = (pixel >> rgb565_shifts[c]) & rgb565_masks[c];
+                    count = 3;
+                } else {
+                    unsigned int pixel = ((const unsigned int*)(row))[x];
+                    for(int c = 0; c < 4; c++)
+                        channels[i][c] = (pixel >> (c * 8)) & 0xff;
+                    count = format == PLUTOVG_FORMAT_XRGB32 ? 3 : 4;
+                }
+            }
+
+            for(int c = 0; c < count; c++) {
+                int d = abs(channels[0][c] - channels[1][c]);
+                if(d > difference) {
+                    difference = d;
+                }
+            }
+        }
+    }
+
+    return difference;
+}
+
+typedef void(*set_paint_function_t)(plutovg_canvas_t* canvas, plutovg_surface_t* texture);
+
+static void set_translucent_color(plutovg_canvas_t* canvas, plutovg_surface_t* texture)
+{
+    (void)texture;
+    plutovg_canvas_set_rgba(canvas, 0.7f, 0.3f, 0.9f, 0.6f);
+}
+
+static void set_opaque_color(plutovg_canvas_t* canvas, plutovg_surface_t* texture)
+{
+    (void)texture;
+    plutovg_canvas_set_rgb(canvas, 0.2f, 0.6f, 0.9f);
+}
+
+static const plutovg_gradient_stop_t gradient_stops[] = {
+    {0.f, {1.f, 0.f, 0.f, 0.9f}},
+    {0.5f, {0.f, 1.f, 0.f, 0.4f}},
+    {1.f, {0.f, 0.f, 1.f, 1.f}}
+};
+
+static void set_linear_gradient(plutovg_canvas_t* canvas, plutovg_surface_t* texture)
+{
+    (void)texture;
+    plutovg_canvas_set_linear_gradient(canvas, 10, 5, 80, 70, PLUTOVG_SPREAD_METHOD_REPEAT, gradient_stops, 3, NULL);
+}
+
+static void set_radial_gradient(plutovg_canvas_t* canvas, plutovg_surface_t* texture)
+{
+    (void)texture;
+    plutovg_canvas_set_radial_gradient(canvas, 48, 40, 25, 40, 35, 0, PLUTOVG_SPREAD_METHOD_REFLECT, gradient_stops, 3, NULL);
+}
+
+static void set_texture(plutovg_canvas_t* canvas, plutovg_surface_t* texture)
+{
+    plutovg_canvas_set_texture(canvas, texture, PLUTOVG_TEXTURE_TYPE_PLAIN, 1.f, NULL);
+}
+
+static void set_tiled_texture(plutovg_canvas_t* canvas, plutovg_surface_t* texture)
+{
+    plutovg_matrix_t matrix;
+    plutovg_matrix_init_translate(&matrix, 3, -2);
+    plutovg_canvas_set_texture(canvas, texture, PLUTOVG_TEXTURE_TYPE_TILED, 0.8f, &matrix);
+}
+
+static void set_transformed_texture(plutovg_canvas_t* canvas, plutovg_surface_t* texture)
+{
+    plutovg_matrix_t matrix;
+    plutovg_matrix_init_rotate(&matrix, 0.3f);
+    plutovg_matrix_scale(&matrix, 1.3f, 0.9f);
+    plutovg_canvas_set_texture(canvas, texture, PLUTOVG_TEXTURE_TYPE_TILED, 0.7f, &matrix);
+}
+
+static const set_paint_function_t paints[] = {
+    set_translucent_color,
+    set_opaque_color,
+    set_linear_gradient,
+    set_radial_gradient,
+    set_texture,
+    set_tiled_texture,
+    set_transformed_texture
+};
+
+/* Draws the background with the scalar kernels, then the shape at `level`. */
+static void draw(plutovg_surface_t* surface, plutovg_surface_t* texture, int paint, plutovg_operator_t op, plutovg_cpu_level_t level)
+{
+    static const plutovg_gradient_stop_t stops[] = {
+        {0.f, {0.2f, 0.4f, 0.6f, 1.f}},
+        {1.f, {0.9f, 0.8f, 0.1f, 0.3f}}
+    };
+
+    plutovg_canvas_t* canvas = plutovg_canvas_create(surface);
+    plutovg_set_cpu_level(PLUTOVG_CPU_LEVEL_SCALAR);
+    plutovg_canvas_set_linear_gradient(canvas, 0, 0, WIDTH, 0, PLUTOVG_SPREAD_METHOD_PAD, stops, 2, NULL);
+    plutovg_canvas_paint(canvas);
+
+    plutovg_set_cpu_level(level);
+    plutovg_canvas_set_operator(canvas, op);
+    paints[paint](canvas, texture);
+    plutovg_canvas_ellipse(canvas, 48, 40, 40.5f, 30.25f);
+    plutovg_canvas_fill(canvas);
+    plutovg_canvas_destroy(canvas);
+}
+
+static void check_level(plutovg_cpu_level_t level, plutovg_format_t format, plutovg_surface_t* texture)
+{
+    for(int paint = 0; paint < (int)(sizeof(paints) / sizeof(paints[0])); paint++) {
+        for(int op = PLUTOVG_OPERATOR_CLEAR; op <= PLUTOVG_OPERATOR_XOR; op++) {
+            plutovg_surface_t* expected = plutovg_surface_create_with_format(WIDTH, HEIGHT, format);
+            plutovg_surface_t* actual = plutovg_surface_create_with_format(WIDTH, HEIGHT, format);
+            draw(expected, texture, paint, op, PLUTOVG_CPU_LEVEL_SCALAR);
+            draw(actual, texture, paint, op, level);
+            int difference = max_difference(expected, actual);
+            if(difference > TOLERANCE)
+                fprintf(stderr, "level %d, format %d, paint %d, operator %d: differs from scalar by %d\n", level, format, paint, op, difference);
+            CHECK(difference <= TOLERANCE);
+            plutovg_surface_destroy(actual);
+            plutovg_surface_destroy(expected);
+        }
+    }
+}
+
+int main(void)
+{
+    const plutovg_cpu_level_t best = plutovg_get_cpu_level();
+
+    plutovg_surface_t* texture = plutovg_surface_create(24, 20);
+    plutovg_canvas_t* canvas = plutovg_canvas_create(texture);
+    plutovg_canvas_set_rgba(canvas, 0.1f, 0.6f, 0.3f, 0.7f);
+    plutovg_canvas_paint(canvas);
+    plutovg_canvas_set_rgb(canvas, 0.9f, 0.2f, 0.4f);
+    plutovg_canvas_circle(canvas, 12, 10, 7);
+    plutovg_canvas_fill(canvas);
+    plutovg_canvas_destroy(canvas);
+
+    /* Levels the CPU lacks are lowered to one already covered, so they are skipped. */
+    for(int level = PLUTOVG_CPU_LEVEL_SSE2; level <= PLUTOVG_CPU_LEVEL_AVX512; level++) {
+        plutovg_set_cpu_level(level);
+        if(plutovg_get_cpu_level() != (plutovg_cpu_level_t)level)
+            continue;
+        check_level(level, PLUTOVG_FORMAT_ARGB32, texture);
+        check_level(level, PLUTOVG_FORMAT_XRGB32, texture);
+        check_level(level, PLUTOVG_FORMAT_A8, texture);
+        check_level(level, PLUTOVG_FORMAT_RGB565, texture);
+    }
+
+    plutovg_set_cpu_level(PLUTOVG_CPU_LEVEL_AUTO);
+    CHECK(plutovg_get_cpu_level() == best);
+
+    plutovg_surface_destroy(texture);
+    return TEST_RESULT();
+}
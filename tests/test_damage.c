@@ -0,0 +1,127 @@
+#include "test.h"
+
+#include <string.h>
+
+#define WIDTH 240
+#define HEIGHT 180
+
+static bool rect_contains(const plutovg_rect_t* rect, int x, int y)
+{
+    return x >= rect->x && x < rect->x + rect->w && y >= rect->y && y < rect->y + rect->h;
+}
+
+static bool rects_intersect(const plutovg_rect_t* a, const plutovg_rect_t* b)
+{
+    return a->x < b->x + b->w && b->x < a->x + a->w && a->y < b->y + b->h && b->y < a->y + a->h;
+}
+
+static bool is_whole_pixels(const plutovg_rect_t* rect)
+{
+    return rect->x == (int)rect->x && rect->y == (int)rect->y && rect->w == (int)rect->w && rect->h == (int)rect->h;
+}
+
+/*
+ * Every pixel that differs from `before` must lie inside one of the damage rectangles,
+ * and the rectangles must be pixel aligned and disjoint.
+ */
+static void check_damage_covers(plutovg_canvas_t* canvas, const plutovg_surface_t* surface, const unsigned char* before)
+{
+    plutovg_rect_t rects[PLUTOVG_MAX_DAMAGE_RECTS];
+    int count = plutovg_canvas_get_damage(canvas, rects, PLUTOVG_MAX_DAMAGE_RECTS);
+    CHECK(count >= 1 && count <= PLUTOVG_MAX_DAMAGE_RECTS);
+    for(int i = 0; i < count; i++) {
+        CHECK(is_whole_pixels(&rects[i]));
+        for(int j = i + 1; j < count; j++) {
+            CHECK(!rects_intersect(&rects[i], &rects[j]));
+        }
+    }
+
+    int uncovered = 0;
+    const int stride = plutovg_surface_get_stride(surface);
+    for(int y = 0; y < HEIGHT; y++) {
+        const unsigned int* row = (const unsigned int*)(plutovg_surface_get_data(surface) + y * stride);
+        const unsigned int* old_row = (const unsigned int*)(before + y * stride);
+        for(int x = 0; x < WIDTH; x++) {
+            if(row[x] == old_row[x])
+                continue;
+            bool covered = false;
+            for(int i = 0; i < count && !covered; i++)
+                covered = rect_contains(&rects[i], x, y);
+            if(!covered) {
+                uncovered++;
+            }
+        }
+    }
+
+    CHECK(uncovered == 0);
+}
+
+static void check_draws(void)
+{
+    plutovg_surface_t* surface = plutovg_surface_create(WIDTH, HEIGHT);
+    const size_t size = (size_t)plutovg_surface_get_stride(surface) * HEIGHT;
+    unsigned char* before = malloc(size);
+
+    plutovg_canvas_t* canvas = plutovg_canvas_create(surface);
+    CHECK(plutovg_canvas_get_damage(canvas, NULL, 0) == 0);
+
+    memcpy(before, plutovg_surface_get_data(surface), size);
+    plutovg_canvas_set_rgba(canvas, 0.8f, 0.2f, 0.1f, 0.9f);
+    plutovg_canvas_circle(canvas, 40.3f, 50.7f, 25.5f);
+    plutovg_canvas_fill(canvas);
+    plutovg_canvas_rect(canvas, 150, 100, 60, 50);
+    plutovg_canvas_fill(canvas);
+    plutovg_canvas_set_line_width(canvas, 5);
+    plutovg_canvas_move_to(canvas, 10, 170);
+    plutovg_canvas_line_to(canvas, 230, 120);
+    plutovg_canvas_stroke(canvas);
+    check_damage_covers(canvas, surface, before);
+
+    /*
+     * Two separate shapes are tracked as separate rectangles, whose bounding box is the
+     * damage extents.
+     */
+    plutovg_canvas_reset_damage(canvas);
+    CHECK(plutovg_canvas_get_damage(canvas, NULL, 0) == 0);
+    plutovg_canvas_rect(canvas, 10, 10, 20, 20);
+    plutovg_canvas_fill(canvas);
+    plutovg_canvas_rect(canvas, 200, 140, 20, 20);
+    plutovg_canvas_fill(canvas);
+    plutovg_rect_t rects[PLUTOVG_MAX_DAMAGE_RECTS];
+    CHECK(plutovg_canvas_get_damage(canvas, rects, PLUTOVG_MAX_DAMAGE_RECTS) == 2);
+    plutovg_rect_t extents;
+    plutovg_canvas_get_damage_extents(canvas, &extents);
+    CHECK(extents.x == 10 && extents.y == 10 && extents.w == 210 && extents.h == 150);
+
+    /* Drawing inside a group only counts once the group is composited. */
+    plutovg_canvas_reset_damage(canvas);
+    memcpy(before, plutovg_surface_get_data(surface), size);
+    plutovg_canvas_push_group(canvas);
+    plutovg_canvas_set_rgb(canvas, 0.1f, 0.5f, 0.9f);
+    plutovg_canvas_circle(canvas, 120, 90, 40);
+    plutovg_canvas_fill(canvas);
+    CHECK(plutovg_canvas_get_damage(canvas, NULL, 0) == 0);
+    plutovg_canvas_pop_group(canvas, 0.5f, PLUTOVG_OPERATOR_SRC_OVER);
+    check_damage_covers(canvas, surface, before);
+
+    /* Many scattered shapes are merged down to the maximum number of rectangles. */
+    plutovg_canvas_reset_damage(canvas);
+    memcpy(before, plutovg_surface_get_data(surface), size);
+    for(int i = 0; i < 40; i++) {
+        plutovg_canvas_set_rgba(canvas, (i % 5) / 5.f, (i % 3) / 3.f, 0.5f, 1.f);
+        plutovg_canvas_circle(canvas, (i * 53) % WIDTH, (i * 31) % HEIGHT, 4 + i % 7);
+        plutovg_canvas_fill(canvas);
+    }
+
+    check_damage_covers(canvas, surface, before);
+
+    plutovg_canvas_destroy(canvas);
+    plutovg_surface_destroy(surface);
+    free(before);
+}
+
+int main(void)
+{
+    check_draws();
+    return TEST_RESULT();
+}
@@ -0,0 +1,115 @@
+#include "test.h"
+
+#define WIDTH 320
+#define HEIGHT 900
+
+/*
+ * Shapes straddle the 256-row tile boundaries, and the group, clip and stroke reach
+ * across several tiles, so every tile replays a different subset of the operations.
+ */
+static void draw(plutovg_canvas_t* canvas, plutovg_surface_t* texture)
+{
+    static const plutovg_gradient_stop_t stops[] = {
+        {0.f, {1.f, 0.2f, 0.f, 1.f}},
+        {0.5f, {0.f, 0.7f, 0.3f, 0.5f}},
+        {1.f, {0.1f, 0.f, 1.f, 0.9f}}
+    };
+
+    plutovg_canvas_set_rgb(canvas, 0.95f, 0.95f, 0.9f);
+    plutovg_canvas_paint(canvas);
+
+    plutovg_canvas_set_linear_gradient(canvas, 0, 100, WIDTH, 600, PLUTOVG_SPREAD_METHOD_REFLECT, stops, 3, NULL);
+    plutovg_canvas_ellipse(canvas, 160, 256, 150, 120);
+    plutovg_canvas_fill(canvas);
+
+    plutovg_canvas_save(canvas);
+    plutovg_canvas_rect(canvas, 20.5f, 300.25f, 280, 400);
+    plutovg_canvas_clip(canvas);
+    plutovg_canvas_set_radial_gradient(canvas, 160, 512, 200, 120, 480, 10, PLUTOVG_SPREAD_METHOD_PAD, stops, 3, NULL);
+    plutovg_canvas_circle(canvas, 160, 512, 230);
+    plutovg_canvas_fill(canvas);
+    plutovg_canvas_restore(canvas);
+
+    plutovg_canvas_push_group(canvas);
+    plutovg_canvas_set_texture(canvas, texture, PLUTOVG_TEXTURE_TYPE_TILED, 1.f, NULL);
+    plutovg_canvas_round_rect(canvas, 40, 480, 240, 300, 40, 40);
+    plutovg_canvas_fill(canvas);
+    plutovg_canvas_set_rgba(canvas, 0.f, 0.f, 0.f, 0.6f);
+    plutovg_canvas_circle(canvas, 160, 768, 60);
+    plutovg_canvas_fill(canvas);
+    plutovg_canvas_pop_group(canvas, 0.7f, PLUTOVG_OPERATOR_SRC_OVER);
+
+    static const float dashes[] = {12, 5, 3, 5};
+    plutovg_canvas_set_rgba(canvas, 0.2f, 0.1f, 0.6f, 0.8f);
+    plutovg_canvas_set_line_width(canvas, 7);
+    plutovg_canvas_set_dash(canvas, 2, dashes, 4);
+    plutovg_canvas_move_to(canvas, 10, 20);
+    plutovg_canvas_cubic_to(canvas, 400, 200, -100, 600, 300, 880);
+    plutovg_canvas_stroke(canvas);
+}
+
+static plutovg_surface_t* draw_serial(const plutovg_display_list_t* display_list, const plutovg_matrix_t* matrix)
+{
+    plutovg_surface_t* surface = plutovg_surface_create(WIDTH, HEIGHT);
+    plutovg_canvas_t* canvas = plutovg_canvas_create(surface);
+    plutovg_canvas_draw_display_list(canvas, display_list, matrix);
+    plutovg_canvas_destroy(canvas);
+    return surface;
+}
+
+static void check_tiles(const plutovg_display_list_t* display_list, const plutovg_matrix_t* matrix)
+{
+    static const int thread_counts[] = {1, 2, 3, 8, 0};
+
+    plutovg_surface_t* expected = draw_serial(display_list, matrix);
+    for(size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); i++) {
+        plutovg_surface_t* actual = plutovg_surface_create(WIDTH, HEIGHT);
+        plutovg_surface_draw_display_list(actual, display_list, matrix, thread_counts[i]);
+        if(!same_pixels(expected, actual))
+            fprintf(stderr, "%d threads: tiled rendering differs from serial replay\n", thread_counts[i]);
+        CHECK(same_pixels(expected, actual));
+        plutovg_surface_destroy(actual);
+    }
+
+    plutovg_surface_destroy(expected);
+}
+
+int main(void)
+{
+    plutovg_surface_t* texture = plutovg_surface_create(32, 32);
+    plutovg_canvas_t* canvas = plutovg_canvas_create(texture);
+    plutovg_canvas_set_rgb(canvas, 0.9f, 0.5f, 0.1f);
+    plutovg_canvas_paint(canvas);
+    plutovg_canvas_set_rgba(canvas, 0.1f, 0.3f, 0.9f, 0.8f);
+    plutovg_canvas_circle(canvas, 16, 16, 11);
+    plutovg_canvas_fill(canvas);
+    plutovg_canvas_destroy(canvas);
+
+    canvas = plutovg_canvas_create_recording(WIDTH, HEIGHT);
+    draw(canvas, texture);
+    plutovg_display_list_t* display_list = plutovg_canvas_finish_recording(canvas);
+    plutovg_canvas_destroy(canvas);
+    CHECK(display_list != NULL);
+
+    /* Replaying the recording must match drawing directly. */
+    plutovg_surface_t* direct = plutovg_surface_create(WIDTH, HEIGHT);
+    canvas = plutovg_canvas_create(direct);
+    draw(canvas, texture);
+    plutovg_canvas_destroy(canvas);
+    plutovg_surface_t* replayed = draw_serial(display_list, NULL);
+    CHECK(same_pixels(direct, replayed));
+    plutovg_surface_destroy(replayed);
+    plutovg_surface_destroy(direct);
+
+    plutovg_matrix_t matrix;
+    plutovg_matrix_init_translate(&matrix, 30, -40);
+    plutovg_matrix_rotate(&matrix, 0.1f);
+    plutovg_matrix_scale(&matrix, 0.9f, 1.1f);
+
+    check_tiles(display_list, NULL);
+    check_tiles(display_list, &matrix);
+
+    plutovg_display_list_destroy(display_list);
+    plutovg_surface_destroy(texture);
+    return TEST_RESULT();
+}
@@ -0,0 +1,168 @@
+#include "test.h"
+
+#define WIDTH 300
+#define HEIGHT 200
+
+/* Copies `source` into a new surface of `format` by painting it with the SRC operator. */
+static plutovg_surface_t* convert(plutovg_surface_t* source, plutovg_format_t format)
+{
+    plutovg_surface_t* surface = plutovg_surface_create_with_format(plutovg_surface_get_width(source), plutovg_surface_get_height(source), format);
+    plutovg_canvas_t* canvas = plutovg_canvas_create(surface);
+    plutovg_canvas_set_operator(canvas, PLUTOVG_OPERATOR_SRC);
+    plutovg_canvas_set_texture(canvas, source, PLUTOVG_TEXTURE_TYPE_PLAIN, 1.f, NULL);
+    plutovg_canvas_paint(canvas);
+    plutovg_canvas_destroy(canvas);
+    return surface;
+}
+
+static void fill_format_pattern(plutovg_surface_t* surface)
+{
+    const plutovg_format_t format = plutovg_surface_get_format(surface);
+    for(int y = 0; y < HEIGHT; y++) {
+        unsigned char* row = plutovg_surface_get_data(surface) + y * plutovg_surface_get_stride(surface);
+        for(int x = 0; x < WIDTH; x++) {
+            unsigned int value = (x * 7919u + y * 104729u) * 2654435761u;
+            if(format == PLUTOVG_FORMAT_A8) {
+                row[x] = value >> 24;
+            } else if(format == PLUTOVG_FORMAT_RGB565) {
+                ((unsigned short*)(row))[x] = value >> 16;
+            } else {
+                ((unsigned int*)(row))[x] = value | 0xff000000;
+            }
+        }
+    }
+
+    plutovg_surface_mark_dirty(surface);
+}
+
+static void check_round_trip(plutovg_format_t format)
+{
+    plutovg_surface_t* source = plutovg_surface_create_with_format(WIDTH, HEIGHT, format);
+    fill_format_pattern(source);
+
+    plutovg_surface_t* argb = convert(source, PLUTOVG_FORMAT_ARGB32);
+    plutovg_surface_t* result = convert(argb, format);
+    CHECK(same_pixels(source, result));
+
+    const unsigned char* row = plutovg_surface_get_data(source) + 5 * plutovg_surface_get_stride(source);
+    const unsigned int pixel = ((const unsigned int*)(plutovg_surface_get_data(argb) + 5 * plutovg_surface_get_stride(argb)))[7];
+    if(format == PLUTOVG_FORMAT_A8) {
+        CHECK(pixel == (unsigned int)row[7] << 24);
+    } else {
+        CHECK((pixel >> 24) == 255);
+    }
+
+    plutovg_surface_destroy(source);
+    plutovg_surface_destroy(argb);
+    plutovg_surface_destroy(result);
+}
+
+typedef void(*draw_function_t)(plutovg_canvas_t* canvas, plutovg_surface_t* texture);
+
+static void draw_linear_gradient(plutovg_canvas_t* canvas, plutovg_surface_t* texture)
+{
+    static const plutovg_gradient_stop_t stops[] = {
+        {0.f, {1.f, 0.f, 0.f, 0.9f}},
+        {0.5f, {0.f, 1.f, 0.f, 0.4f}},
+        {1.f, {0.f, 0.f, 1.f, 1.f}}
+    };
+
+    (void)texture;
+    plutovg_canvas_set_linear_gradient(canvas, 10, 20, 250, 170, PLUTOVG_SPREAD_METHOD_REFLECT, stops, 3, NULL);
+    plutovg_canvas_rect(canvas, 5.5f, 3.25f, 280, 190);
+    plutovg_canvas_fill(canvas);
+}
+
+static void draw_radial_gradient(plutovg_canvas_t* canvas, plutovg_surface_t* texture)
+{
+    static const plutovg_gradient_stop_t stops[] = {
+        {0.f, {1.f, 1.f, 0.f, 1.f}},
+        {1.f, {0.f, 0.5f, 1.f, 0.3f}}
+    };
+
+    (void)texture;
+    plutovg_canvas_set_radial_gradient(canvas, 150, 100, 90, 130, 80, 0, PLUTOVG_SPREAD_METHOD_PAD, stops, 2, NULL);
+    plutovg_canvas_circle(canvas, 150, 100, 95);
+    plutovg_canvas_fill(canvas);
+}
+
+static void draw_transformed_texture(plutovg_canvas_t* canvas, plutovg_surface_t* texture)
+{
+    plutovg_matrix_t matrix;
+    plutovg_matrix_init_rotate(&matrix, 0.3f);
+    plutovg_matrix_scale(&matrix, 0.7f, 0.8f);
+    plutovg_canvas_set_texture(canvas, texture, PLUTOVG_TEXTURE_TYPE_PLAIN, 0.8f, &matrix);
+    plutovg_canvas_ellipse(canvas, 150, 100, 140, 90);
+    plutovg_canvas_fill(canvas);
+}
+
+static void draw_tiled_texture(plutovg_canvas_t* canvas, plutovg_surface_t* texture)
+{
+    plutovg_matrix_t matrix;
+    plutovg_matrix_init_translate(&matrix, 13, -7);
+    plutovg_matrix_scale(&matrix, 0.25f, 0.25f);
+    plutovg_canvas_set_texture(canvas, texture, PLUTOVG_TEXTURE_TYPE_TILED, 1.f, &matrix);
+    plutovg_canvas_round_rect(canvas, 20, 10, 260, 180, 30, 30);
+    plutovg_canvas_fill(canvas);
+}
+
+static const draw_function_t draw_functions[] = {
+    draw_linear_gradient,
+    draw_radial_gradient,
+    draw_transformed_texture,
+    draw_tiled_texture
+};
+
+/*
+ * Gradients and textures drawn into a surface of `format` must match the same drawing
+ * done on an ARGB32 surface and then converted, since both run the same integer kernels.
+ */
+static void check_paints(plutovg_format_t format, const plutovg_color_t* background)
+{
+    plutovg_surface_t* texture = plutovg_surface_create(WIDTH, HEIGHT);
+    plutovg_canvas_t* canvas = plutovg_canvas_create(texture);
+    plutovg_canvas_set_rgba(canvas, 0.2f, 0.6f, 0.9f, 0.6f);
+    plutovg_canvas_paint(canvas);
+    plutovg_canvas_set_rgb(canvas, 0.9f, 0.3f, 0.1f);
+    plutovg_canvas_circle(canvas, 150, 100, 60);
+    plutovg_canvas_fill(canvas);
+    plutovg_canvas_destroy(canvas);
+
+    for(size_t i = 0; i < sizeof(draw_functions) / sizeof(draw_functions[0]); i++) {
+        plutovg_surface_t* surface = plutovg_surface_create_with_format(WIDTH, HEIGHT, format);
+        plutovg_surface_clear(surface, background);
+        plutovg_surface_t* reference = convert(surface, PLUTOVG_FORMAT_ARGB32);
+
+        canvas = plutovg_canvas_create(surface);
+        draw_functions[i](canvas, texture);
+        plutovg_canvas_destroy(canvas);
+
+        canvas = plutovg_canvas_create(reference);
+        draw_functions[i](canvas, texture);
+        plutovg_canvas_destroy(canvas);
+
+        plutovg_surface_t* expected = convert(reference, format);
+        if(!same_pixels(surface, expected))
+            fprintf(stderr, "format %d: paint %zu differs from ARGB32\n", format, i);
+        CHECK(same_pixels(surface, expected));
+        plutovg_surface_destroy(expected);
+        plutovg_surface_destroy(reference);
+        plutovg_surface_destroy(surface);
+    }
+
+    plutovg_surface_destroy(texture);
+}
+
+int main(void)
+{
+    static const plutovg_color_t transparent = {0.f, 0.f, 0.f, 0.f};
+    static const plutovg_color_t background = {0.2f, 0.4f, 0.6f, 1.f};
+
+    check_round_trip(PLUTOVG_FORMAT_A8);
+    check_round_trip(PLUTOVG_FORMAT_XRGB32);
+    check_round_trip(PLUTOVG_FORMAT_RGB565);
+    check_paints(PLUTOVG_FORMAT_A8, &transparent);
+    check_paints(PLUTOVG_FORMAT_XRGB32, &background);
+    check_paints(PLUTOVG_FORMAT_RGB565, &background);
+    return TEST_RESULT();
+}
@@ -0,0 +1,96 @@
+#include "test.h"
+
+#define WIDTH 220
+#define HEIGHT 160
+
+static void draw_background(plutovg_canvas_t* canvas)
+{
+    static const plutovg_gradient_stop_t stops[] = {
+        {0.f, {0.9f, 0.9f, 0.2f, 1.f}},
+        {1.f, {0.2f, 0.3f, 0.9f, 0.7f}}
+    };
+
+    plutovg_canvas_set_linear_gradient(canvas, 0, 0, WIDTH, HEIGHT, PLUTOVG_SPREAD_METHOD_PAD, stops, 2, NULL);
+    plutovg_canvas_paint(canvas);
+}
+
+static void clip_to_shape(plutovg_canvas_t* canvas)
+{
+    plutovg_canvas_round_rect(canvas, 30.5f, 20.25f, 150, 110, 20, 20);
+    plutovg_canvas_clip(canvas);
+}
+
+static void draw_content(plutovg_canvas_t* canvas, int step)
+{
+    plutovg_canvas_set_rgba(canvas, 0.8f, 0.1f, 0.1f, 0.9f);
+    plutovg_canvas_circle(canvas, 80 + step * 30, 80, 50);
+    plutovg_canvas_fill(canvas);
+    plutovg_canvas_set_rgba(canvas, 0.1f, 0.7f, 0.2f, 0.8f);
+    plutovg_canvas_circle(canvas, 130 - step * 20, 70, 45);
+    plutovg_canvas_fill(canvas);
+}
+
+/*
+ * A group draws into a transparent layer that is then composited with the given opacity
+ * and operator, so it must match painting a separately drawn surface as a texture. The
+ * clip applies both while drawing into the layer and while compositing it. The group is
+ * drawn twice per canvas, so the second one runs on a recycled layer.
+ */
+static void check_group(plutovg_operator_t op, float opacity, bool clip)
+{
+    plutovg_surface_t* expected = plutovg_surface_create(WIDTH, HEIGHT);
+    plutovg_canvas_t* canvas = plutovg_canvas_create(expected);
+    draw_background(canvas);
+    if(clip) {
+        clip_to_shape(canvas);
+    }
+
+    for(int step = 0; step < 2; step++) {
+        plutovg_surface_t* layer = plutovg_surface_create(WIDTH, HEIGHT);
+        plutovg_canvas_t* layer_canvas = plutovg_canvas_create(layer);
+        if(clip) {
+            clip_to_shape(layer_canvas);
+        }
+
+        draw_content(layer_canvas, step);
+        plutovg_canvas_destroy(layer_canvas);
+
+        plutovg_canvas_set_operator(canvas, op);
+        plutovg_canvas_set_texture(canvas, layer, PLUTOVG_TEXTURE_TYPE_PLAIN, opacity, NULL);
+        plutovg_canvas_paint(canvas);
+        plutovg_surface_destroy(layer);
+    }
+
+    plutovg_canvas_destroy(canvas);
+
+    plutovg_surface_t* actual = plutovg_surface_create(WIDTH, HEIGHT);
+    canvas = plutovg_canvas_create(actual);
+    draw_background(canvas);
+    if(clip) {
+        clip_to_shape(canvas);
+    }
+
+    for(int step = 0; step < 2; step++) {
+        plutovg_canvas_push_group(canvas);
+        draw_content(canvas, step);
+        plutovg_canvas_pop_group(canvas, opacity, op);
+    }
+
+    plutovg_canvas_destroy(canvas);
+
+    if(!same_pixels(expected, actual))
+        fprintf(stderr, "operator %d, opacity %g, clip %d: group differs from texture paint\n", op, opacity, clip);
+    CHECK(same_pixels(expected, actual));
+    plutovg_surface_destroy(actual);
+    plutovg_surface_destroy(expected);
+}
+
+int main(void)
+{
+    check_group(PLUTOVG_OPERATOR_SRC_OVER, 1.f, false);
+    check_group(PLUTOVG_OPERATOR_SRC_OVER, 0.6f, false);
+    check_group(PLUTOVG_OPERATOR_SRC_OVER, 0.6f, true);
+    check_group(PLUTOVG_OPERATOR_DST_IN, 0.8f, true);
+    check_group(PLUTOVG_OPERATOR_XOR, 1.f, false);
+    return TEST_RESULT();
+}
@@ -0,0 +1,139 @@
+#include "test.h"
+
+#define TEXTURE_SIZE 64
+
+/* Inverts the color channels of every pixel, which keeps them opaque. */
+static void invert_pixels(plutovg_surface_t* surface)
+{
+    for(int y = 0; y < TEXTURE_SIZE; y++) {
+        unsigned int* row = (unsigned int*)(plutovg_surface_get_data(surface) + y * plutovg_surface_get_stride(surface));
+        for(int x = 0; x < TEXTURE_SIZE; x++) {
+            row[x] ^= 0x00ffffff;
+        }
+    }
+
+    plutovg_surface_mark_dirty(surface);
+}
+
+/* Averages each 2x2 block of `source`, rounding to nearest, into a new half-size surface. */
+static plutovg_surface_t* box_filter(const plutovg_surface_t* source)
+{
+    const int width = plutovg_surface_get_width(source) / 2;
+    const int height = plutovg_surface_get_height(source) / 2;
+    const int stride = plutovg_surface_get_stride(source);
+    plutovg_surface_t* surface = plutovg_surface_create(width, height);
+    for(int y = 0; y < height; y++) {
+        const unsigned int* row0 = (const unsigned int*)(plutovg_surface_get_data(source) + 2 * y * stride);
+        const unsigned int* row1 = (const unsigned int*)(plutovg_surface_get_data(source) + (2 * y + 1) * stride);
+        unsigned int* dest = (unsigned int*)(plutovg_surface_get_data(surface) + y * plutovg_surface_get_stride(surface));
+        for(int x = 0; x < width; x++) {
+            unsigned int pixel = 0;
+            for(int c = 0; c < 32; c += 8) {
+                unsigned int sum = ((row0[2 * x] >> c) & 0xff) + ((row0[2 * x + 1] >> c) & 0xff)
+                    + ((row1[2 * x] >> c) & 0xff) + ((row1[2 * x + 1] >> c) & 0xff);
+                pixel |= ((sum + 2) >> 2) << c;
+            }
+
+            dest[x] = pixel;
+        }
+    }
+
+    return surface;
+}
+
+/* Box-filters `texture` down `levels` times. */
+static plutovg_surface_t* reference_level(plutovg_surface_t* texture, int levels)
+{
+    plutovg_surface_t* surface = plutovg_surface_reference(texture);
+    for(int i = 0; i < levels; i++) {
+        plutovg_surface_t* level = box_filter(surface);
+        plutovg_surface_destroy(surface);
+        surface = level;
+    }
+
+    return surface;
+}
+
+static plutovg_surface_t* draw_scaled(plutovg_surface_t* texture, float scale)
+{
+    const int size = (int)(TEXTURE_SIZE * scale);
+    plutovg_surface_t* surface = plutovg_surface_create(size, size);
+    plutovg_canvas_t* canvas = plutovg_canvas_create(surface);
+    plutovg_canvas_scale(canvas, scale, scale);
+    plutovg_canvas_set_operator(canvas, PLUTOVG_OPERATOR_SRC);
+    plutovg_canvas_set_texture(canvas, texture, PLUTOVG_TEXTURE_TYPE_PLAIN, 1.f, NULL);
+    plutovg_canvas_paint(canvas);
+    plutovg_canvas_destroy(canvas);
+    return surface;
+}
+
+/*
+ * Drawing at 1/2^k of the texture size samples level k of the chain one to one, so the
+ * result is exactly the texture box-filtered k times.
+ */
+static bool draws_level(plutovg_surface_t* texture, int levels)
+{
+    plutovg_surface_t* actual = draw_scaled(texture, 1.f / (1 << levels));
+    plutovg_surface_t* expected = reference_level(texture, levels);
+    bool result = same_pixels(actual, expected);
+    plutovg_surface_destroy(expected);
+    plutovg_surface_destroy(actual);
+    return result;
+}
+
+static void check_levels(void)
+{
+    plutovg_surface_t* texture = plutovg_surface_create(TEXTURE_SIZE, TEXTURE_SIZE);
+    fill_pattern(texture);
+    plutovg_surface_set_mipmap_enabled(texture, true);
+    CHECK(plutovg_surface_get_mipmap_enabled(texture));
+
+    CHECK(draws_level(texture, 1));
+    CHECK(draws_level(texture, 2));
+    CHECK(draws_level(texture, 3));
+
+    /* Less than halving the texture samples the full image, as without the chain. */
+    plutovg_surface_t* with_chain = draw_scaled(texture, 0.75f);
+    plutovg_surface_set_mipmap_enabled(texture, false);
+    plutovg_surface_t* without_chain = draw_scaled(texture, 0.75f);
+    CHECK(same_pixels(with_chain, without_chain));
+    plutovg_surface_destroy(without_chain);
+    plutovg_surface_destroy(with_chain);
+
+    /* Without the chain, a quarter-size draw point-samples instead of averaging. */
+    plutovg_surface_t* sampled = draw_scaled(texture, 0.25f);
+    plutovg_surface_t* filtered = reference_level(texture, 2);
+    CHECK(!same_pixels(sampled, filtered));
+    plutovg_surface_destroy(filtered);
+    plutovg_surface_destroy(sampled);
+
+    plutovg_surface_destroy(texture);
+}
+
+/* Changing the pixels, directly or by drawing, rebuilds the chain on next use. */
+static void check_rebuild(void)
+{
+    plutovg_surface_t* texture = plutovg_surface_create(TEXTURE_SIZE, TEXTURE_SIZE);
+    fill_pattern(texture);
+    plutovg_surface_set_mipmap_enabled(texture, true);
+    CHECK(draws_level(texture, 2));
+
+    invert_pixels(texture);
+    CHECK(draws_level(texture, 2));
+
+    plutovg_canvas_t* canvas = plutovg_canvas_create(texture);
+    plutovg_canvas_set_rgb(canvas, 0.3f, 0.9f, 0.5f);
+    plutovg_canvas_rect(canvas, 8, 8, 24, 40);
+    plutovg_canvas_fill(canvas);
+    plutovg_canvas_destroy(canvas);
+    CHECK(draws_level(texture, 2));
+
+    plutovg_surface_destroy(texture);
+}
+
+int main(void)
+{
+    check_levels();
+    check_rebuild();
+    return TEST_RESULT();
+}
@@ -0,0 +1,180 @@
+#include "test.h"
+
+#include <string.h>
+
+#define WIDTH 96
+#define HEIGHT 80
+
+/*
+ * The float pipeline rounds once where the integer kernels round at every step, so the
+ * two backends agree to within a few levels per 8-bit channel. RGB565 channels are
+ * compared after widening to 8 bits, where rounding to the other side of a 5-bit step
+ * adds 8 levels.
+ */
+#define TOLERANCE 3
+#define RGB565_TOLERANCE (TOLERANCE + 8)
+
+static int max_difference(const plutovg_surface_t* a, const plutovg_surface_t* b)
+{
+    const plutovg_format_t format = plutovg_surface_get_format(a);
+    int difference = 0;
+    for(int y = 0; y < HEIGHT; y++) {
+        const unsigned char* row_a = plutovg_surface_get_data(a) + y * plutovg_surface_get_stride(a);
+        const unsigned char* row_b = plutovg_surface_get_data(b) + y * plutovg_surface_get_stride(b);
+        for(int x = 0; x < WIDTH; x++) {
+            int channels[2][4];
+            int count = 0;
+            for(int i = 0; i < 2; i++) {
+                const unsigned char* row = i ? row_b : row_a;
+                if(format == PLUTOVG_FORMAT_A8) {
+                    channels[i][0] = row[x];
+                    count = 1;
+                } else if(format == PLUTOVG_FORMAT_RGB565) {
+                    unsigned int pixel = ((const unsigned short*)(row))[x];
+                    channels[i][0] = ((pixel >> 11) & 0x1f) * 255 / 31;
+                    channels[i][1] = ((pixel >> 5) & 0x3f) * 255 / 63;
+                    channels[i][2] = (pixel & 0x1f) * 255 / 31;
+                    count = 3;
+                } else {
+                    unsigned int pixel = ((const unsigned int*)(row))[x];
+                    for(int c = 0; c < 4; c++)
+                        channels[i][c] = (pixel >> (c * 8)) & 0xff;
+                    count = format == PLUTOVG_FORMAT_XRGB32 ? 3 : 4;
+                }
+            }
+
+            for(int c = 0; c < count; c++) {
+                int d = abs(channels[0][c] - channels[1][c]);
+                if(d > difference) {
+                    difference = d;
+                }
+            }
+        }
+    }
+
+    return difference;
+}
+
+typedef void(*set_paint_function_t)(plutovg_canvas_t* canvas, plutovg_surface_t* texture);
+
+static void set_solid(plutovg_canvas_t* canvas, plutovg_surface_t* texture)
+{
+    (void)texture;
+    plutovg_canvas_set_rgba(canvas, 0.7f, 0.3f, 0.9f, 0.6f);
+}
+
+/*
+ * Repeat-spread gradients are left out: at t == 1 the pipeline wraps to the first stop,
+ * while the integer color table holds the last one.
+ */
+static void set_linear_gradient(plutovg_canvas_t* canvas, plutovg_surface_t* texture)
+{
+    static const plutovg_gradient_stop_t stops[] = {
+        {0.f, {1.f, 0.f, 0.f, 0.9f}},
+        {0.5f, {0.f, 1.f, 0.f, 0.4f}},
+        {1.f, {0.f, 0.f, 1.f, 1.f}}
+    };
+
+    (void)texture;
+    plutovg_canvas_set_linear_gradient(canvas, 10, 5, 80, 70, PLUTOVG_SPREAD_METHOD_PAD, stops, 3, NULL);
+}
+
+static void set_radial_gradient(plutovg_canvas_t* canvas, plutovg_surface_t* texture)
+{
+    static const plutovg_gradient_stop_t stops[] = {
+        {0.f, {1.f, 1.f, 0.f, 1.f}},
+        {1.f, {0.f, 0.5f, 1.f, 0.3f}}
+    };
+
+    (void)texture;
+    plutovg_canvas_set_radial_gradient(canvas, 48, 40, 25, 40, 35, 0, PLUTOVG_SPREAD_METHOD_REFLECT, stops, 2, NULL);
+}
+
+/*
+ * Nearest-neighbour lookups only agree when sample points do not fall on texel
+ * boundaries, so the untransformed texture sits at whole-pixel offsets and the
+ * transformed one is rotated, which samples bilinearly on both backends.
+ */
+static void set_texture(plutovg_canvas_t* canvas, plutovg_surface_t* texture)
+{
+    plutovg_matrix_t matrix;
+    plutovg_matrix_init_translate(&matrix, 3, -2);
+    plutovg_canvas_set_texture(canvas, texture, PLUTOVG_TEXTURE_TYPE_TILED, 0.8f, &matrix);
+}
+
+static void set_transformed_texture(plutovg_canvas_t* canvas, plutovg_surface_t* texture)
+{
+    plutovg_matrix_t matrix;
+    plutovg_matrix_init_rotate(&matrix, 0.3f);
+    plutovg_matrix_scale(&matrix, 1.3f, 0.9f);
+    plutovg_canvas_set_texture(canvas, texture, PLUTOVG_TEXTURE_TYPE_PLAIN, 1.f, &matrix);
+}
+
+static const set_paint_function_t paints[] = {
+    set_solid,
+    set_linear_gradient,
+    set_radial_gradient,
+    set_texture,
+    set_transformed_texture
+};
+
+static void draw(plutovg_surface_t* surface, plutovg_surface_t* texture, int paint, plutovg_operator_t op, plutovg_blend_backend_t backend)
+{
+    static const plutovg_gradient_stop_t stops[] = {
+        {0.f, {0.2f, 0.4f, 0.6f, 1.f}},
+        {1.f, {0.9f, 0.8f, 0.1f, 0.3f}}
+    };
+
+    plutovg_canvas_t* canvas = plutovg_canvas_create(surface);
+    plutovg_set_blend_backend(PLUTOVG_BLEND_BACKEND_INTEGER);
+    plutovg_canvas_set_linear_gradient(canvas, 0, 0, WIDTH, 0, PLUTOVG_SPREAD_METHOD_PAD, stops, 2, NULL);
+    plutovg_canvas_paint(canvas);
+
+    plutovg_set_blend_backend(backend);
+    plutovg_canvas_set_operator(canvas, op);
+    paints[paint](canvas, texture);
+    plutovg_canvas_ellipse(canvas, 48, 40, 40.5f, 30.25f);
+    plutovg_canvas_fill(canvas);
+    plutovg_canvas_destroy(canvas);
+    plutovg_set_blend_backend(PLUTOVG_BLEND_BACKEND_INTEGER);
+}
+
+static void check_backends(plutovg_format_t format, plutovg_surface_t* texture)
+{
+    const int tolerance = format == PLUTOVG_FORMAT_RGB565 ? RGB565_TOLERANCE : TOLERANCE;
+    for(int paint = 0; paint < (int)(sizeof(paints) / sizeof(paints[0])); paint++) {
+        for(int op = PLUTOVG_OPERATOR_CLEAR; op <= PLUTOVG_OPERATOR_XOR; op++) {
+            plutovg_surface_t* expected = plutovg_surface_create_with_format(WIDTH, HEIGHT, format);
+            plutovg_surface_t* actual = plutovg_surface_create_with_format(WIDTH, HEIGHT, format);
+            draw(expected, texture, paint, op, PLUTOVG_BLEND_BACKEND_INTEGER);
+            draw(actual, texture, paint, op, PLUTOVG_BLEND_BACKEND_PIPELINE);
+            int difference = max_difference(expected, actual);
+            if(difference > tolerance)
+                fprintf(stderr, "format %d, paint %d, operator %d: backends differ by %d\n", format, paint, op, difference);
+            CHECK(difference <= tolerance);
+            plutovg_surface_destroy(actual);
+            plutovg_surface_destroy(expected);
+        }
+    }
+}
+
+int main(void)
+{
+    plutovg_surface_t* texture = plutovg_surface_create(24, 20);
+    plutovg_canvas_t* canvas = plutovg_canvas_create(texture);
+    plutovg_canvas_set_rgba(canvas, 0.1f, 0.6f, 0.3f, 0.7f);
+    plutovg_canvas_paint(canvas);
+    plutovg_canvas_set_rgb(canvas, 0.9f, 0.2f, 0.4f);
+    plutovg_canvas_circle(canvas, 12, 10, 7);
+    plutovg_canvas_fill(canvas);
+    plutovg_canvas_destroy(canvas);
+
+    CHECK(plutovg_get_blend_backend() == PLUTOVG_BLEND_BACKEND_INTEGER);
+    check_backends(PLUTOVG_FORMAT_ARGB32, texture);
+    check_backends(PLUTOVG_FORMAT_XRGB32, texture);
+    check_backends(PLUTOVG_FORMAT_A8, texture);
+    check_backends(PLUTOVG_FORMAT_RGB565, texture);
+
+    plutovg_surface_destroy(texture);
+    return TEST_RESULT();
+}
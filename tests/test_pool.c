@@ -0,0 +1,96 @@
+#include "test.h"
+
+#include <string.h>
+
+#define SURFACE_BYTES(width, height) ((size_t)(width) * (height) * 4)
+
+static bool is_clear(const plutovg_surface_t* surface)
+{
+    const int width = plutovg_surface_get_width(surface);
+    const int height = plutovg_surface_get_height(surface);
+    for(int y = 0; y < height; y++) {
+        const unsigned int* row = (const unsigned int*)(plutovg_surface_get_data(surface) + y * plutovg_surface_get_stride(surface));
+        for(int x = 0; x < width; x++) {
+            if(row[x]) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static void check_reuse(void)
+{
+    plutovg_surface_pool_t* pool = plutovg_surface_pool_create(SURFACE_BYTES(64, 64) * 4);
+    CHECK(plutovg_surface_pool_get_size(pool) == 0);
+
+    plutovg_surface_t* surface = plutovg_surface_pool_acquire(pool, 64, 64, PLUTOVG_FORMAT_ARGB32, true);
+    CHECK(surface != NULL);
+    CHECK(is_clear(surface));
+    const unsigned char* data = plutovg_surface_get_data(surface);
+    memset(plutovg_surface_get_data(surface), 0xab, SURFACE_BYTES(64, 64));
+    plutovg_surface_pool_release(pool, surface);
+    CHECK(plutovg_surface_pool_get_size(pool) >= SURFACE_BYTES(64, 64));
+
+    /* A different size or format does not take the idle surface. */
+    plutovg_surface_t* other = plutovg_surface_pool_acquire(pool, 64, 32, PLUTOVG_FORMAT_ARGB32, false);
+    CHECK(plutovg_surface_get_data(other) != data);
+    plutovg_surface_destroy(other);
+    other = plutovg_surface_pool_acquire(pool, 64, 64, PLUTOVG_FORMAT_XRGB32, false);
+    CHECK(plutovg_surface_get_data(other) != data);
+    plutovg_surface_destroy(other);
+
+    /* The same size and format reuses the pixel memory, cleared on request. */
+    surface = plutovg_surface_pool_acquire(pool, 64, 64, PLUTOVG_FORMAT_ARGB32, true);
+    CHECK(plutovg_surface_get_data(surface) == data);
+    CHECK(plutovg_surface_pool_get_size(pool) == 0);
+    CHECK(is_clear(surface));
+
+    /* A surface still referenced elsewhere is not kept. */
+    plutovg_surface_reference(surface);
+    plutovg_surface_pool_release(pool, surface);
+    CHECK(plutovg_surface_pool_get_size(pool) == 0);
+    CHECK(plutovg_surface_get_reference_count(surface) == 1);
+    plutovg_surface_destroy(surface);
+
+    plutovg_surface_pool_destroy(pool);
+}
+
+static void check_limit(void)
+{
+    const size_t size = SURFACE_BYTES(32, 32);
+    plutovg_surface_pool_t* pool = plutovg_surface_pool_create(size * 2);
+    CHECK(plutovg_surface_pool_get_limit(pool) == size * 2);
+
+    plutovg_surface_t* surfaces[3];
+    for(int i = 0; i < 3; i++)
+        surfaces[i] = plutovg_surface_pool_acquire(pool, 32, 32, PLUTOVG_FORMAT_ARGB32, false);
+    const unsigned char* newest = plutovg_surface_get_data(surfaces[2]);
+    for(int i = 0; i < 3; i++)
+        plutovg_surface_pool_release(pool, surfaces[i]);
+    CHECK(plutovg_surface_pool_get_size(pool) <= size * 2);
+
+    /* The least recently released surface is dropped first. */
+    plutovg_surface_pool_set_limit(pool, size);
+    CHECK(plutovg_surface_pool_get_size(pool) <= size);
+    plutovg_surface_t* surface = plutovg_surface_pool_acquire(pool, 32, 32, PLUTOVG_FORMAT_ARGB32, false);
+    CHECK(plutovg_surface_get_data(surface) == newest);
+    plutovg_surface_pool_release(pool, surface);
+
+    plutovg_surface_pool_trim(pool, 0);
+    CHECK(plutovg_surface_pool_get_size(pool) == 0);
+
+    /* Surfaces outlive the pool they were acquired from. */
+    surface = plutovg_surface_pool_acquire(pool, 32, 32, PLUTOVG_FORMAT_ARGB32, true);
+    plutovg_surface_pool_destroy(pool);
+    CHECK(is_clear(surface));
+    plutovg_surface_destroy(surface);
+}
+
+int main(void)
+{
+    check_reuse();
+    check_limit();
+    return TEST_RESULT();
+}
@@ -0,0 +1,102 @@
+#include "test.h"
+
+#include <string.h>
+
+#define SIZE 4
+
+static unsigned int pixel_at(const plutovg_surface_t* surface, int x, int y)
+{
+    return ((const unsigned int*)(plutovg_surface_get_data(surface) + y * plutovg_surface_get_stride(surface)))[x];
+}
+
+static void fill_pixels(unsigned char* data, int stride, int width, int height, unsigned int value)
+{
+    for(int y = 0; y < height; y++) {
+        unsigned int* row = (unsigned int*)(data + y * stride);
+        for(int x = 0; x < width; x++) {
+            row[x] = value;
+        }
+    }
+}
+
+/* Paints `paint` over an opaque red surface and returns the top-left pixel. */
+static unsigned int paint_over_red(plutovg_paint_t* paint)
+{
+    plutovg_surface_t* surface = plutovg_surface_create(SIZE, SIZE);
+    plutovg_canvas_t* canvas = plutovg_canvas_create(surface);
+    plutovg_canvas_set_rgb(canvas, 1, 0, 0);
+    plutovg_canvas_paint(canvas);
+    plutovg_canvas_set_paint(canvas, paint);
+    plutovg_canvas_paint(canvas);
+    plutovg_canvas_destroy(canvas);
+    unsigned int pixel = pixel_at(surface, 0, 0);
+    plutovg_surface_destroy(surface);
+    return pixel;
+}
+
+/*
+ * An opaque clear marks the surface opaque, which turns SRC_OVER into a copy. Writing
+ * translucent pixels through plutovg_surface_get_data() must not keep that shortcut,
+ * whether or not plutovg_surface_mark_dirty() is called, nor must writes to the buffer
+ * of a surface created for caller data.
+ */
+static void check_opaque_after_write(void)
+{
+    static const plutovg_color_t white = {1.f, 1.f, 1.f, 1.f};
+
+    plutovg_surface_t* texture = plutovg_surface_create(SIZE, SIZE);
+    plutovg_paint_t* paint = plutovg_paint_create_texture(texture, PLUTOVG_TEXTURE_TYPE_PLAIN, 1.f, NULL);
+    plutovg_surface_clear(texture, &white);
+    CHECK(paint_over_red(paint) == 0xffffffff);
+    fill_pixels(plutovg_surface_get_data(texture), plutovg_surface_get_stride(texture), SIZE, SIZE, 0x80000080);
+    CHECK(paint_over_red(paint) == 0xff7f0080);
+    plutovg_surface_mark_dirty(texture);
+    CHECK(paint_over_red(paint) == 0xff7f0080);
+    plutovg_paint_destroy(paint);
+    plutovg_surface_destroy(texture);
+
+    unsigned int data[SIZE * SIZE];
+    texture = plutovg_surface_create_for_data((unsigned char*)data, SIZE, SIZE, SIZE * 4);
+    paint = plutovg_paint_create_texture(texture, PLUTOVG_TEXTURE_TYPE_PLAIN, 1.f, NULL);
+    plutovg_surface_clear(texture, &white);
+    CHECK(paint_over_red(paint) == 0xffffffff);
+    fill_pixels((unsigned char*)data, SIZE * 4, SIZE, SIZE, 0x80000080);
+    CHECK(paint_over_red(paint) == 0xff7f0080);
+    plutovg_paint_destroy(paint);
+    plutovg_surface_destroy(texture);
+}
+
+/*
+ * Small tiled textures are blitted from a cache of repeated rows. Rewriting the pixels
+ * directly, through plutovg_surface_get_data() or a caller-owned buffer, must show up the
+ * next time the same paint is used, even without plutovg_surface_mark_dirty().
+ */
+static void check_tiles_after_write(void)
+{
+    plutovg_surface_t* texture = plutovg_surface_create(8, 8);
+    plutovg_paint_t* paint = plutovg_paint_create_texture(texture, PLUTOVG_TEXTURE_TYPE_TILED, 1.f, NULL);
+    fill_pixels(plutovg_surface_get_data(texture), plutovg_surface_get_stride(texture), 8, 8, 0xff00ff00);
+    plutovg_surface_mark_dirty(texture);
+    CHECK(paint_over_red(paint) == 0xff00ff00);
+    fill_pixels(plutovg_surface_get_data(texture), plutovg_surface_get_stride(texture), 8, 8, 0xff0000ff);
+    CHECK(paint_over_red(paint) == 0xff0000ff);
+    plutovg_paint_destroy(paint);
+    plutovg_surface_destroy(texture);
+
+    unsigned int data[8 * 8];
+    fill_pixels((unsigned char*)data, 8 * 4, 8, 8, 0xff00ff00);
+    texture = plutovg_surface_create_for_data((unsigned char*)data, 8, 8, 8 * 4);
+    paint = plutovg_paint_create_texture(texture, PLUTOVG_TEXTURE_TYPE_TILED, 1.f, NULL);
+    CHECK(paint_over_red(paint) == 0xff00ff00);
+    fill_pixels((unsigned char*)data, 8 * 4, 8, 8, 0xff0000ff);
+    CHECK(paint_over_red(paint) == 0xff0000ff);
+    plutovg_paint_destroy(paint);
+    plutovg_surface_destroy(texture);
+}
+
+int main(void)
+{
+    check_opaque_after_write();
+    check_tiles_after_write();
+    return TEST_RESULT();
+}
@@ -0,0 +1,78 @@
+#include "test.h"
+
+#define WIDE_WIDTH 40000
+#define WIDE_HEIGHT 16
+#define REGION_X 37000
+#define REGION_WIDTH 256
+
+static int max_difference(const plutovg_surface_t* a, const plutovg_surface_t* b, int x1, int y1, int x2, int y2)
+{
+    int difference = 0;
+    for(int y = y1; y < y2; y++) {
+        const unsigned char* row_a = plutovg_surface_get_data(a) + y * plutovg_surface_get_stride(a);
+        const unsigned char* row_b = plutovg_surface_get_data(b) + y * plutovg_surface_get_stride(b);
+        for(int x = x1 * 4; x < x2 * 4; x++) {
+            int d = abs(row_a[x] - row_b[x]);
+            if(d > difference) {
+                difference = d;
+            }
+        }
+    }
+
+    return difference;
+}
+
+static void draw(plutovg_surface_t* target, plutovg_surface_t* texture, plutovg_texture_type_t type, float offset, float angle)
+{
+    plutovg_canvas_t* canvas = plutovg_canvas_create(target);
+    plutovg_canvas_translate(canvas, 10, 10);
+    plutovg_canvas_rotate(canvas, angle);
+    plutovg_canvas_scale(canvas, 1.5f, 1.5f);
+    plutovg_matrix_t matrix;
+    plutovg_matrix_init_translate(&matrix, offset, 0);
+    plutovg_canvas_set_texture(canvas, texture, type, 1.f, &matrix);
+    plutovg_canvas_rect(canvas, 0, 0, REGION_WIDTH, WIDE_HEIGHT);
+    plutovg_canvas_fill(canvas);
+    plutovg_canvas_destroy(canvas);
+}
+
+/*
+ * Textures at least 32768 pixels wide are sampled by a separate 64-bit fetcher. Drawing a
+ * region of such a texture must match drawing a view of just that region, away from the
+ * left and right edges where the view fades out but the whole texture does not.
+ */
+static void check_wide_texture(float angle)
+{
+    plutovg_surface_t* wide = plutovg_surface_create(WIDE_WIDTH, WIDE_HEIGHT);
+    fill_pattern(wide);
+    plutovg_surface_t* region = plutovg_surface_create_sub(wide, REGION_X, 0, REGION_WIDTH, WIDE_HEIGHT);
+
+    plutovg_surface_t* expected = plutovg_surface_create(420, 160);
+    plutovg_surface_t* actual = plutovg_surface_create(420, 160);
+    draw(expected, region, PLUTOVG_TEXTURE_TYPE_PLAIN, 0, angle);
+    draw(actual, wide, PLUTOVG_TEXTURE_TYPE_PLAIN, -REGION_X, angle);
+    CHECK(max_difference(expected, actual, 14, 0, 370, 160) <= 2);
+
+    /*
+     * Tiled textures wrap around instead of fading out at the top and bottom edges, so
+     * they only match the plain draw when sampled without filtering.
+     */
+    if(angle == 0.f) {
+        plutovg_surface_t* tiled = plutovg_surface_create(420, 160);
+        draw(tiled, wide, PLUTOVG_TEXTURE_TYPE_TILED, -REGION_X - WIDE_WIDTH * 3.f, angle);
+        CHECK(max_difference(actual, tiled, 0, 0, 420, 160) == 0);
+        plutovg_surface_destroy(tiled);
+    }
+
+    plutovg_surface_destroy(actual);
+    plutovg_surface_destroy(expected);
+    plutovg_surface_destroy(region);
+    plutovg_surface_destroy(wide);
+}
+
+int main(void)
+{
+    check_wide_texture(0.f);
+    check_wide_texture(0.25f);
+    return TEST_RESULT();
+}
@@ -0,0 +1,120 @@
+#include "test.h"
+
+#include <string.h>
+
+#define WIDTH 200
+#define HEIGHT 150
+#define VIEW_X 37
+#define VIEW_Y 21
+#define VIEW_WIDTH 90
+#define VIEW_HEIGHT 70
+
+/* Compares `height` rows of `width` pixels starting at the given addresses. */
+static bool same_rows(const unsigned char* a, int stride_a, const unsigned char* b, int stride_b, int width, int height)
+{
+    for(int y = 0; y < height; y++) {
+        if(memcmp(a + y * stride_a, b + y * stride_b, width * 4)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void draw(plutovg_canvas_t* canvas)
+{
+    static const plutovg_gradient_stop_t stops[] = {
+        {0.f, {1.f, 0.f, 0.f, 0.8f}},
+        {1.f, {0.f, 0.f, 1.f, 0.4f}}
+    };
+
+    plutovg_canvas_set_linear_gradient(canvas, 0, 0, 120, 40, PLUTOVG_SPREAD_METHOD_REFLECT, stops, 2, NULL);
+    plutovg_canvas_circle(canvas, 40, 30, 55);
+    plutovg_canvas_fill(canvas);
+    plutovg_canvas_set_rgba(canvas, 0.1f, 0.8f, 0.3f, 0.7f);
+    plutovg_canvas_set_line_width(canvas, 6);
+    plutovg_canvas_move_to(canvas, -20, 60);
+    plutovg_canvas_line_to(canvas, 130, 5);
+    plutovg_canvas_stroke(canvas);
+}
+
+/*
+ * A view aliases the parent's pixels: it starts at the region's address with the parent's
+ * stride, drawing into it matches drawing into a standalone surface holding the same pixels,
+ * and the parent outside the region is left untouched.
+ */
+static void check_aliasing(void)
+{
+    plutovg_surface_t* parent = plutovg_surface_create(WIDTH, HEIGHT);
+    fill_pattern(parent);
+    plutovg_surface_t* original = plutovg_surface_create(WIDTH, HEIGHT);
+    fill_pattern(original);
+
+    plutovg_surface_t* view = plutovg_surface_create_sub(parent, VIEW_X, VIEW_Y, VIEW_WIDTH, VIEW_HEIGHT);
+    CHECK(view != NULL);
+    CHECK(plutovg_surface_get_width(view) == VIEW_WIDTH);
+    CHECK(plutovg_surface_get_height(view) == VIEW_HEIGHT);
+    CHECK(plutovg_surface_get_stride(view) == plutovg_surface_get_stride(parent));
+    CHECK(plutovg_surface_get_data(view) == plutovg_surface_get_data(parent) + VIEW_Y * plutovg_surface_get_stride(parent) + VIEW_X * 4);
+
+    const int stride = plutovg_surface_get_stride(parent);
+    plutovg_surface_t* expected = plutovg_surface_create(VIEW_WIDTH, VIEW_HEIGHT);
+    for(int y = 0; y < VIEW_HEIGHT; y++)
+        memcpy(plutovg_surface_get_data(expected) + y * plutovg_surface_get_stride(expected), plutovg_surface_get_data(view) + y * stride, VIEW_WIDTH * 4);
+    plutovg_surface_mark_dirty(expected);
+
+    plutovg_canvas_t* canvas = plutovg_canvas_create(expected);
+    draw(canvas);
+    plutovg_canvas_destroy(canvas);
+
+    canvas = plutovg_canvas_create(view);
+    draw(canvas);
+    plutovg_canvas_destroy(canvas);
+    plutovg_surface_mark_dirty(parent);
+
+    const unsigned char* parent_data = plutovg_surface_get_data(parent);
+    const unsigned char* original_data = plutovg_surface_get_data(original);
+    CHECK(same_rows(plutovg_surface_get_data(view), stride, plutovg_surface_get_data(expected), plutovg_surface_get_stride(expected), VIEW_WIDTH, VIEW_HEIGHT));
+    CHECK(same_rows(parent_data, stride, original_data, stride, WIDTH, VIEW_Y));
+    CHECK(same_rows(parent_data + (VIEW_Y + VIEW_HEIGHT) * stride, stride, original_data + (VIEW_Y + VIEW_HEIGHT) * stride, stride, WIDTH, HEIGHT - VIEW_Y - VIEW_HEIGHT));
+    CHECK(same_rows(parent_data + VIEW_Y * stride, stride, original_data + VIEW_Y * stride, stride, VIEW_X, VIEW_HEIGHT));
+    CHECK(same_rows(parent_data + VIEW_Y * stride + (VIEW_X + VIEW_WIDTH) * 4, stride, original_data + VIEW_Y * stride + (VIEW_X + VIEW_WIDTH) * 4, stride, WIDTH - VIEW_X - VIEW_WIDTH, VIEW_HEIGHT));
+
+    /*
+     * The view keeps the parent alive, so its pixels stay valid after the parent's own
+     * reference is released.
+     */
+    CHECK(plutovg_surface_get_reference_count(parent) == 2);
+    plutovg_surface_destroy(parent);
+    CHECK(same_rows(plutovg_surface_get_data(view), stride, plutovg_surface_get_data(expected), plutovg_surface_get_stride(expected), VIEW_WIDTH, VIEW_HEIGHT));
+
+    plutovg_surface_destroy(view);
+    plutovg_surface_destroy(expected);
+    plutovg_surface_destroy(original);
+}
+
+static void check_bounds(void)
+{
+    plutovg_surface_t* parent = plutovg_surface_create(WIDTH, HEIGHT);
+    CHECK(plutovg_surface_create_sub(parent, -1, 0, 10, 10) == NULL);
+    CHECK(plutovg_surface_create_sub(parent, WIDTH - 9, 0, 10, 10) == NULL);
+    CHECK(plutovg_surface_create_sub(parent, 0, HEIGHT - 9, 10, 10) == NULL);
+    CHECK(plutovg_surface_create_sub(parent, 0, 0, 0, 10) == NULL);
+
+    plutovg_surface_t* view = plutovg_surface_create_sub(parent, 10, 10, 50, 50);
+    plutovg_surface_t* nested = plutovg_surface_create_sub(view, 5, 7, 20, 20);
+    CHECK(nested != NULL);
+    CHECK(plutovg_surface_get_data(nested) == plutovg_surface_get_data(parent) + 17 * plutovg_surface_get_stride(parent) + 15 * 4);
+    CHECK(plutovg_surface_create_sub(view, 40, 0, 20, 20) == NULL);
+
+    plutovg_surface_destroy(nested);
+    plutovg_surface_destroy(view);
+    plutovg_surface_destroy(parent);
+}
+
+int main(void)
+{
+    check_aliasing();
+    check_bounds();
+    return TEST_RESULT();
+}
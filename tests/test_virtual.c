@@ -0,0 +1,84 @@
+#include "test.h"
+
+#include <string.h>
+
+#define VIRTUAL_WIDTH 40000
+#define VIRTUAL_HEIGHT 30000
+#define REGION_X 36000
+#define REGION_Y 27000
+#define REGION_SIZE 200
+
+static void draw(plutovg_canvas_t* canvas)
+{
+    static const plutovg_gradient_stop_t stops[] = {
+        {0.f, {0.9f, 0.1f, 0.2f, 1.f}},
+        {1.f, {0.1f, 0.4f, 0.9f, 0.6f}}
+    };
+
+    plutovg_canvas_set_radial_gradient(canvas, 100, 100, 90, 70, 60, 0, PLUTOVG_SPREAD_METHOD_PAD, stops, 2, NULL);
+    plutovg_canvas_circle(canvas, 100, 100, 80);
+    plutovg_canvas_fill(canvas);
+    plutovg_canvas_set_rgba(canvas, 0.f, 0.6f, 0.2f, 0.8f);
+    plutovg_canvas_set_line_width(canvas, 4);
+    plutovg_canvas_rect(canvas, 20.5f, 30.5f, 150, 120);
+    plutovg_canvas_stroke(canvas);
+}
+
+static bool region_equals(const plutovg_surface_t* surface, int x, int y, const plutovg_surface_t* expected)
+{
+    const int stride = plutovg_surface_get_stride(surface);
+    for(int row = 0; row < REGION_SIZE; row++) {
+        const unsigned char* a = plutovg_surface_get_data(surface) + (size_t)(y + row) * stride + (size_t)x * 4;
+        const unsigned char* b = plutovg_surface_get_data(expected) + row * plutovg_surface_get_stride(expected);
+        if(memcmp(a, b, REGION_SIZE * 4)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * A virtual surface larger than 32767 pixels in each direction starts out transparent and
+ * renders far from the origin exactly like a small regular surface does.
+ */
+static void check_virtual(void)
+{
+    plutovg_surface_t* surface = plutovg_surface_create_virtual(VIRTUAL_WIDTH, VIRTUAL_HEIGHT, PLUTOVG_FORMAT_ARGB32);
+    if(surface == NULL) {
+        fprintf(stderr, "virtual surfaces are not supported, skipping\n");
+        return;
+    }
+
+    CHECK(plutovg_surface_get_width(surface) == VIRTUAL_WIDTH);
+    CHECK(plutovg_surface_get_height(surface) == VIRTUAL_HEIGHT);
+
+    plutovg_surface_t* expected = plutovg_surface_create(REGION_SIZE, REGION_SIZE);
+    CHECK(region_equals(surface, REGION_X, REGION_Y, expected));
+
+    plutovg_canvas_t* canvas = plutovg_canvas_create(expected);
+    draw(canvas);
+    plutovg_canvas_destroy(canvas);
+
+    canvas = plutovg_canvas_create(surface);
+    plutovg_canvas_translate(canvas, REGION_X, REGION_Y);
+    draw(canvas);
+    plutovg_canvas_destroy(canvas);
+    CHECK(region_equals(surface, REGION_X, REGION_Y, expected));
+
+    /* Clearing to transparent leaves every pixel zero again. */
+    static const plutovg_color_t transparent = {0.f, 0.f, 0.f, 0.f};
+    plutovg_surface_clear(surface, &transparent);
+    plutovg_surface_t* empty = plutovg_surface_create(REGION_SIZE, REGION_SIZE);
+    CHECK(region_equals(surface, REGION_X, REGION_Y, empty));
+
+    plutovg_surface_destroy(empty);
+    plutovg_surface_destroy(expected);
+    plutovg_surface_destroy(surface);
+}
+
+int main(void)
+{
+    check_virtual();
+    return TEST_RESULT();
+}